@@ -10,7 +10,7 @@ mode="${1:-debug}"
 rm -rf "$build"
 mkdir -p "$build"
 
-CFLAGS="-std=c11"
+CFLAGS="-std=c11 -pthread"
 
 case "$mode" in
     debug)
@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+# ~geb: generates src/base_unicode_tables.c from the unicodedata
+#       module of the running python. Rerun after a python upgrade
+#       to pick up a new Unicode version:
+#
+#           python3 scripts/gen_unicode_tables.py > src/base_unicode_tables.c
+
+import sys
+import unicodedata
+
+# ~geb: must match Unicode_Category in base.h
+CATEGORIES = [
+    'Cn', 'Lu', 'Ll', 'Lt', 'Lm', 'Lo', 'Mn', 'Mc', 'Me', 'Nd',
+    'Nl', 'No', 'Pc', 'Pd', 'Ps', 'Pe', 'Pi', 'Pf', 'Po', 'Sm',
+    'Sc', 'Sk', 'So', 'Zs', 'Zl', 'Zp', 'Cc', 'Cf', 'Cs', 'Co',
+]
+
+# ~geb: PropList.txt White_Space, not exposed by unicodedata
+WHITE_SPACE = set([
+    *range(0x0009, 0x000d + 1), 0x0020, 0x0085, 0x00a0, 0x1680,
+    *range(0x2000, 0x200a + 1), 0x2028, 0x2029, 0x202f, 0x205f, 0x3000,
+])
+
+PROP_SPACE        = 1 << 5
+PROP_XID_START    = 1 << 6
+PROP_XID_CONTINUE = 1 << 7
+
+# ~geb: must match Rune_Class in base.h, the top three bits line up
+#       with the PROP_ bits above
+CLASS_LETTER = 1 << 0
+CLASS_DIGIT  = 1 << 1
+CLASS_UPPER  = 1 << 2
+CLASS_LOWER  = 1 << 3
+CLASS_PUNCT  = 1 << 4
+
+
+def category_class(category):
+    value = 0
+    if category[0] == 'L':
+        value |= CLASS_LETTER
+    if category == 'Nd':
+        value |= CLASS_DIGIT
+    if category == 'Lu':
+        value |= CLASS_UPPER
+    if category == 'Ll':
+        value |= CLASS_LOWER
+    if category[0] == 'P':
+        value |= CLASS_PUNCT
+    return value
+
+RUNE_COUNT = 0x110000
+
+
+def properties():
+    props = []
+    for cp in range(RUNE_COUNT):
+        c = chr(cp)
+        value = CATEGORIES.index(unicodedata.category(c))
+        if cp in WHITE_SPACE:
+            value |= PROP_SPACE
+        # str.isidentifier checks XID_Start (plus '_') for the first
+        # character and XID_Continue for the rest
+        if c.isidentifier() and c != '_':
+            value |= PROP_XID_START
+        if ('a' + c).isidentifier():
+            value |= PROP_XID_CONTINUE
+        props.append(value)
+    return props
+
+
+def simple_fold(cp):
+    # ~geb: simple case folding (CaseFolding.txt status C and S).
+    #       casefold() is the full folding, where it expands to several
+    #       runes the single rune lowercase mapping is the S entry.
+    c = chr(cp)
+    folded = c.casefold()
+    if len(folded) == 1:
+        return ord(folded)
+    lower = c.lower()
+    if len(lower) == 1:
+        return ord(lower)
+    return cp
+
+
+def two_stage(values, shift):
+    size = 1 << shift
+    blocks = {}
+    stage1 = []
+    for i in range(0, len(values), size):
+        block = tuple(values[i:i + size])
+        stage1.append(blocks.setdefault(block, len(blocks)))
+    stage2 = [v for block in blocks for v in block]
+    return stage1, stage2, blocks
+
+
+def emit_array(out, ctype, name, values, per_line, fmt):
+    out.write('global const %s %s[%d] = {\n' % (ctype, name, len(values)))
+    for i in range(0, len(values), per_line):
+        out.write('\t' + ' '.join(fmt % v + ',' for v in values[i:i + per_line]) + '\n')
+    out.write('};\n\n')
+
+
+def main():
+    out = sys.stdout
+    shift = 7
+
+    props = properties()
+    stage1, stage2, blocks = two_stage(props, shift)
+    assert len(blocks) <= 256
+
+    # ~geb: one extra entry so runes past Rune_Max clamp onto Cn
+    empty = blocks[tuple([0] * (1 << shift))]
+    stage1.append(empty)
+
+    out.write('// ~geb: generated by scripts/gen_unicode_tables.py, do not edit.\n')
+    out.write('//       Unicode %s\n\n' % unicodedata.unidata_version)
+    out.write('#define UNICODE_PROP_SHIFT %d\n' % shift)
+    out.write('#define UNICODE_PROP_BLOCK %d\n\n' % (1 << shift))
+    out.write('// ~geb: low five bits Unicode_Category, then White_Space,\n')
+    out.write('//       XID_Start and XID_Continue\n')
+    emit_array(out, 'u8', 'UNICODE_PROP_STAGE1', stage1, 16, '0x%02x')
+    emit_array(out, 'u8', 'UNICODE_PROP_STAGE2', stage2, 16, '0x%02x')
+
+    category_classes = [category_class(c) for c in CATEGORIES]
+    category_classes += [0] * (32 - len(category_classes))
+    out.write('// ~geb: Rune_Class bits implied by each Unicode_Category\n')
+    emit_array(out, 'Rune_Class', 'UNICODE_CATEGORY_CLASS', category_classes, 16, '0x%02x')
+
+    ascii_classes = [category_classes[p & 31] | (p & 0xe0) for p in props[:128]]
+    emit_array(out, 'Rune_Class', 'UNICODE_ASCII_CLASS', ascii_classes, 16, '0x%02x')
+
+    # ~geb: case folding, stage 2 indexes a small table of deltas
+    fold_shift = 6
+    deltas = [simple_fold(cp) - cp for cp in range(RUNE_COUNT)]
+    limit = max(cp for cp in range(RUNE_COUNT) if deltas[cp]) + 1
+    limit = (limit + (1 << fold_shift) - 1) & ~((1 << fold_shift) - 1)
+
+    delta_values = [0] + sorted(set(deltas) - {0})
+    assert len(delta_values) <= 256
+    delta_index = {v: i for i, v in enumerate(delta_values)}
+
+    fold_stage1, fold_stage2, fold_blocks = two_stage([delta_index[v] for v in deltas[:limit]], fold_shift)
+    assert len(fold_blocks) <= 256
+    fold_stage1.append(fold_blocks[tuple([0] * (1 << fold_shift))])
+
+    out.write('#define UNICODE_FOLD_SHIFT %d\n' % fold_shift)
+    out.write('#define UNICODE_FOLD_BLOCK %d\n' % (1 << fold_shift))
+    out.write('#define UNICODE_FOLD_LIMIT 0x%x // no rune at or above folds\n\n' % limit)
+    emit_array(out, 'u8', 'UNICODE_FOLD_STAGE1', fold_stage1, 16, '0x%02x')
+    emit_array(out, 'u8', 'UNICODE_FOLD_STAGE2', fold_stage2, 16, '0x%02x')
+    emit_array(out, 'i32', 'UNICODE_FOLD_DELTA', delta_values, 8, '%d')
+
+
+if __name__ == '__main__':
+    main()
@@ -11,20 +11,323 @@
 #endif
 
 internal OS_Time_Duration
-os_time_diff(OS_Time_Stamp start, OS_Time_Stamp end)
+os_time_duration(u64 ticks, u64 frequency)
 {
 	OS_Time_Duration result = {0};
 
-	u64 freq    = os_time_frequency();
-	u64 elapsed = end - start;
-
-	result.seconds      = (f64)elapsed / (f64)freq;
+	result.seconds      = (f64)ticks / (f64)frequency;
 	result.milliseconds = result.seconds * 1000.0;
 	result.microseconds = result.seconds * 1000000.0;
 
 	return result;
 }
 
+internal OS_Time_Duration
+os_time_diff(OS_Time_Stamp start, OS_Time_Stamp end)
+{
+	return os_time_duration(end - start, os_time_frequency());
+}
+
+internal String8
+os_perf_counter_name(OS_Perf_Counter counter)
+{
+	switch (counter)
+	{
+	case OS_Perf_Cycles:          return S("cycles");
+	case OS_Perf_Instructions:    return S("instructions");
+	case OS_Perf_CacheReferences: return S("cache_references");
+	case OS_Perf_CacheMisses:     return S("cache_misses");
+	case OS_Perf_BranchMisses:    return S("branch_misses");
+	case OS_Perf_PageFaults:      return S("page_faults");
+	default:                      return S("");
+	}
+}
+
+internal u64
+os_wait_until_ns(OS_Time_Stamp deadline, u64 spin_ns, OS_Wait_Stats *stats)
+{
+	OS_Time_Stamp now = os_time_now();
+	if (now + spin_ns < deadline)
+	{
+		OS_Time_Stamp target = deadline - spin_ns;
+		os_sleep_until_ns(target);
+		now = os_time_now();
+		if (stats && now > target)
+			stats->sleep_late_max_ns = Max(stats->sleep_late_max_ns, now - target);
+	}
+
+	OS_Time_Stamp spin_begin = now;
+	while (now < deadline)
+	{
+		CpuPause();
+		now = os_time_now();
+	}
+
+	u64 late = now - deadline;
+
+	if (stats)
+	{
+		stats->waits         += 1;
+		stats->late_total_ns += late;
+		stats->late_max_ns    = Max(stats->late_max_ns, late);
+		stats->spin_total_ns += now - spin_begin;
+	}
+
+	return late;
+}
+
+// ~geb: synchronization
+
+#define OS_MUTEX_SPIN 64
+
+internal bool
+os_mutex_try_lock(OS_Mutex *mutex)
+{
+	return AtomicCompareExchangeU32(&mutex->state, 0, 1) == 0;
+}
+
+internal void
+os_mutex_lock(OS_Mutex *mutex)
+{
+	u32 state = AtomicCompareExchangeU32(&mutex->state, 0, 1);
+	if (state == 0)
+		return;
+
+	// ~geb: short holds are usually over before a syscall would be
+	for (u32 i = 0; i < OS_MUTEX_SPIN && state == 1; ++i)
+	{
+		CpuPause();
+		state = AtomicLoadU32(&mutex->state);
+		if (state == 0 && (state = AtomicCompareExchangeU32(&mutex->state, 0, 1)) == 0)
+			return;
+	}
+
+	// ~geb: from here on we may be a waiter, so take it as 2 and let
+	//       the unlock that follows ours wake the next one
+	while (AtomicExchangeU32(&mutex->state, 2) != 0)
+		os_futex_wait(&mutex->state, 2, OS_WAIT_INFINITE);
+}
+
+internal void
+os_mutex_unlock(OS_Mutex *mutex)
+{
+	if (AtomicExchangeU32(&mutex->state, 0) == 2)
+		os_futex_wake(&mutex->state, 1);
+}
+
+internal bool
+os_cond_wait(OS_Cond *cond, OS_Mutex *mutex, u64 timeout_ns)
+{
+	u32 seq = AtomicLoadU32(&cond->seq);
+	os_mutex_unlock(mutex);
+	bool woken = os_futex_wait(&cond->seq, seq, timeout_ns);
+
+	// ~geb: a broadcast wakes everyone at once, take the lock as
+	//       contended so none of them is left asleep on it
+	while (AtomicExchangeU32(&mutex->state, 2) != 0)
+		os_futex_wait(&mutex->state, 2, OS_WAIT_INFINITE);
+	return woken;
+}
+
+internal void
+os_cond_signal(OS_Cond *cond)
+{
+	AtomicAddU32(&cond->seq, 1);
+	os_futex_wake(&cond->seq, 1);
+}
+
+internal void
+os_cond_broadcast(OS_Cond *cond)
+{
+	AtomicAddU32(&cond->seq, 1);
+	os_futex_wake(&cond->seq, OS_FUTEX_WAKE_ALL);
+}
+
+internal bool
+os_semaphore_try_wait(OS_Semaphore *sem)
+{
+	u32 count = AtomicLoadU32(&sem->count);
+	while (count)
+	{
+		u32 seen = AtomicCompareExchangeU32(&sem->count, count, count - 1);
+		if (seen == count)
+			return true;
+		count = seen;
+	}
+	return false;
+}
+
+internal bool
+os_semaphore_wait(OS_Semaphore *sem, u64 timeout_ns)
+{
+	OS_Time_Stamp deadline = timeout_ns == OS_WAIT_INFINITE ? 0 : os_time_now() + timeout_ns;
+	for (;;)
+	{
+		if (os_semaphore_try_wait(sem))
+			return true;
+
+		u64 remaining = OS_WAIT_INFINITE;
+		if (deadline)
+		{
+			OS_Time_Stamp now = os_time_now();
+			if (now >= deadline)
+				return false;
+			remaining = deadline - now;
+		}
+
+		AtomicAddU32(&sem->waiters, 1);
+		os_futex_wait(&sem->count, 0, remaining);
+		AtomicAddU32(&sem->waiters, -1);
+	}
+}
+
+internal void
+os_semaphore_post(OS_Semaphore *sem, u32 count)
+{
+	AtomicAddU32(&sem->count, count);
+	if (AtomicLoadU32(&sem->waiters))
+		os_futex_wake(&sem->count, count);
+}
+
+internal bool
+os_event_is_set(OS_Event *event)
+{
+	return AtomicLoadU32(&event->signaled) != 0;
+}
+
+internal bool
+os_event_wait(OS_Event *event, u64 timeout_ns)
+{
+	OS_Time_Stamp deadline = timeout_ns == OS_WAIT_INFINITE ? 0 : os_time_now() + timeout_ns;
+	while (!os_event_is_set(event))
+	{
+		u64 remaining = OS_WAIT_INFINITE;
+		if (deadline)
+		{
+			OS_Time_Stamp now = os_time_now();
+			if (now >= deadline)
+				return false;
+			remaining = deadline - now;
+		}
+		os_futex_wait(&event->signaled, 0, remaining);
+	}
+	return true;
+}
+
+internal void
+os_event_set(OS_Event *event)
+{
+	if (AtomicExchangeU32(&event->signaled, 1) == 0)
+		os_futex_wake(&event->signaled, OS_FUTEX_WAKE_ALL);
+}
+
+internal void
+os_event_reset(OS_Event *event)
+{
+	AtomicStoreU32(&event->signaled, 0);
+}
+
+// ~geb: cycle counter
+
+#define OS_CYCLES_CALIBRATION_NS 5000000ull
+
+global u64 os_cycles_freq;
+global f64 os_cycles_ns_per_cycle;
+
+internal u64
+os_cycles_now(void)
+{
+#if ARCH_X64
+	return __rdtsc();
+#elif ARCH_ARM64 && (COMPILER_CLANG || COMPILER_GCC)
+	u64 value;
+	__asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(value));
+	return value;
+#else
+	return os_time_now();
+#endif
+}
+
+internal u64
+os_cycles_now_serialized(void)
+{
+#if ARCH_X64
+	u32 aux;
+	return __rdtscp(&aux);
+#elif ARCH_ARM64 && (COMPILER_CLANG || COMPILER_GCC)
+	u64 value;
+	__asm__ __volatile__("isb\n\tmrs %0, cntvct_el0" : "=r"(value) : : "memory");
+	return value;
+#else
+	return os_time_now();
+#endif
+}
+
+internal bool
+os_cycles_invariant(void)
+{
+#if ARCH_X64
+	// ~geb: cpuid 0x80000007, edx bit 8
+	u32 regs[4] = {0};
+# if COMPILER_MSVC
+	__cpuid(cast(int *)regs, 0x80000000);
+	if (regs[0] < 0x80000007)
+		return false;
+	__cpuid(cast(int *)regs, 0x80000007);
+# else
+	if (__get_cpuid_max(0x80000000, 0) < 0x80000007)
+		return false;
+	__get_cpuid(0x80000007, &regs[0], &regs[1], &regs[2], &regs[3]);
+# endif
+	return (regs[3] & Bit(8)) != 0;
+#else
+	// ~geb: the arm generic timer and the os clock run at a fixed rate
+	return true;
+#endif
+}
+
+internal u64
+os_cycles_frequency(void)
+{
+	u64 freq = AtomicLoadU64(&os_cycles_freq);
+	if (freq)
+		return freq;
+
+#if ARCH_X64
+	u64 time_begin   = os_time_now();
+	u64 cycles_begin = os_cycles_now_serialized();
+	os_sleep_ns(OS_CYCLES_CALIBRATION_NS);
+	u64 time_end     = os_time_now();
+	u64 cycles_end   = os_cycles_now_serialized();
+
+	u64 elapsed = Max(time_end - time_begin, 1);
+	freq = cast(u64)((f64)(cycles_end - cycles_begin) * (f64)os_time_frequency() / (f64)elapsed);
+#elif ARCH_ARM64 && (COMPILER_CLANG || COMPILER_GCC)
+	__asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(freq));
+#else
+	freq = os_time_frequency();
+#endif
+
+	freq = Max(freq, 1);
+	os_cycles_ns_per_cycle = 1e9 / (f64)freq;
+	AtomicStoreU64(&os_cycles_freq, freq);
+	return freq;
+}
+
+internal f64
+os_cycles_to_ns(u64 cycles)
+{
+	if (!AtomicLoadU64(&os_cycles_freq))
+		os_cycles_frequency();
+	return (f64)cycles * os_cycles_ns_per_cycle;
+}
+
+internal OS_Time_Duration
+os_cycles_diff(u64 start, u64 end)
+{
+	return os_time_duration(end - start, os_cycles_frequency());
+}
+
 internal String8
 os_data_from_path(String8 path, Allocator alloc, Allocator scratch)
 {
@@ -61,7 +364,7 @@ os_data_from_path(String8 path, Allocator alloc, Allocator scratch)
 internal bool
 os_write_to_path(String8 path, String8 data, Allocator scratch)
 {
-	OS_Handle file = os_file_open(OS_AccessFlag_Write, path, scratch);
+	OS_Handle file = os_file_open(OS_AccessFlag_Write | OS_AccessFlag_Truncate, path, scratch);
 	if (file < 0) return false;
 
 	usize written = os_file_write(file, 0, data.len, data.str);
@@ -70,6 +373,31 @@ os_write_to_path(String8 path, String8 data, Allocator scratch)
 	return (written == data.len);
 }
 
+internal bool
+os_file_copy(String8 dst_path, String8 src_path, Allocator scratch)
+{
+	OS_Handle src = os_file_open(OS_AccessFlag_Read, src_path, scratch);
+	if (!src) return false;
+
+	usize size = os_properties_from_file(src).size;
+
+	// ~geb: truncate only once dst is known not to be src, or copying
+	//       a file onto itself (or a hard link of it) empties it
+	OS_Handle dst = os_file_open(OS_AccessFlag_Write, dst_path, scratch);
+	if (!dst)
+	{
+		os_file_close(src);
+		return false;
+	}
+
+	bool ok = !os_file_same(dst, src) && os_file_set_size(dst, 0) &&
+	          os_copy_range(dst, 0, src, 0, size) == size;
+
+	os_file_close(dst);
+	os_file_close(src);
+	return ok;
+}
+
 /////////////////////////////////////////////////////////////////////////
 //                        ALLOCATORS                                   //
 /////////////////////////////////////////////////////////////////////////
@@ -153,7 +481,8 @@ _gp_aligned_resize(void *p, size_t old_size, size_t new_size, size_t new_alignme
 
 	new_alignment = Max(new_alignment, AlignOf(void *));
 
-	void *old_raw = ((void **)p)[-1];
+	u8 *old_raw = ((u8 **)p)[-1];
+	usize old_offset = cast(usize)((u8 *)p - old_raw);
 
 	usize space = new_size + new_alignment - 1 + sizeof(void *);
 	u8 *new_raw = heap_realloc(old_raw, space);
@@ -164,14 +493,15 @@ _gp_aligned_resize(void *p, size_t old_size, size_t new_size, size_t new_alignme
 		return NULL;
 	}
 
+	// ~geb: realloc kept the data at its old offset from the raw
+	//       pointer, shift it before the header is written over it
 	u8 *new_aligned =
 		(u8 *)AlignPow2((usize)(new_raw + sizeof(void *)), new_alignment);
-	((void **)new_aligned)[-1] = new_raw;
-
-	if (new_aligned != p)
+	if (new_aligned != new_raw + old_offset)
 	{
-		MemMove(new_aligned, p, Min(old_size, new_size));
+		MemMove(new_aligned, new_raw + old_offset, Min(old_size, new_size));
 	}
+	((void **)new_aligned)[-1] = new_raw;
 
 	if (zero_memory && new_size > old_size)
 	{
@@ -270,7 +600,8 @@ _arena_alloc_aligned(Arena *arena, usize size, usize alignment, bool zero, Alloc
 
 	if (new_pos > arena->reserved)
 	{
-		*err = Alloc_Err_OOM;
+		if (err)
+			*err = Alloc_Err_OOM;
 		return NULL;
 	}
 
@@ -411,7 +742,8 @@ internal Allocator_Proc(arena_allocator_proc)
 			alignment, type == Allocation_Resize, err);
 
 	case Allocation_Free:
-		*err = Alloc_Err_Mode_Not_Implemented;
+		if (err)
+			*err = Alloc_Err_Mode_Not_Implemented;
 		break;
 
 	case Allocation_FreeAll:
@@ -546,35 +878,147 @@ out_of_range:
 	return 0;
 }
 
-internal bool
-is_letter(rune r)
+#include "base_unicode_tables.c"
+
+internal u8
+_unicode_props(rune r)
+{
+	r = Min(r, Rune_Max + 1);
+	u32 block = UNICODE_PROP_STAGE1[r >> UNICODE_PROP_SHIFT];
+	return UNICODE_PROP_STAGE2[block * UNICODE_PROP_BLOCK + (r & (UNICODE_PROP_BLOCK - 1))];
+}
+
+internal Unicode_Category
+rune_category(rune r)
+{
+	return _unicode_props(r) & 0x1f;
+}
+
+internal Rune_Class
+rune_class(rune r)
 {
 	if (r < RUNE_SELF)
+		return UNICODE_ASCII_CLASS[r];
+
+	u8 props = _unicode_props(r);
+	return UNICODE_CATEGORY_CLASS[props & 0x1f] | (props & 0xe0);
+}
+
+internal Rune_Class
+rune_classify_batch(rune *runes, usize count, Rune_Class *out_classes)
+{
+	Rune_Class shared = 0xff;
+
+	for (usize i = 0; i < count; ++i)
 	{
-		if ((r >= 'A' && r <= 'Z') ||
-			(r >= 'a' && r <= 'z') ||
-			r == '_') {
-			return true;
+		rune r = runes[i];
+		Rune_Class c;
+		if (r < RUNE_SELF)
+		{
+			c = UNICODE_ASCII_CLASS[r];
+		}
+		else
+		{
+			u8 props = _unicode_props(r);
+			c = UNICODE_CATEGORY_CLASS[props & 0x1f] | (props & 0xe0);
+		}
+
+		out_classes[i] = c;
+		shared &= c;
+	}
+
+	return count ? shared : 0;
+}
+
+internal u32
+utf8_encode(rune r, u8 *out)
+{
+	if (r < 0x80)
+	{
+		out[0] = cast(u8)r;
+		return 1;
+	}
+	if (r < 0x800)
+	{
+		out[0] = cast(u8)(0xc0 | (r >> 6));
+		out[1] = cast(u8)(0x80 | (r & 0x3f));
+		return 2;
+	}
+	if (r > Rune_Max || (r >= 0xd800 && r <= 0xdfff))
+		r = Rune_Invalid;
+	if (r < 0x10000)
+	{
+		out[0] = cast(u8)(0xe0 | (r >> 12));
+		out[1] = cast(u8)(0x80 | ((r >> 6) & 0x3f));
+		out[2] = cast(u8)(0x80 | (r & 0x3f));
+		return 3;
+	}
+	out[0] = cast(u8)(0xf0 | (r >> 18));
+	out[1] = cast(u8)(0x80 | ((r >> 12) & 0x3f));
+	out[2] = cast(u8)(0x80 | ((r >> 6) & 0x3f));
+	out[3] = cast(u8)(0x80 | (r & 0x3f));
+	return 4;
+}
+
+// ~geb: decode that never reads past end. A byte that does not
+//       start a valid sequence comes back as UTF8_RAW_BYTE | byte
+//       with width 1, so distinct bad bytes stay distinct.
+#define UTF8_RAW_BYTE 0x80000000u
+
+internal rune
+_utf8_decode_bounded(u8 *p, u8 *end, u32 *width)
+{
+	u8 lead = *p;
+	u32 w = UTF8_LEN_TABLE[lead];
+	if (w == 1)
+	{
+		*width = 1;
+		return lead;
+	}
+
+	if (w != 0 && cast(usize)(end - p) >= w)
+	{
+		UTF8_Error err = UTF8_Err_None;
+		rune r = utf8_decode(p, &err);
+		if (err == UTF8_Err_None)
+		{
+			*width = w;
+			return r;
 		}
 	}
 
-	return false; // TODO: unicode
+	*width = 1;
+	return UTF8_RAW_BYTE | lead;
+}
+
+internal bool
+is_letter(rune r)
+{
+	return r == '_' || MaskCheck(rune_class(r), Rune_Class_Letter);
 }
 
 internal bool
 is_digit(rune r)
 {
-	if ('0' <= r && r <= '9') { return true; }
-	return false; // TODO: unicode
+	return MaskCheck(rune_class(r), Rune_Class_Digit);
 }
 
 internal bool
 is_space(rune r)
 {
-	return (r == cast(rune) ' ' ||
-			r == cast(rune) '\t' ||
-			r == cast(rune) '\n' ||
-			r == cast(rune) '\r');
+	return MaskCheck(rune_class(r), Rune_Class_Space);
+}
+
+internal bool
+is_xid_start(rune r)
+{
+	return MaskCheck(rune_class(r), Rune_Class_XID_Start);
+}
+
+internal bool
+is_xid_continue(rune r)
+{
+	return MaskCheck(rune_class(r), Rune_Class_XID_Continue);
 }
 
 internal String8
@@ -698,6 +1142,85 @@ str8_list_index(String8_List *list, usize i)
 	return (cast(String8 *)(list->data))[i];
 }
 
+internal String8
+str8_list_join(String8_List *list, String8 separator, Allocator alloc)
+{
+	Assert(list);
+
+	String8 *strings = cast(String8 *) list->data;
+	if (list->len == 0)
+		return S("");
+
+	usize total = separator.len * (list->len - 1);
+	for (usize i = 0; i < list->len; ++i)
+		total += strings[i].len;
+
+	u8 *mem = alloc_array(alloc, u8, total, NULL);
+	if (!mem)
+		return S("");
+
+	u8 *at = mem;
+	for (usize i = 0; i < list->len; ++i)
+	{
+		if (i && separator.len)
+		{
+			MemCopy(at, separator.str, separator.len);
+			at += separator.len;
+		}
+		if (strings[i].len)
+		{
+			MemCopy(at, strings[i].str, strings[i].len);
+			at += strings[i].len;
+		}
+	}
+
+	String8 result = {
+		.str = mem,
+		.len = total};
+	return result;
+}
+
+internal String8_List
+str8_split(String8 string, String8 separators, Str8_SplitFlags flags, Allocator alloc)
+{
+	bool is_separator[256] = {0};
+	for (usize i = 0; i < separators.len; ++i)
+		is_separator[separators.str[i]] = true;
+
+	bool keep_empty = MaskCheck(flags, Str8_SplitFlag_KeepEmpty);
+
+	// ~geb: count first so the list is allocated exactly once
+	usize count = 0;
+	usize begin = 0;
+	for (usize i = 0; i <= string.len; ++i)
+	{
+		if (i == string.len || is_separator[string.str[i]])
+		{
+			if (keep_empty || i > begin)
+				count += 1;
+			begin = i + 1;
+		}
+	}
+
+	String8_List list = dynamic_array(alloc, String8, count);
+	if (count && !list.data)
+		return (String8_List){0};
+
+	String8 *out = cast(String8 *) list.data;
+	begin = 0;
+	for (usize i = 0; i <= string.len; ++i)
+	{
+		if (i == string.len || is_separator[string.str[i]])
+		{
+			if (keep_empty || i > begin)
+				out[list.len++] = str8_slice(string, begin, i);
+			begin = i + 1;
+		}
+	}
+
+	return list;
+}
+
 internal String8
 str8_slice(String8 string, usize begin, usize end_exclusive)
 {
@@ -821,60 +1344,7413 @@ str8_iter(String8 string, Str_Iterator *it)
 	return true;
 }
 
-/////////////////////////////////////////////////////////////////////////
-//                            LOGGER                                   //
-/////////////////////////////////////////////////////////////////////////
-#include <stdio.h>
-#include <stdarg.h>
+// ~geb: 64-bit hash, eight bytes per step. The length is mixed
+//       in last so the hash can be computed over a stream.
 
-#define ANSI_RESET   "\x1b[0m"
+#define STR8_HASH_SEED 0x9e3779b97f4a7c15ull
+
+force_inline u64
+hash_rotl64(u64 x, u32 r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+force_inline u64
+hash_mix_u64(u64 h, u64 word)
+{
+	word *= 0x87c37b91114253d5ull;
+	word  = hash_rotl64(word, 31);
+	word *= 0x4cf5ad432745937full;
+	h    ^= word;
+	h     = hash_rotl64(h, 27) * 5 + 0x52dce729;
+	return h;
+}
+
+force_inline u64
+hash_finalize_u64(u64 h, usize len)
+{
+	h ^= cast(u64) len;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ull;
+	h ^= h >> 33;
+	return h;
+}
+
+internal u64
+str8_hash(String8 string)
+{
+	u64 h = STR8_HASH_SEED;
+	u8 *p = string.str;
+	usize remaining = string.len;
+
+	while (remaining >= 8)
+	{
+		u64 word;
+		MemCopy(&word, p, 8);
+		h = hash_mix_u64(h, word);
+		p += 8;
+		remaining -= 8;
+	}
+
+	if (remaining)
+	{
+		u64 word = 0;
+		MemCopy(&word, p, remaining);
+		h = hash_mix_u64(h, word);
+	}
+
+	return hash_finalize_u64(h, string.len);
+}
+
+// ~geb: case conversion and folding
+
+#define SWAR_ONES  0x0101010101010101ull
+#define SWAR_HIGHS 0x8080808080808080ull
+
+force_inline u8
+ascii_lower(u8 c)
+{
+	return cast(u8)(c + ((cast(u8)(c - 'A') < 26) << 5));
+}
+
+// ~geb: flips bit 0x20 of every byte in [lo, hi], eight at a time
+force_inline u64
+swar_flip_case(u64 word, u8 lo, u8 hi)
+{
+	u64 heptets = word & ~SWAR_HIGHS;
+	u64 above_hi = heptets + (0x7f - cast(u64)hi) * SWAR_ONES;
+	u64 from_lo  = heptets + (0x80 - cast(u64)lo) * SWAR_ONES;
+	u64 in_range = ~word & (from_lo ^ above_hi) & SWAR_HIGHS;
+	return word ^ (in_range >> 2);
+}
+
+internal void
+_ascii_flip_case(u8 *dst, u8 *src, usize len, u8 lo, u8 hi)
+{
+	usize i = 0;
+
+#if ARCH_X64
+	__m128i v_lo  = _mm_set1_epi8(cast(char)(lo - 1));
+	__m128i v_hi  = _mm_set1_epi8(cast(char)(hi + 1));
+	__m128i v_bit = _mm_set1_epi8(0x20);
+	for (; i + 16 <= len; i += 16)
+	{
+		__m128i v  = _mm_loadu_si128(cast(const __m128i *)(src + i));
+		__m128i in = _mm_and_si128(_mm_cmpgt_epi8(v, v_lo), _mm_cmplt_epi8(v, v_hi));
+		_mm_storeu_si128(cast(__m128i *)(dst + i), _mm_xor_si128(v, _mm_and_si128(in, v_bit)));
+	}
+#elif ARCH_ARM64
+	uint8x16_t v_lo  = vdupq_n_u8(lo);
+	uint8x16_t v_hi  = vdupq_n_u8(hi);
+	uint8x16_t v_bit = vdupq_n_u8(0x20);
+	for (; i + 16 <= len; i += 16)
+	{
+		uint8x16_t v  = vld1q_u8(src + i);
+		uint8x16_t in = vandq_u8(vcgeq_u8(v, v_lo), vcleq_u8(v, v_hi));
+		vst1q_u8(dst + i, veorq_u8(v, vandq_u8(in, v_bit)));
+	}
+#endif
+
+	for (; i + 8 <= len; i += 8)
+	{
+		u64 word;
+		MemCopy(&word, src + i, 8);
+		word = swar_flip_case(word, lo, hi);
+		MemCopy(dst + i, &word, 8);
+	}
+
+	for (; i < len; ++i)
+	{
+		u8 c = src[i];
+		dst[i] = (c >= lo && c <= hi) ? c ^ 0x20 : c;
+	}
+}
+
+internal void
+str8_lower_ascii_inplace(String8 string)
+{
+	_ascii_flip_case(string.str, string.str, string.len, 'A', 'Z');
+}
+
+internal void
+str8_upper_ascii_inplace(String8 string)
+{
+	_ascii_flip_case(string.str, string.str, string.len, 'a', 'z');
+}
+
+internal String8
+str8_lower_ascii(String8 string, Allocator alloc)
+{
+	String8 result = {0};
+	result.str = alloc_array(alloc, u8, string.len, NULL);
+	if (!result.str)
+		return S("");
+
+	result.len = string.len;
+	_ascii_flip_case(result.str, string.str, string.len, 'A', 'Z');
+	return result;
+}
+
+internal String8
+str8_upper_ascii(String8 string, Allocator alloc)
+{
+	String8 result = {0};
+	result.str = alloc_array(alloc, u8, string.len, NULL);
+	if (!result.str)
+		return S("");
+
+	result.len = string.len;
+	_ascii_flip_case(result.str, string.str, string.len, 'a', 'z');
+	return result;
+}
+
+internal rune
+rune_fold(rune r)
+{
+	if (r < RUNE_SELF)
+		return ascii_lower(cast(u8)r);
+
+	rune c = Min(r, UNICODE_FOLD_LIMIT);
+	u32 block = UNICODE_FOLD_STAGE1[c >> UNICODE_FOLD_SHIFT];
+	u32 index = UNICODE_FOLD_STAGE2[block * UNICODE_FOLD_BLOCK + (c & (UNICODE_FOLD_BLOCK - 1))];
+	return cast(rune)(cast(i32)r + UNICODE_FOLD_DELTA[index]);
+}
+
+// ~geb: folded encoding of the rune at p, raw bytes pass through
+internal u32
+_fold_rune_utf8(u8 *p, u8 *end, u8 *out, u32 *advance)
+{
+	rune r = _utf8_decode_bounded(p, end, advance);
+	if (r & UTF8_RAW_BYTE)
+	{
+		out[0] = *p;
+		return 1;
+	}
+	return utf8_encode(rune_fold(r), out);
+}
+
+internal String8
+str8_fold(String8 string, Allocator alloc)
+{
+	u8 *end = string.str + string.len;
+
+	usize len = 0;
+	for (u8 *p = string.str; p < end;)
+	{
+		if (*p < RUNE_SELF)
+		{
+			len += 1;
+			p   += 1;
+			continue;
+		}
+
+		u8 tmp[4];
+		u32 advance;
+		len += _fold_rune_utf8(p, end, tmp, &advance);
+		p   += advance;
+	}
+
+	u8 *mem = alloc_array(alloc, u8, len, NULL);
+	if (!mem)
+		return S("");
+
+	u8 *out = mem;
+	for (u8 *p = string.str; p < end;)
+	{
+		u8 *run = p;
+		while (p < end && *p < RUNE_SELF)
+			p += 1;
+		if (p != run)
+		{
+			_ascii_flip_case(out, run, cast(usize)(p - run), 'A', 'Z');
+			out += p - run;
+		}
+
+		if (p < end)
+		{
+			u32 advance;
+			out += _fold_rune_utf8(p, end, out, &advance);
+			p   += advance;
+		}
+	}
+
+	String8 result = {
+		.str = mem,
+		.len = len};
+	return result;
+}
+
+internal bool
+str8_equal_nocase(String8 first, String8 second)
+{
+	usize n = Min(first.len, second.len);
+	usize i = 0;
+
+#if ARCH_X64
+	__m128i v_lo  = _mm_set1_epi8('A' - 1);
+	__m128i v_hi  = _mm_set1_epi8('Z' + 1);
+	__m128i v_bit = _mm_set1_epi8(0x20);
+	for (; i + 16 <= n; i += 16)
+	{
+		__m128i a = _mm_loadu_si128(cast(const __m128i *)(first.str + i));
+		__m128i b = _mm_loadu_si128(cast(const __m128i *)(second.str + i));
+		if (_mm_movemask_epi8(_mm_or_si128(a, b)))
+			break;
+
+		a = _mm_or_si128(a, _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi8(a, v_lo), _mm_cmplt_epi8(a, v_hi)), v_bit));
+		b = _mm_or_si128(b, _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi8(b, v_lo), _mm_cmplt_epi8(b, v_hi)), v_bit));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xffff)
+			return false;
+	}
+#elif ARCH_ARM64
+	uint8x16_t v_lo  = vdupq_n_u8('A');
+	uint8x16_t v_hi  = vdupq_n_u8('Z');
+	uint8x16_t v_bit = vdupq_n_u8(0x20);
+	for (; i + 16 <= n; i += 16)
+	{
+		uint8x16_t a = vld1q_u8(first.str + i);
+		uint8x16_t b = vld1q_u8(second.str + i);
+		if (vmaxvq_u8(vorrq_u8(a, b)) >= RUNE_SELF)
+			break;
+
+		a = vorrq_u8(a, vandq_u8(vandq_u8(vcgeq_u8(a, v_lo), vcleq_u8(a, v_hi)), v_bit));
+		b = vorrq_u8(b, vandq_u8(vandq_u8(vcgeq_u8(b, v_lo), vcleq_u8(b, v_hi)), v_bit));
+		if (vminvq_u8(vceqq_u8(a, b)) != 0xff)
+			return false;
+	}
+#endif
+
+	for (; i < n; ++i)
+	{
+		u8 a = first.str[i];
+		u8 b = second.str[i];
+		if ((a | b) & RUNE_SELF)
+			break;
+		if (ascii_lower(a) != ascii_lower(b))
+			return false;
+	}
+
+	// ~geb: folding maps one rune to one rune, so once one side runs
+	//       out of ascii the rest is compared rune by rune
+	if (i == n)
+		return first.len == second.len;
+
+	u8 *a   = first.str + i;
+	u8 *b   = second.str + i;
+	u8 *a_end = first.str + first.len;
+	u8 *b_end = second.str + second.len;
+	while (a < a_end && b < b_end)
+	{
+		u32 a_width, b_width;
+		rune ra = _utf8_decode_bounded(a, a_end, &a_width);
+		rune rb = _utf8_decode_bounded(b, b_end, &b_width);
+		if (rune_fold(ra) != rune_fold(rb))
+			return false;
+		a += a_width;
+		b += b_width;
+	}
+
+	return a == a_end && b == b_end;
+}
+
+// ~geb: str8_hash over a byte stream, same words and finalizer
+typedef struct Hash_Stream {
+	u64   h;
+	u64   word;
+	u32   fill;
+	usize len;
+} Hash_Stream;
+
+force_inline void
+hash_stream_byte(Hash_Stream *stream, u8 byte)
+{
+	stream->word |= cast(u64)byte << (8 * stream->fill);
+	stream->len  += 1;
+	if (++stream->fill == 8)
+	{
+		stream->h    = hash_mix_u64(stream->h, stream->word);
+		stream->word = 0;
+		stream->fill = 0;
+	}
+}
+
+internal u64
+str8_hash_nocase(String8 string)
+{
+	Hash_Stream stream = { .h = STR8_HASH_SEED };
+	u8 *p   = string.str;
+	u8 *end = string.str + string.len;
+
+	while (p < end)
+	{
+		if (stream.fill == 0 && end - p >= 8)
+		{
+			u64 word;
+			MemCopy(&word, p, 8);
+			if (!(word & SWAR_HIGHS))
+			{
+				stream.h    = hash_mix_u64(stream.h, swar_flip_case(word, 'A', 'Z'));
+				stream.len += 8;
+				p += 8;
+				continue;
+			}
+		}
+
+		if (*p < RUNE_SELF)
+		{
+			hash_stream_byte(&stream, ascii_lower(*p));
+			p += 1;
+			continue;
+		}
+
+		u8 folded[4];
+		u32 advance;
+		u32 width = _fold_rune_utf8(p, end, folded, &advance);
+		for (u32 i = 0; i < width; ++i)
+			hash_stream_byte(&stream, folded[i]);
+		p += advance;
+	}
+
+	if (stream.fill)
+		stream.h = hash_mix_u64(stream.h, stream.word);
+	return hash_finalize_u64(stream.h, stream.len);
+}
+
+/////////////////////////////////////////////////////////////////////////
+//                        STRING INTERNING                             //
+/////////////////////////////////////////////////////////////////////////
+
+force_inline void
+intern_lock(Str8_Interner *interner, u32 *lock)
+{
+	if (!(interner->flags & Str8_InternFlag_ThreadSafe))
+		return;
+
+	while (AtomicCompareExchangeU32(lock, 0, 1) != 0)
+	{
+		while (AtomicLoadU32(lock) != 0)
+			CpuPause();
+	}
+}
+
+force_inline void
+intern_unlock(Str8_Interner *interner, u32 *lock)
+{
+	if (!(interner->flags & Str8_InternFlag_ThreadSafe))
+		return;
+
+	AtomicStoreU32(lock, 0);
+}
+
+internal bool
+_intern_shard_grow(Str8_Interner *interner, Str8_Intern_Shard *shard, u32 new_capacity)
+{
+	if (new_capacity <= shard->capacity)
+		return false;
+
+	intern_lock(interner, &interner->alloc_lock);
+	Alloc_Error err = 0;
+	u64 *slots = alloc_array(interner->alloc, u64, new_capacity, &err);
+	intern_unlock(interner, &interner->alloc_lock);
+
+	if (!slots || err)
+		return false;
+
+	u32 mask = new_capacity - 1;
+	for (u32 i = 0; i < shard->capacity; ++i)
+	{
+		u64 slot = shard->slots[i];
+		if (!slot)
+			continue;
+
+		u32 index = cast(u32)(slot >> 32) & mask;
+		while (slots[index])
+			index = (index + 1) & mask;
+		slots[index] = slot;
+	}
+
+	if (shard->slots)
+	{
+		intern_lock(interner, &interner->alloc_lock);
+		mem_free(interner->alloc, shard->slots, &err);
+		intern_unlock(interner, &interner->alloc_lock);
+	}
+
+	shard->slots    = slots;
+	shard->capacity = new_capacity;
+	return true;
+}
+
+// ~geb: returns the slot index holding string, or the empty slot
+//       where it would be inserted.
+internal u32
+_intern_shard_probe(Str8_Interner *interner, Str8_Intern_Shard *shard, String8 string, u32 tag)
+{
+	u32 mask  = shard->capacity - 1;
+	u32 index = tag & mask;
+
+	for (;;)
+	{
+		u64 slot = shard->slots[index];
+		if (!slot)
+			return index;
+
+		if (cast(u32)(slot >> 32) == tag)
+		{
+			u32 id = cast(u32)slot - 1;
+			if (str8_equal(str8_from_intern(interner, id), string))
+				return index;
+		}
+
+		index = (index + 1) & mask;
+	}
+}
+
+internal Str8_Interner *
+str8_interner_make(Allocator alloc, u32 capacity_hint, Str8_Intern_Flags flags)
+{
+	Alloc_Error err = 0;
+	Str8_Interner *interner = alloc(alloc, Str8_Interner, &err);
+	if (!interner || err)
+		return NULL;
+
+	interner->alloc      = alloc;
+	interner->flags      = flags;
+	interner->shard_mask = (flags & Str8_InternFlag_ThreadSafe) ? STR8_INTERN_SHARD_COUNT - 1 : 0;
+
+	interner->pages = alloc_array(alloc, String8 *, STR8_INTERN_MAX_PAGES, &err);
+	if (!interner->pages || err)
+		return NULL;
+
+	u32 shard_count = interner->shard_mask + 1;
+	u32 per_shard   = 64;
+	while (per_shard * shard_count < capacity_hint + capacity_hint / 2)
+		per_shard <<= 1;
+
+	for (u32 i = 0; i < shard_count; ++i)
+	{
+		Str8_Intern_Shard *shard = &interner->shards[i];
+		if (!_intern_shard_grow(interner, shard, per_shard))
+			return NULL;
+	}
+
+	if (str8_intern(interner, S("")) != 0)
+		return NULL;
+	return interner;
+}
+
+internal void
+str8_interner_delete(Str8_Interner *interner)
+{
+	Alloc_Error err = 0;
+	Allocator alloc = interner->alloc;
+
+	for (u32 id = 0; id < interner->count; ++id)
+	{
+		String8 string = str8_from_intern(interner, id);
+		if (string.len)
+			mem_free(alloc, string.str, &err);
+	}
+
+	for (u32 i = 0; i < STR8_INTERN_MAX_PAGES && interner->pages[i]; ++i)
+		mem_free(alloc, interner->pages[i], &err);
+
+	for (u32 i = 0; i <= interner->shard_mask; ++i)
+		mem_free(alloc, interner->shards[i].slots, &err);
+
+	mem_free(alloc, interner->pages, &err);
+	mem_free(alloc, interner, &err);
+}
+
+internal u32
+str8_intern(Str8_Interner *interner, String8 string)
+{
+	u64 hash = str8_hash(string);
+	u32 tag  = cast(u32)(hash >> 32);
+	Str8_Intern_Shard *shard = &interner->shards[hash & interner->shard_mask];
+
+	intern_lock(interner, &shard->lock);
+
+	u32 index = _intern_shard_probe(interner, shard, string, tag);
+	u64 slot  = shard->slots[index];
+	if (slot)
+	{
+		intern_unlock(interner, &shard->lock);
+		return cast(u32)slot - 1;
+	}
+
+	// ~geb: grow before the insert, a shard that can't grow stays
+	//       under 3/4 full so probing always finds an empty slot
+	if ((shard->count + 1) * 4 >= shard->capacity * 3)
+	{
+		if (!_intern_shard_grow(interner, shard, shard->capacity << 1))
+		{
+			intern_unlock(interner, &shard->lock);
+			return STR8_INTERN_NONE;
+		}
+		index = _intern_shard_probe(interner, shard, string, tag);
+	}
+
+	// ~geb: the id is only taken once its entry is in place, so a
+	//       failed allocation leaves no hole in the dense ids
+	intern_lock(interner, &interner->alloc_lock);
+
+	u32 id   = interner->count;
+	u32 page = id >> STR8_INTERN_PAGE_SHIFT;
+
+	String8 *entries = page < STR8_INTERN_MAX_PAGES ? interner->pages[page] : NULL;
+	if (!entries && page < STR8_INTERN_MAX_PAGES)
+	{
+		entries = alloc_array(interner->alloc, String8, STR8_INTERN_PAGE_SIZE, NULL);
+		AtomicStorePtr(&interner->pages[page], entries);
+	}
+
+	// ~geb: not str8_copy, it writes through the pointer unchecked
+	String8 copy = S("");
+	if (string.len && entries)
+	{
+		copy.str = alloc_array(interner->alloc, u8, string.len, NULL);
+		copy.len = string.len;
+		if (copy.str)
+			MemCopy(copy.str, string.str, string.len);
+	}
+	if (!entries || !copy.str)
+	{
+		intern_unlock(interner, &interner->alloc_lock);
+		intern_unlock(interner, &shard->lock);
+		return STR8_INTERN_NONE;
+	}
+
+	entries[id & (STR8_INTERN_PAGE_SIZE - 1)] = copy;
+	AtomicStoreU32(&interner->count, id + 1);
+
+	intern_unlock(interner, &interner->alloc_lock);
+
+	shard->slots[index] = (cast(u64)tag << 32) | (cast(u64)id + 1);
+	shard->count += 1;
+
+	intern_unlock(interner, &shard->lock);
+	return id;
+}
+
+internal bool
+str8_intern_find(Str8_Interner *interner, String8 string, u32 *out_id)
+{
+	u64 hash = str8_hash(string);
+	u32 tag  = cast(u32)(hash >> 32);
+	Str8_Intern_Shard *shard = &interner->shards[hash & interner->shard_mask];
+
+	intern_lock(interner, &shard->lock);
+	u64 slot = shard->slots[_intern_shard_probe(interner, shard, string, tag)];
+	intern_unlock(interner, &shard->lock);
+
+	if (!slot)
+		return false;
+
+	if (out_id)
+		*out_id = cast(u32)slot - 1;
+	return true;
+}
+
+internal String8
+str8_from_intern(Str8_Interner *interner, u32 id)
+{
+	Assert(id < AtomicLoadU32(&interner->count));
+
+	String8 *entries = AtomicLoadPtr(&interner->pages[id >> STR8_INTERN_PAGE_SHIFT]);
+	return entries[id & (STR8_INTERN_PAGE_SIZE - 1)];
+}
+
+internal u32
+str8_interner_count(Str8_Interner *interner)
+{
+	return AtomicLoadU32(&interner->count);
+}
+
+/////////////////////////////////////////////////////////////////////////
+//                         STRING BUILDER                              //
+/////////////////////////////////////////////////////////////////////////
+
+internal Str8_Builder
+str8_builder_make(Allocator alloc, usize chunk_size)
+{
+	Str8_Builder builder = {
+		.alloc      = alloc,
+		.chunk_size = chunk_size ? chunk_size : STR8_BUILDER_DEFAULT_CHUNK,
+	};
+	return builder;
+}
+
+internal void
+str8_builder_delete(Str8_Builder *builder)
+{
+	Alloc_Error err = 0;
+	for (Str8_Chunk *chunk = builder->first; chunk;)
+	{
+		Str8_Chunk *next = chunk->next;
+		mem_free(builder->alloc, chunk, &err);
+		chunk = next;
+	}
+
+	builder->first = NULL;
+	builder->last  = NULL;
+	builder->len   = 0;
+}
+
+internal u8 *
+str8_builder_reserve(Str8_Builder *builder, usize size)
+{
+	Str8_Chunk *last = builder->last;
+	if (last && last->capacity - last->len >= size)
+		return last->data + last->len;
+
+	usize capacity = Max(builder->chunk_size, size);
+
+	Alloc_Error err = 0;
+	Str8_Chunk *chunk = cast(Str8_Chunk *) mem_alloc_aligned(
+		builder->alloc, sizeof(Str8_Chunk) + capacity, AlignOf(Str8_Chunk), false, &err);
+	if (!chunk || err)
+		return NULL;
+
+	chunk->next     = NULL;
+	chunk->len      = 0;
+	chunk->capacity = capacity;
+	chunk->data     = cast(u8 *)(chunk + 1);
+
+	if (last)
+		last->next = chunk;
+	else
+		builder->first = chunk;
+	builder->last = chunk;
+
+	return chunk->data;
+}
+
+internal void
+str8_builder_commit(Str8_Builder *builder, usize size)
+{
+	Assert(builder->last);
+	Assert(builder->last->len + size <= builder->last->capacity);
+
+	builder->last->len += size;
+	builder->len       += size;
+}
+
+internal void
+str8_builder_push(Str8_Builder *builder, String8 string)
+{
+	u8 *src = string.str;
+	usize remaining = string.len;
+
+	Str8_Chunk *last = builder->last;
+	if (last)
+	{
+		usize fits = Min(remaining, last->capacity - last->len);
+		if (fits)
+		{
+			MemCopy(last->data + last->len, src, fits);
+			str8_builder_commit(builder, fits);
+			src += fits;
+			remaining -= fits;
+		}
+	}
+
+	if (remaining)
+	{
+		u8 *dst = str8_builder_reserve(builder, remaining);
+		if (!dst)
+			return;
+
+		MemCopy(dst, src, remaining);
+		str8_builder_commit(builder, remaining);
+	}
+}
+
+internal void
+str8_builder_push_byte(Str8_Builder *builder, u8 byte)
+{
+	u8 *dst = str8_builder_reserve(builder, 1);
+	if (!dst)
+		return;
+
+	*dst = byte;
+	str8_builder_commit(builder, 1);
+}
+
+internal String8
+str8_builder_flatten(Str8_Builder *builder, Allocator alloc)
+{
+	if (builder->len == 0)
+		return S("");
+
+	u8 *mem = alloc_array(alloc, u8, builder->len, NULL);
+	if (!mem)
+		return S("");
+
+	u8 *at = mem;
+	for (Str8_Chunk *chunk = builder->first; chunk; chunk = chunk->next)
+	{
+		MemCopy(at, chunk->data, chunk->len);
+		at += chunk->len;
+	}
+
+	String8 result = {
+		.str = mem,
+		.len = builder->len};
+	return result;
+}
+
+internal usize
+str8_builder_write(Str8_Builder *builder, OS_Handle file, usize offset)
+{
+	usize total = 0;
+	for (Str8_Chunk *chunk = builder->first; chunk; chunk = chunk->next)
+	{
+		if (chunk->len == 0)
+			continue;
+
+		usize written = os_file_write(file, offset + total, offset + total + chunk->len, chunk->data);
+		total += written;
+		if (written != chunk->len)
+			break;
+	}
+	return total;
+}
+
+/////////////////////////////////////////////////////////////////////////
+//                       STRING FORMATTING                             //
+/////////////////////////////////////////////////////////////////////////
+
+global const char DIGIT_PAIRS[201] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+global const u64 POW10_U64[20] = {
+	1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull,
+	10000000ull, 100000000ull, 1000000000ull, 10000000000ull,
+	100000000000ull, 1000000000000ull, 10000000000000ull,
+	100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+	100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull,
+};
+
+force_inline u32
+u64_digit_count(u64 value)
+{
+	u32 count = 1;
+	for (;;)
+	{
+		if (value < 10)    return count;
+		if (value < 100)   return count + 1;
+		if (value < 1000)  return count + 2;
+		if (value < 10000) return count + 3;
+		value /= 10000;
+		count += 4;
+	}
+}
+
+internal usize
+u64_to_chars(u8 *dst, u64 value)
+{
+	u32 len = u64_digit_count(value);
+	u8 *at  = dst + len;
+
+	while (value >= 100)
+	{
+		u32 i = cast(u32)(value % 100) * 2;
+		value /= 100;
+		at -= 2;
+		at[0] = DIGIT_PAIRS[i];
+		at[1] = DIGIT_PAIRS[i + 1];
+	}
+
+	if (value >= 10)
+	{
+		u32 i = cast(u32)value * 2;
+		at[-2] = DIGIT_PAIRS[i];
+		at[-1] = DIGIT_PAIRS[i + 1];
+	}
+	else
+	{
+		at[-1] = cast(u8)('0' + value);
+	}
+
+	return len;
+}
+
+internal usize
+i64_to_chars(u8 *dst, i64 value)
+{
+	if (value < 0)
+	{
+		dst[0] = '-';
+		return 1 + u64_to_chars(dst + 1, 0 - cast(u64)value);
+	}
+	return u64_to_chars(dst, cast(u64)value);
+}
+
+// ~geb: Grisu2 (Loitsch, "Printing Floating-Point Numbers Quickly
+//       and Accurately with Integers"). Produces the digits of a
+//       positive finite double, value = digits * 10^k. The result
+//       always round trips and is the shortest in nearly all cases.
+
+typedef struct Diy_Fp {
+	u64 f;
+	i32 e;
+} Diy_Fp;
+
+global const Diy_Fp GRISU_CACHED_POWERS[87] = {
+	{0xfa8fd5a0081c0288ull, -1220}, {0xbaaee17fa23ebf76ull, -1193}, {0x8b16fb203055ac76ull, -1166},
+	{0xcf42894a5dce35eaull, -1140}, {0x9a6bb0aa55653b2dull, -1113}, {0xe61acf033d1a45dfull, -1087},
+	{0xab70fe17c79ac6caull, -1060}, {0xff77b1fcbebcdc4full, -1034}, {0xbe5691ef416bd60cull, -1007},
+	{0x8dd01fad907ffc3cull, -980}, {0xd3515c2831559a83ull, -954}, {0x9d71ac8fada6c9b5ull, -927},
+	{0xea9c227723ee8bcbull, -901}, {0xaecc49914078536dull, -874}, {0x823c12795db6ce57ull, -847},
+	{0xc21094364dfb5637ull, -821}, {0x9096ea6f3848984full, -794}, {0xd77485cb25823ac7ull, -768},
+	{0xa086cfcd97bf97f4ull, -741}, {0xef340a98172aace5ull, -715}, {0xb23867fb2a35b28eull, -688},
+	{0x84c8d4dfd2c63f3bull, -661}, {0xc5dd44271ad3cdbaull, -635}, {0x936b9fcebb25c996ull, -608},
+	{0xdbac6c247d62a584ull, -582}, {0xa3ab66580d5fdaf6ull, -555}, {0xf3e2f893dec3f126ull, -529},
+	{0xb5b5ada8aaff80b8ull, -502}, {0x87625f056c7c4a8bull, -475}, {0xc9bcff6034c13053ull, -449},
+	{0x964e858c91ba2655ull, -422}, {0xdff9772470297ebdull, -396}, {0xa6dfbd9fb8e5b88full, -369},
+	{0xf8a95fcf88747d94ull, -343}, {0xb94470938fa89bcfull, -316}, {0x8a08f0f8bf0f156bull, -289},
+	{0xcdb02555653131b6ull, -263}, {0x993fe2c6d07b7facull, -236}, {0xe45c10c42a2b3b06ull, -210},
+	{0xaa242499697392d3ull, -183}, {0xfd87b5f28300ca0eull, -157}, {0xbce5086492111aebull, -130},
+	{0x8cbccc096f5088ccull, -103}, {0xd1b71758e219652cull, -77}, {0x9c40000000000000ull, -50},
+	{0xe8d4a51000000000ull, -24}, {0xad78ebc5ac620000ull, 3}, {0x813f3978f8940984ull, 30},
+	{0xc097ce7bc90715b3ull, 56}, {0x8f7e32ce7bea5c70ull, 83}, {0xd5d238a4abe98068ull, 109},
+	{0x9f4f2726179a2245ull, 136}, {0xed63a231d4c4fb27ull, 162}, {0xb0de65388cc8ada8ull, 189},
+	{0x83c7088e1aab65dbull, 216}, {0xc45d1df942711d9aull, 242}, {0x924d692ca61be758ull, 269},
+	{0xda01ee641a708deaull, 295}, {0xa26da3999aef774aull, 322}, {0xf209787bb47d6b85ull, 348},
+	{0xb454e4a179dd1877ull, 375}, {0x865b86925b9bc5c2ull, 402}, {0xc83553c5c8965d3dull, 428},
+	{0x952ab45cfa97a0b3ull, 455}, {0xde469fbd99a05fe3ull, 481}, {0xa59bc234db398c25ull, 508},
+	{0xf6c69a72a3989f5cull, 534}, {0xb7dcbf5354e9beceull, 561}, {0x88fcf317f22241e2ull, 588},
+	{0xcc20ce9bd35c78a5ull, 614}, {0x98165af37b2153dfull, 641}, {0xe2a0b5dc971f303aull, 667},
+	{0xa8d9d1535ce3b396ull, 694}, {0xfb9b7cd9a4a7443cull, 720}, {0xbb764c4ca7a44410ull, 747},
+	{0x8bab8eefb6409c1aull, 774}, {0xd01fef10a657842cull, 800}, {0x9b10a4e5e9913129ull, 827},
+	{0xe7109bfba19c0c9dull, 853}, {0xac2820d9623bf429ull, 880}, {0x80444b5e7aa7cf85ull, 907},
+	{0xbf21e44003acdd2dull, 933}, {0x8e679c2f5e44ff8full, 960}, {0xd433179d9c8cb841ull, 986},
+	{0x9e19db92b4e31ba9ull, 1013}, {0xeb96bf6ebadf77d9ull, 1039}, {0xaf87023b9bf0ee6bull, 1066},
+};
+
+force_inline Diy_Fp
+diy_fp_normalize(Diy_Fp x)
+{
+	u32 shift = CountLeadingZeros64(x.f);
+	x.f <<= shift;
+	x.e  -= cast(i32)shift;
+	return x;
+}
+
+force_inline Diy_Fp
+diy_fp_mul(Diy_Fp x, Diy_Fp y)
+{
+	u64 m32 = 0xffffffffull;
+	u64 a = x.f >> 32, b = x.f & m32;
+	u64 c = y.f >> 32, d = y.f & m32;
+	u64 ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+
+	u64 tmp = (bd >> 32) + (ad & m32) + (bc & m32);
+	tmp += 1ull << 31; // round
+
+	Diy_Fp result = {
+		.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32),
+		.e = x.e + y.e + 64};
+	return result;
+}
+
+force_inline void
+grisu_round(u8 *buffer, u32 len, u64 delta, u64 rest, u64 ten_kappa, u64 wp_w)
+{
+	while (rest < wp_w && delta - rest >= ten_kappa &&
+		   (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w))
+	{
+		buffer[len - 1] -= 1;
+		rest += ten_kappa;
+	}
+}
+
+internal u32
+grisu_digit_gen(Diy_Fp w, Diy_Fp mp, u64 delta, u8 *buffer, i32 *k)
+{
+	Diy_Fp one = { .f = 1ull << -mp.e, .e = mp.e };
+	u64 wp_w   = mp.f - w.f;
+	u32 p1     = cast(u32)(mp.f >> -one.e);
+	u64 p2     = mp.f & (one.f - 1);
+	i32 kappa  = cast(i32)u64_digit_count(p1);
+	u32 len    = 0;
+
+	while (kappa > 0)
+	{
+		u32 div = cast(u32)POW10_U64[kappa - 1];
+		u32 d   = p1 / div;
+		p1 %= div;
+		if (d || len)
+			buffer[len++] = cast(u8)('0' + d);
+		kappa -= 1;
+
+		u64 rest = (cast(u64)p1 << -one.e) + p2;
+		if (rest <= delta)
+		{
+			*k += kappa;
+			grisu_round(buffer, len, delta, rest, POW10_U64[kappa] << -one.e, wp_w);
+			return len;
+		}
+	}
+
+	for (;;)
+	{
+		p2    *= 10;
+		delta *= 10;
+		u32 d  = cast(u32)(p2 >> -one.e);
+		if (d || len)
+			buffer[len++] = cast(u8)('0' + d);
+		p2 &= one.f - 1;
+		kappa -= 1;
+
+		if (p2 < delta)
+		{
+			*k += kappa;
+			i32 index = -kappa;
+			grisu_round(buffer, len, delta, p2, one.f, wp_w * (index < 20 ? POW10_U64[index] : 0));
+			return len;
+		}
+	}
+}
+
+internal u32
+grisu2(f64 value, u8 *buffer, i32 *k)
+{
+	u64 bits;
+	MemCopy(&bits, &value, sizeof(bits));
+
+	u64 hidden   = 1ull << 52;
+	i32 biased_e = cast(i32)((bits >> 52) & 0x7ff);
+	u64 fraction = bits & (hidden - 1);
+
+	Diy_Fp v;
+	if (biased_e)
+	{
+		v.f = fraction | hidden;
+		v.e = biased_e - 1075;
+	}
+	else
+	{
+		v.f = fraction;
+		v.e = -1074;
+	}
+
+	Diy_Fp plus = diy_fp_normalize((Diy_Fp){ .f = (v.f << 1) + 1, .e = v.e - 1 });
+	Diy_Fp minus = (v.f == hidden) ?
+		(Diy_Fp){ .f = (v.f << 2) - 1, .e = v.e - 2 } :
+		(Diy_Fp){ .f = (v.f << 1) - 1, .e = v.e - 1 };
+	minus.f <<= minus.e - plus.e;
+	minus.e   = plus.e;
+
+	f64 dk = (-61 - plus.e) * 0.30102999566398114 + 347;
+	i32 ik = cast(i32)dk;
+	if (dk - ik > 0.0)
+		ik += 1;
+
+	u32 index = cast(u32)((ik >> 3) + 1);
+	*k = -(-348 + cast(i32)index * 8);
+	Diy_Fp c_mk = GRISU_CACHED_POWERS[index];
+
+	Diy_Fp w  = diy_fp_mul(diy_fp_normalize(v), c_mk);
+	Diy_Fp wp = diy_fp_mul(plus,  c_mk);
+	Diy_Fp wm = diy_fp_mul(minus, c_mk);
+	wm.f += 1;
+	wp.f -= 1;
+
+	return grisu_digit_gen(w, wp, wp.f - wm.f, buffer, k);
+}
+
+// ~geb: decimal digits of |value|, value = 0.d1d2d3... * 10^point.
+//       Zero has no digits. The shortest round trip digits fit in
+//       FMT_DECIMAL_SHORTEST, every exact digit of a double (up to
+//       767 significant ones) in FMT_DECIMAL_EXACT.
+#define FMT_DECIMAL_SHORTEST 20
+#define FMT_DECIMAL_EXACT    768
+
+typedef struct Fmt_Decimal {
+	u8  *digits;
+	i32  len;
+	i32  point;
+	f64  value;
+	bool exact;   // ~geb: digits are the whole exact value
+} Fmt_Decimal;
+
+internal Fmt_Decimal
+fmt_decimal_from_f64(f64 value, u8 *digits)
+{
+	Fmt_Decimal dec = { .digits = digits };
+	if (value == 0.0)
+	{
+		dec.exact = true;
+		return dec;
+	}
+
+	i32 k = 0;
+	dec.value = Abs(value);
+	dec.len   = cast(i32)grisu2(dec.value, dec.digits, &k);
+	dec.point = dec.len + k;
+
+	while (dec.len > 0 && dec.digits[dec.len - 1] == '0')
+		dec.len -= 1;
+	return dec;
+}
+
+// ~geb: just enough of a bignum to compare a double against a
+//       decimal exactly, used to settle rounding ties here and in
+//       str8_parse_f64. 96 limbs fit every digit of a double and
+//       PARSE_DECIMAL_DIGITS of input scaled against a halfway point.
+typedef struct Fmt_Big {
+	u32 limbs[96];
+	u32 count;
+} Fmt_Big;
+
+internal void
+fmt_big_mul_u32(Fmt_Big *big, u32 factor)
+{
+	u64 carry = 0;
+	for (u32 i = 0; i < big->count; ++i)
+	{
+		u64 product = cast(u64)big->limbs[i] * factor + carry;
+		big->limbs[i] = cast(u32)product;
+		carry = product >> 32;
+	}
+	if (carry)
+		big->limbs[big->count++] = cast(u32)carry;
+}
+
+internal void
+fmt_big_mul_pow5(Fmt_Big *big, u32 exponent)
+{
+	for (; exponent >= 13; exponent -= 13)
+		fmt_big_mul_u32(big, 1220703125u); // 5^13
+	u32 rest = 1;
+	while (exponent--)
+		rest *= 5;
+	fmt_big_mul_u32(big, rest);
+}
+
+internal void
+fmt_big_shl(Fmt_Big *big, u32 shift)
+{
+	u32 limb_shift = shift / 32;
+	u32 bit_shift  = shift % 32;
+
+	if (bit_shift)
+	{
+		u32 carry = 0;
+		for (u32 i = 0; i < big->count; ++i)
+		{
+			u32 limb = big->limbs[i];
+			big->limbs[i] = (limb << bit_shift) | carry;
+			carry = limb >> (32 - bit_shift);
+		}
+		if (carry)
+			big->limbs[big->count++] = carry;
+	}
+
+	if (limb_shift)
+	{
+		MemMove(big->limbs + limb_shift, big->limbs, big->count * sizeof(u32));
+		MemZero(big->limbs, limb_shift * sizeof(u32));
+		big->count += limb_shift;
+	}
+}
+
+internal void
+fmt_big_add_u32(Fmt_Big *big, u32 addend)
+{
+	u64 carry = addend;
+	for (u32 i = 0; carry && i < big->count; ++i)
+	{
+		u64 sum = cast(u64)big->limbs[i] + carry;
+		big->limbs[i] = cast(u32)sum;
+		carry = sum >> 32;
+	}
+	if (carry)
+		big->limbs[big->count++] = cast(u32)carry;
+}
+
+// ~geb: divides in place, returns the remainder
+internal u32
+fmt_big_divmod_u32(Fmt_Big *big, u32 divisor)
+{
+	u64 remainder = 0;
+	for (u32 i = big->count; i-- > 0;)
+	{
+		u64 current = (remainder << 32) | big->limbs[i];
+		big->limbs[i] = cast(u32)(current / divisor);
+		remainder     = current % divisor;
+	}
+	while (big->count && !big->limbs[big->count - 1])
+		big->count -= 1;
+	return cast(u32)remainder;
+}
+
+internal i32
+fmt_big_cmp(Fmt_Big *a, Fmt_Big *b)
+{
+	if (a->count != b->count)
+		return a->count < b->count ? -1 : 1;
+
+	for (u32 i = a->count; i-- > 0;)
+	{
+		if (a->limbs[i] != b->limbs[i])
+			return a->limbs[i] < b->limbs[i] ? -1 : 1;
+	}
+	return 0;
+}
+
+// ~geb: compares value with digits[0..len) * 10^(point - len)
+internal i32
+fmt_decimal_compare_exact(f64 value, u8 *digits, i32 len, i32 point)
+{
+	u64 bits;
+	MemCopy(&bits, &value, sizeof(bits));
+
+	i32 biased_e = cast(i32)((bits >> 52) & 0x7ff);
+	u64 mantissa = bits & ((1ull << 52) - 1);
+	i32 e        = -1074;
+	if (biased_e)
+	{
+		mantissa |= 1ull << 52;
+		e = biased_e - 1075;
+	}
+
+	u64 n = 0;
+	for (i32 i = 0; i < len; ++i)
+		n = n * 10 + cast(u64)(digits[i] - '0');
+	i32 q = point - len;
+
+	// ~geb: mantissa * 2^e  vs  n * 2^q * 5^q, twos moved to one side
+	Fmt_Big lhs = { .limbs = { cast(u32)mantissa, cast(u32)(mantissa >> 32) }, .count = 2 };
+	Fmt_Big rhs = { .limbs = { cast(u32)n,        cast(u32)(n >> 32) },        .count = 2 };
+
+	i32 twos = e - q;
+	if (twos > 0) fmt_big_shl(&lhs, cast(u32)twos);
+	else          fmt_big_shl(&rhs, cast(u32)-twos);
+
+	if (q > 0) fmt_big_mul_pow5(&rhs, cast(u32)q);
+	else       fmt_big_mul_pow5(&lhs, cast(u32)-q);
+
+	while (lhs.count && !lhs.limbs[lhs.count - 1]) lhs.count -= 1;
+	while (rhs.count && !rhs.limbs[rhs.count - 1]) rhs.count -= 1;
+
+	return fmt_big_cmp(&lhs, &rhs);
+}
+
+// ~geb: replaces the digits with every digit of the exact value,
+//       mantissa * 2^e written out as an integer over 10^-e.
+//       dec->digits must hold FMT_DECIMAL_EXACT
+internal void
+fmt_decimal_exact(Fmt_Decimal *dec)
+{
+	if (dec->exact)
+		return;
+
+	u64 bits;
+	MemCopy(&bits, &dec->value, sizeof(bits));
+
+	i32 biased_e = cast(i32)((bits >> 52) & 0x7ff);
+	u64 mantissa = bits & ((1ull << 52) - 1);
+	i32 e        = -1074;
+	if (biased_e)
+	{
+		mantissa |= 1ull << 52;
+		e = biased_e - 1075;
+	}
+
+	Fmt_Big big = { .limbs = { cast(u32)mantissa, cast(u32)(mantissa >> 32) }, .count = 2 };
+	i32 scale = 0;
+	if (e >= 0)
+	{
+		fmt_big_shl(&big, cast(u32)e);
+	}
+	else
+	{
+		fmt_big_mul_pow5(&big, cast(u32)-e);
+		scale = -e;
+	}
+	while (big.count && !big.limbs[big.count - 1])
+		big.count -= 1;
+
+	// ~geb: nine digits at a time from the bottom
+	u8  buffer[FMT_DECIMAL_EXACT + 9];
+	u8 *end = buffer + sizeof(buffer);
+	u8 *at  = end;
+	while (big.count)
+	{
+		u32 chunk = fmt_big_divmod_u32(&big, 1000000000u);
+		for (u32 i = 0; i < 9; ++i)
+		{
+			*--at = cast(u8)('0' + chunk % 10);
+			chunk /= 10;
+		}
+	}
+	while (at < end && *at == '0')
+		at += 1;
+
+	i32 len = cast(i32)(end - at);
+	dec->point = len - scale;
+	while (len > 0 && at[len - 1] == '0')
+		len -= 1;
+
+	MemCopy(dec->digits, at, cast(usize)len);
+	dec->len   = len;
+	dec->exact = true;
+}
+
+// ~geb: round to keep significant digits. The shortest digits are
+//       only an approximation of the value, so when they end in the
+//       5 being rounded the exact value decides, ties go to even.
+internal void
+fmt_decimal_round(Fmt_Decimal *dec, i32 keep)
+{
+	if (keep >= dec->len)
+		return;
+
+	if (keep < 0)
+	{
+		dec->len = 0;
+		return;
+	}
+
+	bool round_up = dec->digits[keep] >= '5';
+	if (dec->digits[keep] == '5' && keep == dec->len - 1)
+	{
+		i32 order = dec->exact ? 0 : fmt_decimal_compare_exact(dec->value, dec->digits, dec->len, dec->point);
+		if (order == 0)
+			round_up = keep > 0 && ((dec->digits[keep - 1] - '0') & 1);
+		else
+			round_up = order > 0;
+	}
+	dec->len = keep;
+
+	if (round_up)
+	{
+		i32 i = keep - 1;
+		while (i >= 0 && dec->digits[i] == '9')
+			i -= 1;
+
+		if (i < 0)
+		{
+			dec->digits[0] = '1';
+			dec->len       = 1;
+			dec->point    += 1;
+		}
+		else
+		{
+			dec->digits[i] += 1;
+			dec->len        = i + 1;
+		}
+	}
+
+	while (dec->len > 0 && dec->digits[dec->len - 1] == '0')
+		dec->len -= 1;
+}
+
+internal usize
+f64_to_chars(u8 *dst, f64 value)
+{
+	u8 *at = dst;
+
+	u64 bits;
+	MemCopy(&bits, &value, sizeof(bits));
+	if (bits >> 63)
+		*at++ = '-';
+
+	if ((bits & 0x7ff0000000000000ull) == 0x7ff0000000000000ull)
+	{
+		if (bits & 0x000fffffffffffffull)
+		{
+			MemCopy(dst, "nan", 3);
+			return 3;
+		}
+		MemCopy(at, "inf", 3);
+		return cast(usize)(at - dst) + 3;
+	}
+
+	u8 digits[FMT_DECIMAL_SHORTEST];
+	Fmt_Decimal dec = fmt_decimal_from_f64(value, digits);
+	if (dec.len == 0)
+	{
+		*at++ = '0';
+		return cast(usize)(at - dst);
+	}
+
+	if (0 < dec.point && dec.point <= 21)
+	{
+		if (dec.len <= dec.point)
+		{
+			MemCopy(at, dec.digits, dec.len);
+			MemSet(at + dec.len, '0', dec.point - dec.len);
+			at += dec.point;
+		}
+		else
+		{
+			MemCopy(at, dec.digits, dec.point);
+			at[dec.point] = '.';
+			MemCopy(at + dec.point + 1, dec.digits + dec.point, dec.len - dec.point);
+			at += dec.len + 1;
+		}
+	}
+	else if (-6 < dec.point && dec.point <= 0)
+	{
+		*at++ = '0';
+		*at++ = '.';
+		MemSet(at, '0', -dec.point);
+		at += -dec.point;
+		MemCopy(at, dec.digits, dec.len);
+		at += dec.len;
+	}
+	else
+	{
+		*at++ = dec.digits[0];
+		if (dec.len > 1)
+		{
+			*at++ = '.';
+			MemCopy(at, dec.digits + 1, dec.len - 1);
+			at += dec.len - 1;
+		}
+
+		i32 exponent = dec.point - 1;
+		*at++ = 'e';
+		*at++ = exponent < 0 ? '-' : '+';
+		u32 magnitude = cast(u32)Abs(exponent);
+		if (magnitude < 10)
+			*at++ = '0';
+		at += u64_to_chars(at, magnitude);
+	}
+
+	return cast(usize)(at - dst);
+}
+
+// ~geb: printf engine. Output past capacity is counted but not
+//       written so the caller can size a second pass exactly.
+
+typedef struct Fmt_Sink {
+	u8   *buffer;
+	usize capacity;
+	usize len;
+} Fmt_Sink;
+
+force_inline void
+fmt_push(Fmt_Sink *sink, const void *data, usize size)
+{
+	if (sink->len < sink->capacity)
+		MemCopy(sink->buffer + sink->len, data, Min(size, sink->capacity - sink->len));
+	sink->len += size;
+}
+
+force_inline void
+fmt_fill(Fmt_Sink *sink, u8 byte, usize count)
+{
+	if (sink->len < sink->capacity)
+		MemSet(sink->buffer + sink->len, byte, Min(count, sink->capacity - sink->len));
+	sink->len += count;
+}
+
+typedef u32 Fmt_Flags;
+enum {
+	Fmt_Flag_Left  = Bit(0),
+	Fmt_Flag_Plus  = Bit(1),
+	Fmt_Flag_Space = Bit(2),
+	Fmt_Flag_Alt   = Bit(3),
+	Fmt_Flag_Zero  = Bit(4),
+};
+
+typedef enum Fmt_Length {
+	Fmt_Length_None,
+	Fmt_Length_hh,
+	Fmt_Length_h,
+	Fmt_Length_l,
+	Fmt_Length_ll,
+	Fmt_Length_z,
+	Fmt_Length_j,
+	Fmt_Length_t,
+} Fmt_Length;
+
+typedef struct Fmt_Spec {
+	Fmt_Flags flags;
+	i32       width;
+	i32       precision; // -1 when not given
+} Fmt_Spec;
+
+// ~geb: pads the field around prefix + zeros + body, where the
+//       body is either bytes or a decimal laid out by the caller.
+internal void
+fmt_pad_begin(Fmt_Sink *sink, Fmt_Spec spec, String8 prefix, usize body_len, bool zero_pad)
+{
+	usize total = prefix.len + body_len;
+	usize pad   = spec.width > 0 && cast(usize)spec.width > total ? cast(usize)spec.width - total : 0;
+
+	if (!(spec.flags & Fmt_Flag_Left) && !zero_pad)
+		fmt_fill(sink, ' ', pad);
+	fmt_push(sink, prefix.str, prefix.len);
+	if (!(spec.flags & Fmt_Flag_Left) && zero_pad)
+		fmt_fill(sink, '0', pad);
+}
+
+internal void
+fmt_pad_end(Fmt_Sink *sink, Fmt_Spec spec, String8 prefix, usize body_len)
+{
+	usize total = prefix.len + body_len;
+	if ((spec.flags & Fmt_Flag_Left) && spec.width > 0 && cast(usize)spec.width > total)
+		fmt_fill(sink, ' ', cast(usize)spec.width - total);
+}
+
+internal void
+fmt_string(Fmt_Sink *sink, Fmt_Spec spec, String8 string)
+{
+	if (spec.precision >= 0 && cast(usize)spec.precision < string.len)
+		string.len = cast(usize)spec.precision;
+
+	fmt_pad_begin(sink, spec, S(""), string.len, false);
+	fmt_push(sink, string.str, string.len);
+	fmt_pad_end(sink, spec, S(""), string.len);
+}
+
+internal void
+fmt_integer(Fmt_Sink *sink, Fmt_Spec spec, u64 magnitude, bool negative, u8 conv)
+{
+	u8 digits[24];
+	usize len = 0;
+
+	if (conv == 'x' || conv == 'X' || conv == 'p')
+	{
+		const char *hex = conv == 'X' ? "0123456789ABCDEF" : "0123456789abcdef";
+		u8 *at = digits + sizeof(digits);
+		for (u64 v = magnitude; v; v >>= 4)
+			*--at = hex[v & 0xf];
+		len = cast(usize)(digits + sizeof(digits) - at);
+		MemMove(digits, at, len);
+	}
+	else if (conv == 'o')
+	{
+		u8 *at = digits + sizeof(digits);
+		for (u64 v = magnitude; v; v >>= 3)
+			*--at = cast(u8)('0' + (v & 7));
+		len = cast(usize)(digits + sizeof(digits) - at);
+		MemMove(digits, at, len);
+	}
+	else if (magnitude)
+	{
+		len = u64_to_chars(digits, magnitude);
+	}
+
+	// ~geb: C rule, precision is the minimum digit count and "%.0d" of 0 is empty
+	usize precision = spec.precision >= 0 ? cast(usize)spec.precision : 1;
+	usize zeros     = precision > len ? precision - len : 0;
+
+	u8 prefix_buf[2];
+	String8 prefix = { .str = prefix_buf };
+	if (negative)
+		prefix_buf[prefix.len++] = '-';
+	else if (spec.flags & Fmt_Flag_Plus && (conv == 'd' || conv == 'i'))
+		prefix_buf[prefix.len++] = '+';
+	else if (spec.flags & Fmt_Flag_Space && (conv == 'd' || conv == 'i'))
+		prefix_buf[prefix.len++] = ' ';
+
+	if (conv == 'p' || ((spec.flags & Fmt_Flag_Alt) && magnitude && (conv == 'x' || conv == 'X')))
+	{
+		prefix_buf[prefix.len++] = '0';
+		prefix_buf[prefix.len++] = conv == 'X' ? 'X' : 'x';
+	}
+	else if ((spec.flags & Fmt_Flag_Alt) && conv == 'o' && zeros == 0 && (len == 0 || digits[0] != '0'))
+	{
+		zeros = 1;
+	}
+
+	bool zero_pad = (spec.flags & Fmt_Flag_Zero) && spec.precision < 0;
+	usize body_len = zeros + len;
+
+	fmt_pad_begin(sink, spec, prefix, body_len, zero_pad);
+	fmt_fill(sink, '0', zeros);
+	fmt_push(sink, digits, len);
+	fmt_pad_end(sink, spec, prefix, body_len);
+}
+
+// ~geb: digit at decimal position i (0 is the first digit after the point)
+force_inline u8
+fmt_decimal_digit(Fmt_Decimal *dec, i32 position)
+{
+	i32 index = dec->point + position;
+	return (index >= 0 && index < dec->len) ? dec->digits[index] : '0';
+}
+
+internal usize
+fmt_fixed_len(Fmt_Decimal *dec, i32 frac_digits, bool force_point)
+{
+	usize int_len = dec->point > 0 ? cast(usize)dec->point : 1;
+	return int_len + ((frac_digits > 0 || force_point) ? 1 + cast(usize)frac_digits : 0);
+}
+
+internal void
+fmt_fixed_emit(Fmt_Sink *sink, Fmt_Decimal *dec, i32 frac_digits, bool force_point)
+{
+	if (dec->point <= 0)
+	{
+		fmt_fill(sink, '0', 1);
+	}
+	else
+	{
+		i32 from_digits = Min(dec->point, dec->len);
+		fmt_push(sink, dec->digits, cast(usize)from_digits);
+		fmt_fill(sink, '0', cast(usize)(dec->point - from_digits));
+	}
+
+	if (frac_digits > 0 || force_point)
+		fmt_fill(sink, '.', 1);
+
+	i32 i = 0;
+	for (; i < frac_digits && dec->point + i < 0; ++i)
+		fmt_fill(sink, '0', 1);
+
+	i32 digits_end = Min(frac_digits, dec->len - dec->point);
+	if (i < digits_end)
+	{
+		fmt_push(sink, dec->digits + dec->point + i, cast(usize)(digits_end - i));
+		i = digits_end;
+	}
+
+	if (i < frac_digits)
+		fmt_fill(sink, '0', cast(usize)(frac_digits - i));
+}
+
+internal usize
+fmt_exponent_len(Fmt_Decimal *dec, i32 frac_digits, bool force_point)
+{
+	i32 exponent  = dec->len ? dec->point - 1 : 0;
+	u32 magnitude = cast(u32)Abs(exponent);
+	usize exp_len = Max(2, u64_digit_count(magnitude));
+	return 1 + ((frac_digits > 0 || force_point) ? 1 + cast(usize)frac_digits : 0) + 2 + exp_len;
+}
+
+internal void
+fmt_exponent_emit(Fmt_Sink *sink, Fmt_Decimal *dec, i32 frac_digits, bool force_point, bool upper)
+{
+	u8 lead = dec->len ? dec->digits[0] : '0';
+	fmt_push(sink, &lead, 1);
+
+	if (frac_digits > 0 || force_point)
+		fmt_fill(sink, '.', 1);
+
+	i32 from_digits = Min(frac_digits, dec->len > 0 ? dec->len - 1 : 0);
+	fmt_push(sink, dec->digits + 1, cast(usize)from_digits);
+	fmt_fill(sink, '0', cast(usize)(frac_digits - from_digits));
+
+	i32 exponent = dec->len ? dec->point - 1 : 0;
+	u8 tail[8];
+	usize tail_len = 0;
+	tail[tail_len++] = upper ? 'E' : 'e';
+	tail[tail_len++] = exponent < 0 ? '-' : '+';
+	u32 magnitude = cast(u32)Abs(exponent);
+	if (magnitude < 10)
+		tail[tail_len++] = '0';
+	tail_len += u64_to_chars(tail + tail_len, magnitude);
+	fmt_push(sink, tail, tail_len);
+}
+
+internal void
+fmt_float(Fmt_Sink *sink, Fmt_Spec spec, f64 value, u8 conv)
+{
+	u64 bits;
+	MemCopy(&bits, &value, sizeof(bits));
+
+	bool upper = conv == 'F' || conv == 'E' || conv == 'G';
+	u8 sign = 0;
+	if (bits >> 63)
+		sign = '-';
+	else if (spec.flags & Fmt_Flag_Plus)
+		sign = '+';
+	else if (spec.flags & Fmt_Flag_Space)
+		sign = ' ';
+
+	String8 prefix = { .str = &sign, .len = sign ? 1 : 0 };
+
+	if ((bits & 0x7ff0000000000000ull) == 0x7ff0000000000000ull)
+	{
+		bool nan = (bits & 0x000fffffffffffffull) != 0;
+		String8 body = nan ? (upper ? S("NAN") : S("nan")) : (upper ? S("INF") : S("inf"));
+		fmt_pad_begin(sink, spec, prefix, body.len, false);
+		fmt_push(sink, body.str, body.len);
+		fmt_pad_end(sink, spec, prefix, body.len);
+		return;
+	}
+
+	u8 digits[FMT_DECIMAL_EXACT];
+	Fmt_Decimal dec = fmt_decimal_from_f64(value, digits);
+	i32  precision   = spec.precision >= 0 ? spec.precision : 6;
+	bool force_point = MaskCheck(spec.flags, Fmt_Flag_Alt);
+	bool zero_pad    = MaskCheck(spec.flags, Fmt_Flag_Zero);
+	bool exponential = false;
+	i32  frac_digits = precision;
+
+	// ~geb: the shortest digits round trip but need not be the
+	//       nearest ones of their length, so unless rounding drops
+	//       some of them the exact digits take over
+	switch (conv)
+	{
+	case 'f':
+	case 'F':
+		if (dec.point + precision >= dec.len)
+			fmt_decimal_exact(&dec);
+		fmt_decimal_round(&dec, dec.point + precision);
+		break;
+
+	case 'e':
+	case 'E':
+		if (precision + 1 >= dec.len)
+			fmt_decimal_exact(&dec);
+		fmt_decimal_round(&dec, precision + 1);
+		exponential = true;
+		break;
+
+	default: // g, G
+	{
+		if (precision == 0)
+			precision = 1;
+
+		if (precision >= dec.len)
+			fmt_decimal_exact(&dec);
+		fmt_decimal_round(&dec, precision);
+		i32 exponent = dec.len ? dec.point - 1 : 0;
+
+		exponential = !(precision > exponent && exponent >= -4);
+		frac_digits = exponential ? precision - 1 : precision - 1 - exponent;
+
+		if (!force_point)
+		{
+			i32 needed = exponential ? dec.len - 1 : dec.len - dec.point;
+			frac_digits = Clamp(0, needed, frac_digits);
+		}
+	} break;
+	}
+
+	usize body_len = exponential ?
+		fmt_exponent_len(&dec, frac_digits, force_point) :
+		fmt_fixed_len(&dec, frac_digits, force_point);
+
+	fmt_pad_begin(sink, spec, prefix, body_len, zero_pad);
+	if (exponential)
+		fmt_exponent_emit(sink, &dec, frac_digits, force_point, upper);
+	else
+		fmt_fixed_emit(sink, &dec, frac_digits, force_point);
+	fmt_pad_end(sink, spec, prefix, body_len);
+}
+
+internal usize
+str8_fmtv(u8 *buffer, usize capacity, const char *fmt, va_list args)
+{
+	Fmt_Sink sink = {
+		.buffer   = buffer,
+		.capacity = buffer ? capacity : 0,
+	};
+
+	const char *at = fmt;
+	while (*at)
+	{
+		const char *run = at;
+		while (*at && *at != '%')
+			at += 1;
+		if (at != run)
+			fmt_push(&sink, run, cast(usize)(at - run));
+		if (!*at)
+			break;
+
+		const char *spec_begin = at;
+		at += 1;
+
+		Fmt_Spec spec = { .precision = -1 };
+		for (;; ++at)
+		{
+			if      (*at == '-') spec.flags |= Fmt_Flag_Left;
+			else if (*at == '+') spec.flags |= Fmt_Flag_Plus;
+			else if (*at == ' ') spec.flags |= Fmt_Flag_Space;
+			else if (*at == '#') spec.flags |= Fmt_Flag_Alt;
+			else if (*at == '0') spec.flags |= Fmt_Flag_Zero;
+			else break;
+		}
+
+		if (*at == '*')
+		{
+			spec.width = va_arg(args, int);
+			if (spec.width < 0)
+			{
+				spec.flags |= Fmt_Flag_Left;
+				spec.width  = -spec.width;
+			}
+			at += 1;
+		}
+		else
+		{
+			while (*at >= '0' && *at <= '9')
+				spec.width = spec.width * 10 + (*at++ - '0');
+		}
+
+		if (*at == '.')
+		{
+			at += 1;
+			spec.precision = 0;
+			if (*at == '*')
+			{
+				spec.precision = va_arg(args, int);
+				if (spec.precision < 0)
+					spec.precision = -1;
+				at += 1;
+			}
+			else
+			{
+				while (*at >= '0' && *at <= '9')
+					spec.precision = spec.precision * 10 + (*at++ - '0');
+			}
+		}
+
+		if (spec.flags & Fmt_Flag_Left)
+			spec.flags &= ~Fmt_Flag_Zero;
+
+		Fmt_Length length = Fmt_Length_None;
+		switch (*at)
+		{
+		case 'h': length = at[1] == 'h' ? Fmt_Length_hh : Fmt_Length_h; at += length == Fmt_Length_hh ? 2 : 1; break;
+		case 'l': length = at[1] == 'l' ? Fmt_Length_ll : Fmt_Length_l; at += length == Fmt_Length_ll ? 2 : 1; break;
+		case 'z': length = Fmt_Length_z; at += 1; break;
+		case 'j': length = Fmt_Length_j; at += 1; break;
+		case 't': length = Fmt_Length_t; at += 1; break;
+		}
+
+		u8 conv = cast(u8)*at;
+		if (conv)
+			at += 1;
+
+		switch (conv)
+		{
+		case 'd':
+		case 'i':
+		{
+			i64 value = 0;
+			switch (length)
+			{
+			case Fmt_Length_hh:   value = cast(signed char)va_arg(args, int); break;
+			case Fmt_Length_h:    value = cast(short)va_arg(args, int);       break;
+			case Fmt_Length_l:    value = va_arg(args, long);                 break;
+			case Fmt_Length_ll:   value = va_arg(args, long long);            break;
+			case Fmt_Length_j:    value = va_arg(args, i64);                  break;
+			case Fmt_Length_z:
+			case Fmt_Length_t:    value = va_arg(args, isize);                break;
+			case Fmt_Length_None: value = va_arg(args, int);                  break;
+			}
+			u64 magnitude = value < 0 ? 0 - cast(u64)value : cast(u64)value;
+			fmt_integer(&sink, spec, magnitude, value < 0, 'd');
+		} break;
+
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'o':
+		{
+			u64 value = 0;
+			switch (length)
+			{
+			case Fmt_Length_hh:   value = cast(unsigned char)va_arg(args, unsigned int);  break;
+			case Fmt_Length_h:    value = cast(unsigned short)va_arg(args, unsigned int); break;
+			case Fmt_Length_l:    value = va_arg(args, unsigned long);                    break;
+			case Fmt_Length_ll:   value = va_arg(args, unsigned long long);               break;
+			case Fmt_Length_j:    value = va_arg(args, u64);                              break;
+			case Fmt_Length_z:
+			case Fmt_Length_t:    value = va_arg(args, usize);                            break;
+			case Fmt_Length_None: value = va_arg(args, unsigned int);                     break;
+			}
+			fmt_integer(&sink, spec, value, false, conv);
+		} break;
+
+		case 'p':
+		{
+			usize value = cast(usize)va_arg(args, void *);
+			fmt_integer(&sink, spec, value, false, 'p');
+		} break;
+
+		case 'c':
+		{
+			u8 c = cast(u8)va_arg(args, int);
+			String8 string = { .str = &c, .len = 1 };
+			spec.precision = -1;
+			fmt_string(&sink, spec, string);
+		} break;
+
+		case 's':
+		{
+			const char *cstring = va_arg(args, const char *);
+			if (!cstring)
+				cstring = "(null)";
+
+			String8 string = { .str = cast(u8 *)cstring };
+			if (spec.precision >= 0)
+			{
+				const char *end = memchr(cstring, 0, cast(usize)spec.precision);
+				string.len = end ? cast(usize)(end - cstring) : cast(usize)spec.precision;
+			}
+			else
+			{
+				string.len = MemStrlen(cstring);
+			}
+			fmt_string(&sink, spec, string);
+		} break;
+
+		case 'S':
+		{
+			String8 string = va_arg(args, String8);
+			fmt_string(&sink, spec, string);
+		} break;
+
+		case 'f':
+		case 'F':
+		case 'e':
+		case 'E':
+		case 'g':
+		case 'G':
+		{
+			f64 value = va_arg(args, f64);
+			fmt_float(&sink, spec, value, conv);
+		} break;
+
+		case '%':
+		{
+			fmt_push(&sink, "%", 1);
+		} break;
+
+		default:
+		{
+			// ~geb: unknown conversion, print it as written
+			fmt_push(&sink, spec_begin, cast(usize)(at - spec_begin));
+		} break;
+		}
+	}
+
+	return sink.len;
+}
+
+internal usize
+str8_fmt(u8 *buffer, usize capacity, const char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	usize len = str8_fmtv(buffer, capacity, fmt, args);
+	va_end(args);
+	return len;
+}
+
+// ~geb: the result is nul terminated (not counted in len) so it
+//       can be handed to C apis as is.
+internal String8
+str8_pushfv(Allocator alloc, const char *fmt, va_list args)
+{
+	u8 stack[512];
+
+	va_list args_copy;
+	va_copy(args_copy, args);
+
+	usize len = str8_fmtv(stack, sizeof(stack), fmt, args);
+
+	Alloc_Error err = 0;
+	u8 *mem = mem_alloc_aligned(alloc, len + 1, 1, false, &err);
+	if (!mem || err)
+	{
+		va_end(args_copy);
+		return S("");
+	}
+
+	if (len <= sizeof(stack))
+		MemCopy(mem, stack, len);
+	else
+		str8_fmtv(mem, len, fmt, args_copy);
+	mem[len] = 0;
+
+	va_end(args_copy);
+
+	String8 result = {
+		.str = mem,
+		.len = len};
+	return result;
+}
+
+internal String8
+str8_pushf(Allocator alloc, const char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	String8 result = str8_pushfv(alloc, fmt, args);
+	va_end(args);
+	return result;
+}
+
+/////////////////////////////////////////////////////////////////////////
+//                         NUMBER PARSING                              //
+/////////////////////////////////////////////////////////////////////////
+
+force_inline u64
+u128_mul(u64 a, u64 b, u64 *hi)
+{
+#if COMPILER_MSVC
+	return _umul128(a, b, hi);
+#else
+	unsigned __int128 product = cast(unsigned __int128)a * b;
+	*hi = cast(u64)(product >> 64);
+	return cast(u64)product;
+#endif
+}
+
+force_inline bool
+parse_is_digit(u8 c)
+{
+	return cast(u8)(c - '0') < 10;
+}
+
+// ~geb: SWAR, eight ascii digits in one little endian word
+force_inline bool
+parse_is_8_digits(u64 word)
+{
+	return (((word & 0xf0f0f0f0f0f0f0f0ull) |
+			 (((word + 0x0606060606060606ull) & 0xf0f0f0f0f0f0f0f0ull) >> 4)) ==
+			0x3333333333333333ull);
+}
+
+force_inline u32
+parse_8_digits(u64 word)
+{
+	u64 mask = 0x000000ff000000ffull;
+	u64 mul1 = 0x000f424000000064ull; // 100 + (1000000 << 32)
+	u64 mul2 = 0x0000271000000001ull; // 1 + (10000 << 32)
+
+	word -= 0x3030303030303030ull;
+	word  = (word * 10) + (word >> 8);
+	word  = (((word & mask) * mul1) + (((word >> 16) & mask) * mul2)) >> 32;
+	return cast(u32)word;
+}
+
+// ~geb: consumes digits into value, returns the digit count. value
+//       wraps past nineteen digits, callers recount from the text
+force_inline usize
+parse_digits(u8 *p, u8 *end, u64 *value)
+{
+	u8 *start = p;
+	u64 v = *value;
+
+	while (end - p >= 8)
+	{
+		u64 word;
+		MemCopy(&word, p, 8);
+		if (!parse_is_8_digits(word))
+			break;
+		v = v * 100000000ull + parse_8_digits(word);
+		p += 8;
+	}
+
+	while (p < end && parse_is_digit(*p))
+	{
+		v = v * 10 + cast(u64)(*p - '0');
+		p += 1;
+	}
+
+	*value = v;
+	return cast(usize)(p - start);
+}
+
+internal usize
+_parse_u64_digits(u8 *p, u8 *end, u64 *out, Parse_Error *err)
+{
+	u8 *start = p;
+	while (p < end && *p == '0')
+		p += 1;
+
+	u8 *significant = p;
+	u8 *fast_end    = significant + Min(cast(usize)(end - significant), 19);
+
+	u64 value = 0;
+	p += parse_digits(p, fast_end, &value);
+
+	// ~geb: nineteen digits always fit, the twentieth might not
+	bool overflow = false;
+	while (p < end && parse_is_digit(*p))
+	{
+		u64 d = cast(u64)(*p - '0');
+		if (overflow || value > (U64_MAX - d) / 10)
+			overflow = true;
+		else
+			value = value * 10 + d;
+		p += 1;
+	}
+
+	if (p == start)
+	{
+		*err = Parse_Err_Invalid;
+		return 0;
+	}
+
+	if (overflow)
+	{
+		*err  = Parse_Err_Overflow;
+		value = U64_MAX;
+	}
+
+	*out = value;
+	return cast(usize)(p - start);
+}
+
+internal usize
+str8_parse_u64(String8 string, u64 *out, Parse_Error *err)
+{
+	Parse_Error dummy;
+	if (!err)
+		err = &dummy;
+	*err = Parse_Err_None;
+
+	u8 *p   = string.str;
+	u8 *end = string.str + string.len;
+	if (p < end && *p == '+')
+		p += 1;
+
+	u64 value = 0;
+	usize digits = _parse_u64_digits(p, end, &value, err);
+	if (!digits)
+	{
+		*err = Parse_Err_Invalid;
+		return 0;
+	}
+
+	if (out)
+		*out = value;
+	return cast(usize)(p - string.str) + digits;
+}
+
+internal usize
+str8_parse_i64(String8 string, i64 *out, Parse_Error *err)
+{
+	Parse_Error dummy;
+	if (!err)
+		err = &dummy;
+	*err = Parse_Err_None;
+
+	u8 *p   = string.str;
+	u8 *end = string.str + string.len;
+
+	bool negative = false;
+	if (p < end && (*p == '+' || *p == '-'))
+	{
+		negative = *p == '-';
+		p += 1;
+	}
+
+	u64 magnitude = 0;
+	usize digits = _parse_u64_digits(p, end, &magnitude, err);
+	if (!digits)
+	{
+		*err = Parse_Err_Invalid;
+		return 0;
+	}
+
+	u64 limit = negative ? cast(u64)I64_MAX + 1 : cast(u64)I64_MAX;
+	if (magnitude > limit)
+	{
+		*err = Parse_Err_Overflow;
+		magnitude = limit;
+	}
+
+	if (out)
+		*out = negative ? cast(i64)(0 - magnitude) : cast(i64)magnitude;
+	return cast(usize)(p - string.str) + digits;
+}
+
+// ~geb: floats. Clinger's exact fast path first, then Eisel-Lemire
+//       (Lemire, "Number Parsing at a Gigabyte per Second") with a
+//       128-bit table of powers of five. Only inputs with more than
+//       nineteen significant digits that land on a rounding boundary
+//       are settled exactly, all their digits against the halfway
+//       point between the two candidates in a bignum.
+
+#define PARSE_POW5_MIN_EXPONENT -342
+#define PARSE_POW5_MAX_EXPONENT 308
+
+global const u64 PARSE_POW5_128[2 * (PARSE_POW5_MAX_EXPONENT - PARSE_POW5_MIN_EXPONENT + 1)] = {
+	0xeef453d6923bd65aull, 0x113faa2906a13b3full, 0x9558b4661b6565f8ull, 0x4ac7ca59a424c507ull,
+	0xbaaee17fa23ebf76ull, 0x5d79bcf00d2df649ull, 0xe95a99df8ace6f53ull, 0xf4d82c2c107973dcull,
+	0x91d8a02bb6c10594ull, 0x79071b9b8a4be869ull, 0xb64ec836a47146f9ull, 0x9748e2826cdee284ull,
+	0xe3e27a444d8d98b7ull, 0xfd1b1b2308169b25ull, 0x8e6d8c6ab0787f72ull, 0xfe30f0f5e50e20f7ull,
+	0xb208ef855c969f4full, 0xbdbd2d335e51a935ull, 0xde8b2b66b3bc4723ull, 0xad2c788035e61382ull,
+	0x8b16fb203055ac76ull, 0x4c3bcb5021afcc31ull, 0xaddcb9e83c6b1793ull, 0xdf4abe242a1bbf3dull,
+	0xd953e8624b85dd78ull, 0xd71d6dad34a2af0dull, 0x87d4713d6f33aa6bull, 0x8672648c40e5ad68ull,
+	0xa9c98d8ccb009506ull, 0x680efdaf511f18c2ull, 0xd43bf0effdc0ba48ull, 0x0212bd1b2566def2ull,
+	0x84a57695fe98746dull, 0x014bb630f7604b57ull, 0xa5ced43b7e3e9188ull, 0x419ea3bd35385e2dull,
+	0xcf42894a5dce35eaull, 0x52064cac828675b9ull, 0x818995ce7aa0e1b2ull, 0x7343efebd1940993ull,
+	0xa1ebfb4219491a1full, 0x1014ebe6c5f90bf8ull, 0xca66fa129f9b60a6ull, 0xd41a26e077774ef6ull,
+	0xfd00b897478238d0ull, 0x8920b098955522b4ull, 0x9e20735e8cb16382ull, 0x55b46e5f5d5535b0ull,
+	0xc5a890362fddbc62ull, 0xeb2189f734aa831dull, 0xf712b443bbd52b7bull, 0xa5e9ec7501d523e4ull,
+	0x9a6bb0aa55653b2dull, 0x47b233c92125366eull, 0xc1069cd4eabe89f8ull, 0x999ec0bb696e840aull,
+	0xf148440a256e2c76ull, 0xc00670ea43ca250dull, 0x96cd2a865764dbcaull, 0x380406926a5e5728ull,
+	0xbc807527ed3e12bcull, 0xc605083704f5ecf2ull, 0xeba09271e88d976bull, 0xf7864a44c633682eull,
+	0x93445b8731587ea3ull, 0x7ab3ee6afbe0211dull, 0xb8157268fdae9e4cull, 0x5960ea05bad82964ull,
+	0xe61acf033d1a45dfull, 0x6fb92487298e33bdull, 0x8fd0c16206306babull, 0xa5d3b6d479f8e056ull,
+	0xb3c4f1ba87bc8696ull, 0x8f48a4899877186cull, 0xe0b62e2929aba83cull, 0x331acdabfe94de87ull,
+	0x8c71dcd9ba0b4925ull, 0x9ff0c08b7f1d0b14ull, 0xaf8e5410288e1b6full, 0x07ecf0ae5ee44dd9ull,
+	0xdb71e91432b1a24aull, 0xc9e82cd9f69d6150ull, 0x892731ac9faf056eull, 0xbe311c083a225cd2ull,
+	0xab70fe17c79ac6caull, 0x6dbd630a48aaf406ull, 0xd64d3d9db981787dull, 0x092cbbccdad5b108ull,
+	0x85f0468293f0eb4eull, 0x25bbf56008c58ea5ull, 0xa76c582338ed2621ull, 0xaf2af2b80af6f24eull,
+	0xd1476e2c07286faaull, 0x1af5af660db4aee1ull, 0x82cca4db847945caull, 0x50d98d9fc890ed4dull,
+	0xa37fce126597973cull, 0xe50ff107bab528a0ull, 0xcc5fc196fefd7d0cull, 0x1e53ed49a96272c8ull,
+	0xff77b1fcbebcdc4full, 0x25e8e89c13bb0f7aull, 0x9faacf3df73609b1ull, 0x77b191618c54e9acull,
+	0xc795830d75038c1dull, 0xd59df5b9ef6a2417ull, 0xf97ae3d0d2446f25ull, 0x4b0573286b44ad1dull,
+	0x9becce62836ac577ull, 0x4ee367f9430aec32ull, 0xc2e801fb244576d5ull, 0x229c41f793cda73full,
+	0xf3a20279ed56d48aull, 0x6b43527578c1110full, 0x9845418c345644d6ull, 0x830a13896b78aaa9ull,
+	0xbe5691ef416bd60cull, 0x23cc986bc656d553ull, 0xedec366b11c6cb8full, 0x2cbfbe86b7ec8aa8ull,
+	0x94b3a202eb1c3f39ull, 0x7bf7d71432f3d6a9ull, 0xb9e08a83a5e34f07ull, 0xdaf5ccd93fb0cc53ull,
+	0xe858ad248f5c22c9ull, 0xd1b3400f8f9cff68ull, 0x91376c36d99995beull, 0x23100809b9c21fa1ull,
+	0xb58547448ffffb2dull, 0xabd40a0c2832a78aull, 0xe2e69915b3fff9f9ull, 0x16c90c8f323f516cull,
+	0x8dd01fad907ffc3bull, 0xae3da7d97f6792e3ull, 0xb1442798f49ffb4aull, 0x99cd11cfdf41779cull,
+	0xdd95317f31c7fa1dull, 0x40405643d711d583ull, 0x8a7d3eef7f1cfc52ull, 0x482835ea666b2572ull,
+	0xad1c8eab5ee43b66ull, 0xda3243650005eecfull, 0xd863b256369d4a40ull, 0x90bed43e40076a82ull,
+	0x873e4f75e2224e68ull, 0x5a7744a6e804a291ull, 0xa90de3535aaae202ull, 0x711515d0a205cb36ull,
+	0xd3515c2831559a83ull, 0x0d5a5b44ca873e03ull, 0x8412d9991ed58091ull, 0xe858790afe9486c2ull,
+	0xa5178fff668ae0b6ull, 0x626e974dbe39a872ull, 0xce5d73ff402d98e3ull, 0xfb0a3d212dc8128full,
+	0x80fa687f881c7f8eull, 0x7ce66634bc9d0b99ull, 0xa139029f6a239f72ull, 0x1c1fffc1ebc44e80ull,
+	0xc987434744ac874eull, 0xa327ffb266b56220ull, 0xfbe9141915d7a922ull, 0x4bf1ff9f0062baa8ull,
+	0x9d71ac8fada6c9b5ull, 0x6f773fc3603db4a9ull, 0xc4ce17b399107c22ull, 0xcb550fb4384d21d3ull,
+	0xf6019da07f549b2bull, 0x7e2a53a146606a48ull, 0x99c102844f94e0fbull, 0x2eda7444cbfc426dull,
+	0xc0314325637a1939ull, 0xfa911155fefb5308ull, 0xf03d93eebc589f88ull, 0x793555ab7eba27caull,
+	0x96267c7535b763b5ull, 0x4bc1558b2f3458deull, 0xbbb01b9283253ca2ull, 0x9eb1aaedfb016f16ull,
+	0xea9c227723ee8bcbull, 0x465e15a979c1cadcull, 0x92a1958a7675175full, 0x0bfacd89ec191ec9ull,
+	0xb749faed14125d36ull, 0xcef980ec671f667bull, 0xe51c79a85916f484ull, 0x82b7e12780e7401aull,
+	0x8f31cc0937ae58d2ull, 0xd1b2ecb8b0908810ull, 0xb2fe3f0b8599ef07ull, 0x861fa7e6dcb4aa15ull,
+	0xdfbdcece67006ac9ull, 0x67a791e093e1d49aull, 0x8bd6a141006042bdull, 0xe0c8bb2c5c6d24e0ull,
+	0xaecc49914078536dull, 0x58fae9f773886e18ull, 0xda7f5bf590966848ull, 0xaf39a475506a899eull,
+	0x888f99797a5e012dull, 0x6d8406c952429603ull, 0xaab37fd7d8f58178ull, 0xc8e5087ba6d33b83ull,
+	0xd5605fcdcf32e1d6ull, 0xfb1e4a9a90880a64ull, 0x855c3be0a17fcd26ull, 0x5cf2eea09a55067full,
+	0xa6b34ad8c9dfc06full, 0xf42faa48c0ea481eull, 0xd0601d8efc57b08bull, 0xf13b94daf124da26ull,
+	0x823c12795db6ce57ull, 0x76c53d08d6b70858ull, 0xa2cb1717b52481edull, 0x54768c4b0c64ca6eull,
+	0xcb7ddcdda26da268ull, 0xa9942f5dcf7dfd09ull, 0xfe5d54150b090b02ull, 0xd3f93b35435d7c4cull,
+	0x9efa548d26e5a6e1ull, 0xc47bc5014a1a6dafull, 0xc6b8e9b0709f109aull, 0x359ab6419ca1091bull,
+	0xf867241c8cc6d4c0ull, 0xc30163d203c94b62ull, 0x9b407691d7fc44f8ull, 0x79e0de63425dcf1dull,
+	0xc21094364dfb5636ull, 0x985915fc12f542e4ull, 0xf294b943e17a2bc4ull, 0x3e6f5b7b17b2939dull,
+	0x979cf3ca6cec5b5aull, 0xa705992ceecf9c42ull, 0xbd8430bd08277231ull, 0x50c6ff782a838353ull,
+	0xece53cec4a314ebdull, 0xa4f8bf5635246428ull, 0x940f4613ae5ed136ull, 0x871b7795e136be99ull,
+	0xb913179899f68584ull, 0x28e2557b59846e3full, 0xe757dd7ec07426e5ull, 0x331aeada2fe589cfull,
+	0x9096ea6f3848984full, 0x3ff0d2c85def7621ull, 0xb4bca50b065abe63ull, 0x0fed077a756b53a9ull,
+	0xe1ebce4dc7f16dfbull, 0xd3e8495912c62894ull, 0x8d3360f09cf6e4bdull, 0x64712dd7abbbd95cull,
+	0xb080392cc4349decull, 0xbd8d794d96aacfb3ull, 0xdca04777f541c567ull, 0xecf0d7a0fc5583a0ull,
+	0x89e42caaf9491b60ull, 0xf41686c49db57244ull, 0xac5d37d5b79b6239ull, 0x311c2875c522ced5ull,
+	0xd77485cb25823ac7ull, 0x7d633293366b828bull, 0x86a8d39ef77164bcull, 0xae5dff9c02033197ull,
+	0xa8530886b54dbdebull, 0xd9f57f830283fdfcull, 0xd267caa862a12d66ull, 0xd072df63c324fd7bull,
+	0x8380dea93da4bc60ull, 0x4247cb9e59f71e6dull, 0xa46116538d0deb78ull, 0x52d9be85f074e608ull,
+	0xcd795be870516656ull, 0x67902e276c921f8bull, 0x806bd9714632dff6ull, 0x00ba1cd8a3db53b6ull,
+	0xa086cfcd97bf97f3ull, 0x80e8a40eccd228a4ull, 0xc8a883c0fdaf7df0ull, 0x6122cd128006b2cdull,
+	0xfad2a4b13d1b5d6cull, 0x796b805720085f81ull, 0x9cc3a6eec6311a63ull, 0xcbe3303674053bb0ull,
+	0xc3f490aa77bd60fcull, 0xbedbfc4411068a9cull, 0xf4f1b4d515acb93bull, 0xee92fb5515482d44ull,
+	0x991711052d8bf3c5ull, 0x751bdd152d4d1c4aull, 0xbf5cd54678eef0b6ull, 0xd262d45a78a0635dull,
+	0xef340a98172aace4ull, 0x86fb897116c87c34ull, 0x9580869f0e7aac0eull, 0xd45d35e6ae3d4da0ull,
+	0xbae0a846d2195712ull, 0x8974836059cca109ull, 0xe998d258869facd7ull, 0x2bd1a438703fc94bull,
+	0x91ff83775423cc06ull, 0x7b6306a34627ddcfull, 0xb67f6455292cbf08ull, 0x1a3bc84c17b1d542ull,
+	0xe41f3d6a7377eecaull, 0x20caba5f1d9e4a93ull, 0x8e938662882af53eull, 0x547eb47b7282ee9cull,
+	0xb23867fb2a35b28dull, 0xe99e619a4f23aa43ull, 0xdec681f9f4c31f31ull, 0x6405fa00e2ec94d4ull,
+	0x8b3c113c38f9f37eull, 0xde83bc408dd3dd04ull, 0xae0b158b4738705eull, 0x9624ab50b148d445ull,
+	0xd98ddaee19068c76ull, 0x3badd624dd9b0957ull, 0x87f8a8d4cfa417c9ull, 0xe54ca5d70a80e5d6ull,
+	0xa9f6d30a038d1dbcull, 0x5e9fcf4ccd211f4cull, 0xd47487cc8470652bull, 0x7647c3200069671full,
+	0x84c8d4dfd2c63f3bull, 0x29ecd9f40041e073ull, 0xa5fb0a17c777cf09ull, 0xf468107100525890ull,
+	0xcf79cc9db955c2ccull, 0x7182148d4066eeb4ull, 0x81ac1fe293d599bfull, 0xc6f14cd848405530ull,
+	0xa21727db38cb002full, 0xb8ada00e5a506a7cull, 0xca9cf1d206fdc03bull, 0xa6d90811f0e4851cull,
+	0xfd442e4688bd304aull, 0x908f4a166d1da663ull, 0x9e4a9cec15763e2eull, 0x9a598e4e043287feull,
+	0xc5dd44271ad3cdbaull, 0x40eff1e1853f29fdull, 0xf7549530e188c128ull, 0xd12bee59e68ef47cull,
+	0x9a94dd3e8cf578b9ull, 0x82bb74f8301958ceull, 0xc13a148e3032d6e7ull, 0xe36a52363c1faf01ull,
+	0xf18899b1bc3f8ca1ull, 0xdc44e6c3cb279ac1ull, 0x96f5600f15a7b7e5ull, 0x29ab103a5ef8c0b9ull,
+	0xbcb2b812db11a5deull, 0x7415d448f6b6f0e7ull, 0xebdf661791d60f56ull, 0x111b495b3464ad21ull,
+	0x936b9fcebb25c995ull, 0xcab10dd900beec34ull, 0xb84687c269ef3bfbull, 0x3d5d514f40eea742ull,
+	0xe65829b3046b0afaull, 0x0cb4a5a3112a5112ull, 0x8ff71a0fe2c2e6dcull, 0x47f0e785eaba72abull,
+	0xb3f4e093db73a093ull, 0x59ed216765690f56ull, 0xe0f218b8d25088b8ull, 0x306869c13ec3532cull,
+	0x8c974f7383725573ull, 0x1e414218c73a13fbull, 0xafbd2350644eeacfull, 0xe5d1929ef90898faull,
+	0xdbac6c247d62a583ull, 0xdf45f746b74abf39ull, 0x894bc396ce5da772ull, 0x6b8bba8c328eb783ull,
+	0xab9eb47c81f5114full, 0x066ea92f3f326564ull, 0xd686619ba27255a2ull, 0xc80a537b0efefebdull,
+	0x8613fd0145877585ull, 0xbd06742ce95f5f36ull, 0xa798fc4196e952e7ull, 0x2c48113823b73704ull,
+	0xd17f3b51fca3a7a0ull, 0xf75a15862ca504c5ull, 0x82ef85133de648c4ull, 0x9a984d73dbe722fbull,
+	0xa3ab66580d5fdaf5ull, 0xc13e60d0d2e0ebbaull, 0xcc963fee10b7d1b3ull, 0x318df905079926a8ull,
+	0xffbbcfe994e5c61full, 0xfdf17746497f7052ull, 0x9fd561f1fd0f9bd3ull, 0xfeb6ea8bedefa633ull,
+	0xc7caba6e7c5382c8ull, 0xfe64a52ee96b8fc0ull, 0xf9bd690a1b68637bull, 0x3dfdce7aa3c673b0ull,
+	0x9c1661a651213e2dull, 0x06bea10ca65c084eull, 0xc31bfa0fe5698db8ull, 0x486e494fcff30a62ull,
+	0xf3e2f893dec3f126ull, 0x5a89dba3c3efccfaull, 0x986ddb5c6b3a76b7ull, 0xf89629465a75e01cull,
+	0xbe89523386091465ull, 0xf6bbb397f1135823ull, 0xee2ba6c0678b597full, 0x746aa07ded582e2cull,
+	0x94db483840b717efull, 0xa8c2a44eb4571cdcull, 0xba121a4650e4ddebull, 0x92f34d62616ce413ull,
+	0xe896a0d7e51e1566ull, 0x77b020baf9c81d17ull, 0x915e2486ef32cd60ull, 0x0ace1474dc1d122eull,
+	0xb5b5ada8aaff80b8ull, 0x0d819992132456baull, 0xe3231912d5bf60e6ull, 0x10e1fff697ed6c69ull,
+	0x8df5efabc5979c8full, 0xca8d3ffa1ef463c1ull, 0xb1736b96b6fd83b3ull, 0xbd308ff8a6b17cb2ull,
+	0xddd0467c64bce4a0ull, 0xac7cb3f6d05ddbdeull, 0x8aa22c0dbef60ee4ull, 0x6bcdf07a423aa96bull,
+	0xad4ab7112eb3929dull, 0x86c16c98d2c953c6ull, 0xd89d64d57a607744ull, 0xe871c7bf077ba8b7ull,
+	0x87625f056c7c4a8bull, 0x11471cd764ad4972ull, 0xa93af6c6c79b5d2dull, 0xd598e40d3dd89bcfull,
+	0xd389b47879823479ull, 0x4aff1d108d4ec2c3ull, 0x843610cb4bf160cbull, 0xcedf722a585139baull,
+	0xa54394fe1eedb8feull, 0xc2974eb4ee658828ull, 0xce947a3da6a9273eull, 0x733d226229feea32ull,
+	0x811ccc668829b887ull, 0x0806357d5a3f525full, 0xa163ff802a3426a8ull, 0xca07c2dcb0cf26f7ull,
+	0xc9bcff6034c13052ull, 0xfc89b393dd02f0b5ull, 0xfc2c3f3841f17c67ull, 0xbbac2078d443ace2ull,
+	0x9d9ba7832936edc0ull, 0xd54b944b84aa4c0dull, 0xc5029163f384a931ull, 0x0a9e795e65d4df11ull,
+	0xf64335bcf065d37dull, 0x4d4617b5ff4a16d5ull, 0x99ea0196163fa42eull, 0x504bced1bf8e4e45ull,
+	0xc06481fb9bcf8d39ull, 0xe45ec2862f71e1d6ull, 0xf07da27a82c37088ull, 0x5d767327bb4e5a4cull,
+	0x964e858c91ba2655ull, 0x3a6a07f8d510f86full, 0xbbe226efb628afeaull, 0x890489f70a55368bull,
+	0xeadab0aba3b2dbe5ull, 0x2b45ac74ccea842eull, 0x92c8ae6b464fc96full, 0x3b0b8bc90012929dull,
+	0xb77ada0617e3bbcbull, 0x09ce6ebb40173744ull, 0xe55990879ddcaabdull, 0xcc420a6a101d0515ull,
+	0x8f57fa54c2a9eab6ull, 0x9fa946824a12232dull, 0xb32df8e9f3546564ull, 0x47939822dc96abf9ull,
+	0xdff9772470297ebdull, 0x59787e2b93bc56f7ull, 0x8bfbea76c619ef36ull, 0x57eb4edb3c55b65aull,
+	0xaefae51477a06b03ull, 0xede622920b6b23f1ull, 0xdab99e59958885c4ull, 0xe95fab368e45ecedull,
+	0x88b402f7fd75539bull, 0x11dbcb0218ebb414ull, 0xaae103b5fcd2a881ull, 0xd652bdc29f26a119ull,
+	0xd59944a37c0752a2ull, 0x4be76d3346f0495full, 0x857fcae62d8493a5ull, 0x6f70a4400c562ddbull,
+	0xa6dfbd9fb8e5b88eull, 0xcb4ccd500f6bb952ull, 0xd097ad07a71f26b2ull, 0x7e2000a41346a7a7ull,
+	0x825ecc24c873782full, 0x8ed400668c0c28c8ull, 0xa2f67f2dfa90563bull, 0x728900802f0f32faull,
+	0xcbb41ef979346bcaull, 0x4f2b40a03ad2ffb9ull, 0xfea126b7d78186bcull, 0xe2f610c84987bfa8ull,
+	0x9f24b832e6b0f436ull, 0x0dd9ca7d2df4d7c9ull, 0xc6ede63fa05d3143ull, 0x91503d1c79720dbbull,
+	0xf8a95fcf88747d94ull, 0x75a44c6397ce912aull, 0x9b69dbe1b548ce7cull, 0xc986afbe3ee11abaull,
+	0xc24452da229b021bull, 0xfbe85badce996168ull, 0xf2d56790ab41c2a2ull, 0xfae27299423fb9c3ull,
+	0x97c560ba6b0919a5ull, 0xdccd879fc967d41aull, 0xbdb6b8e905cb600full, 0x5400e987bbc1c920ull,
+	0xed246723473e3813ull, 0x290123e9aab23b68ull, 0x9436c0760c86e30bull, 0xf9a0b6720aaf6521ull,
+	0xb94470938fa89bceull, 0xf808e40e8d5b3e69ull, 0xe7958cb87392c2c2ull, 0xb60b1d1230b20e04ull,
+	0x90bd77f3483bb9b9ull, 0xb1c6f22b5e6f48c2ull, 0xb4ecd5f01a4aa828ull, 0x1e38aeb6360b1af3ull,
+	0xe2280b6c20dd5232ull, 0x25c6da63c38de1b0ull, 0x8d590723948a535full, 0x579c487e5a38ad0eull,
+	0xb0af48ec79ace837ull, 0x2d835a9df0c6d851ull, 0xdcdb1b2798182244ull, 0xf8e431456cf88e65ull,
+	0x8a08f0f8bf0f156bull, 0x1b8e9ecb641b58ffull, 0xac8b2d36eed2dac5ull, 0xe272467e3d222f3full,
+	0xd7adf884aa879177ull, 0x5b0ed81dcc6abb0full, 0x86ccbb52ea94baeaull, 0x98e947129fc2b4e9ull,
+	0xa87fea27a539e9a5ull, 0x3f2398d747b36224ull, 0xd29fe4b18e88640eull, 0x8eec7f0d19a03aadull,
+	0x83a3eeeef9153e89ull, 0x1953cf68300424acull, 0xa48ceaaab75a8e2bull, 0x5fa8c3423c052dd7ull,
+	0xcdb02555653131b6ull, 0x3792f412cb06794dull, 0x808e17555f3ebf11ull, 0xe2bbd88bbee40bd0ull,
+	0xa0b19d2ab70e6ed6ull, 0x5b6aceaeae9d0ec4ull, 0xc8de047564d20a8bull, 0xf245825a5a445275ull,
+	0xfb158592be068d2eull, 0xeed6e2f0f0d56712ull, 0x9ced737bb6c4183dull, 0x55464dd69685606bull,
+	0xc428d05aa4751e4cull, 0xaa97e14c3c26b886ull, 0xf53304714d9265dfull, 0xd53dd99f4b3066a8ull,
+	0x993fe2c6d07b7fabull, 0xe546a8038efe4029ull, 0xbf8fdb78849a5f96ull, 0xde98520472bdd033ull,
+	0xef73d256a5c0f77cull, 0x963e66858f6d4440ull, 0x95a8637627989aadull, 0xdde7001379a44aa8ull,
+	0xbb127c53b17ec159ull, 0x5560c018580d5d52ull, 0xe9d71b689dde71afull, 0xaab8f01e6e10b4a6ull,
+	0x9226712162ab070dull, 0xcab3961304ca70e8ull, 0xb6b00d69bb55c8d1ull, 0x3d607b97c5fd0d22ull,
+	0xe45c10c42a2b3b05ull, 0x8cb89a7db77c506aull, 0x8eb98a7a9a5b04e3ull, 0x77f3608e92adb242ull,
+	0xb267ed1940f1c61cull, 0x55f038b237591ed3ull, 0xdf01e85f912e37a3ull, 0x6b6c46dec52f6688ull,
+	0x8b61313bbabce2c6ull, 0x2323ac4b3b3da015ull, 0xae397d8aa96c1b77ull, 0xabec975e0a0d081aull,
+	0xd9c7dced53c72255ull, 0x96e7bd358c904a21ull, 0x881cea14545c7575ull, 0x7e50d64177da2e54ull,
+	0xaa242499697392d2ull, 0xdde50bd1d5d0b9e9ull, 0xd4ad2dbfc3d07787ull, 0x955e4ec64b44e864ull,
+	0x84ec3c97da624ab4ull, 0xbd5af13bef0b113eull, 0xa6274bbdd0fadd61ull, 0xecb1ad8aeacdd58eull,
+	0xcfb11ead453994baull, 0x67de18eda5814af2ull, 0x81ceb32c4b43fcf4ull, 0x80eacf948770ced7ull,
+	0xa2425ff75e14fc31ull, 0xa1258379a94d028dull, 0xcad2f7f5359a3b3eull, 0x096ee45813a04330ull,
+	0xfd87b5f28300ca0dull, 0x8bca9d6e188853fcull, 0x9e74d1b791e07e48ull, 0x775ea264cf55347eull,
+	0xc612062576589ddaull, 0x95364afe032a819eull, 0xf79687aed3eec551ull, 0x3a83ddbd83f52205ull,
+	0x9abe14cd44753b52ull, 0xc4926a9672793543ull, 0xc16d9a0095928a27ull, 0x75b7053c0f178294ull,
+	0xf1c90080baf72cb1ull, 0x5324c68b12dd6339ull, 0x971da05074da7beeull, 0xd3f6fc16ebca5e04ull,
+	0xbce5086492111aeaull, 0x88f4bb1ca6bcf585ull, 0xec1e4a7db69561a5ull, 0x2b31e9e3d06c32e6ull,
+	0x9392ee8e921d5d07ull, 0x3aff322e62439fd0ull, 0xb877aa3236a4b449ull, 0x09befeb9fad487c3ull,
+	0xe69594bec44de15bull, 0x4c2ebe687989a9b4ull, 0x901d7cf73ab0acd9ull, 0x0f9d37014bf60a11ull,
+	0xb424dc35095cd80full, 0x538484c19ef38c95ull, 0xe12e13424bb40e13ull, 0x2865a5f206b06fbaull,
+	0x8cbccc096f5088cbull, 0xf93f87b7442e45d4ull, 0xafebff0bcb24aafeull, 0xf78f69a51539d749ull,
+	0xdbe6fecebdedd5beull, 0xb573440e5a884d1cull, 0x89705f4136b4a597ull, 0x31680a88f8953031ull,
+	0xabcc77118461cefcull, 0xfdc20d2b36ba7c3eull, 0xd6bf94d5e57a42bcull, 0x3d32907604691b4dull,
+	0x8637bd05af6c69b5ull, 0xa63f9a49c2c1b110ull, 0xa7c5ac471b478423ull, 0x0fcf80dc33721d54ull,
+	0xd1b71758e219652bull, 0xd3c36113404ea4a9ull, 0x83126e978d4fdf3bull, 0x645a1cac083126eaull,
+	0xa3d70a3d70a3d70aull, 0x3d70a3d70a3d70a4ull, 0xccccccccccccccccull, 0xcccccccccccccccdull,
+	0x8000000000000000ull, 0x0000000000000000ull, 0xa000000000000000ull, 0x0000000000000000ull,
+	0xc800000000000000ull, 0x0000000000000000ull, 0xfa00000000000000ull, 0x0000000000000000ull,
+	0x9c40000000000000ull, 0x0000000000000000ull, 0xc350000000000000ull, 0x0000000000000000ull,
+	0xf424000000000000ull, 0x0000000000000000ull, 0x9896800000000000ull, 0x0000000000000000ull,
+	0xbebc200000000000ull, 0x0000000000000000ull, 0xee6b280000000000ull, 0x0000000000000000ull,
+	0x9502f90000000000ull, 0x0000000000000000ull, 0xba43b74000000000ull, 0x0000000000000000ull,
+	0xe8d4a51000000000ull, 0x0000000000000000ull, 0x9184e72a00000000ull, 0x0000000000000000ull,
+	0xb5e620f480000000ull, 0x0000000000000000ull, 0xe35fa931a0000000ull, 0x0000000000000000ull,
+	0x8e1bc9bf04000000ull, 0x0000000000000000ull, 0xb1a2bc2ec5000000ull, 0x0000000000000000ull,
+	0xde0b6b3a76400000ull, 0x0000000000000000ull, 0x8ac7230489e80000ull, 0x0000000000000000ull,
+	0xad78ebc5ac620000ull, 0x0000000000000000ull, 0xd8d726b7177a8000ull, 0x0000000000000000ull,
+	0x878678326eac9000ull, 0x0000000000000000ull, 0xa968163f0a57b400ull, 0x0000000000000000ull,
+	0xd3c21bcecceda100ull, 0x0000000000000000ull, 0x84595161401484a0ull, 0x0000000000000000ull,
+	0xa56fa5b99019a5c8ull, 0x0000000000000000ull, 0xcecb8f27f4200f3aull, 0x0000000000000000ull,
+	0x813f3978f8940984ull, 0x4000000000000000ull, 0xa18f07d736b90be5ull, 0x5000000000000000ull,
+	0xc9f2c9cd04674edeull, 0xa400000000000000ull, 0xfc6f7c4045812296ull, 0x4d00000000000000ull,
+	0x9dc5ada82b70b59dull, 0xf020000000000000ull, 0xc5371912364ce305ull, 0x6c28000000000000ull,
+	0xf684df56c3e01bc6ull, 0xc732000000000000ull, 0x9a130b963a6c115cull, 0x3c7f400000000000ull,
+	0xc097ce7bc90715b3ull, 0x4b9f100000000000ull, 0xf0bdc21abb48db20ull, 0x1e86d40000000000ull,
+	0x96769950b50d88f4ull, 0x1314448000000000ull, 0xbc143fa4e250eb31ull, 0x17d955a000000000ull,
+	0xeb194f8e1ae525fdull, 0x5dcfab0800000000ull, 0x92efd1b8d0cf37beull, 0x5aa1cae500000000ull,
+	0xb7abc627050305adull, 0xf14a3d9e40000000ull, 0xe596b7b0c643c719ull, 0x6d9ccd05d0000000ull,
+	0x8f7e32ce7bea5c6full, 0xe4820023a2000000ull, 0xb35dbf821ae4f38bull, 0xdda2802c8a800000ull,
+	0xe0352f62a19e306eull, 0xd50b2037ad200000ull, 0x8c213d9da502de45ull, 0x4526f422cc340000ull,
+	0xaf298d050e4395d6ull, 0x9670b12b7f410000ull, 0xdaf3f04651d47b4cull, 0x3c0cdd765f114000ull,
+	0x88d8762bf324cd0full, 0xa5880a69fb6ac800ull, 0xab0e93b6efee0053ull, 0x8eea0d047a457a00ull,
+	0xd5d238a4abe98068ull, 0x72a4904598d6d880ull, 0x85a36366eb71f041ull, 0x47a6da2b7f864750ull,
+	0xa70c3c40a64e6c51ull, 0x999090b65f67d924ull, 0xd0cf4b50cfe20765ull, 0xfff4b4e3f741cf6dull,
+	0x82818f1281ed449full, 0xbff8f10e7a8921a4ull, 0xa321f2d7226895c7ull, 0xaff72d52192b6a0dull,
+	0xcbea6f8ceb02bb39ull, 0x9bf4f8a69f764490ull, 0xfee50b7025c36a08ull, 0x02f236d04753d5b4ull,
+	0x9f4f2726179a2245ull, 0x01d762422c946590ull, 0xc722f0ef9d80aad6ull, 0x424d3ad2b7b97ef5ull,
+	0xf8ebad2b84e0d58bull, 0xd2e0898765a7deb2ull, 0x9b934c3b330c8577ull, 0x63cc55f49f88eb2full,
+	0xc2781f49ffcfa6d5ull, 0x3cbf6b71c76b25fbull, 0xf316271c7fc3908aull, 0x8bef464e3945ef7aull,
+	0x97edd871cfda3a56ull, 0x97758bf0e3cbb5acull, 0xbde94e8e43d0c8ecull, 0x3d52eeed1cbea317ull,
+	0xed63a231d4c4fb27ull, 0x4ca7aaa863ee4bddull, 0x945e455f24fb1cf8ull, 0x8fe8caa93e74ef6aull,
+	0xb975d6b6ee39e436ull, 0xb3e2fd538e122b44ull, 0xe7d34c64a9c85d44ull, 0x60dbbca87196b616ull,
+	0x90e40fbeea1d3a4aull, 0xbc8955e946fe31cdull, 0xb51d13aea4a488ddull, 0x6babab6398bdbe41ull,
+	0xe264589a4dcdab14ull, 0xc696963c7eed2dd1ull, 0x8d7eb76070a08aecull, 0xfc1e1de5cf543ca2ull,
+	0xb0de65388cc8ada8ull, 0x3b25a55f43294bcbull, 0xdd15fe86affad912ull, 0x49ef0eb713f39ebeull,
+	0x8a2dbf142dfcc7abull, 0x6e3569326c784337ull, 0xacb92ed9397bf996ull, 0x49c2c37f07965404ull,
+	0xd7e77a8f87daf7fbull, 0xdc33745ec97be906ull, 0x86f0ac99b4e8dafdull, 0x69a028bb3ded71a3ull,
+	0xa8acd7c0222311bcull, 0xc40832ea0d68ce0cull, 0xd2d80db02aabd62bull, 0xf50a3fa490c30190ull,
+	0x83c7088e1aab65dbull, 0x792667c6da79e0faull, 0xa4b8cab1a1563f52ull, 0x577001b891185938ull,
+	0xcde6fd5e09abcf26ull, 0xed4c0226b55e6f86ull, 0x80b05e5ac60b6178ull, 0x544f8158315b05b4ull,
+	0xa0dc75f1778e39d6ull, 0x696361ae3db1c721ull, 0xc913936dd571c84cull, 0x03bc3a19cd1e38e9ull,
+	0xfb5878494ace3a5full, 0x04ab48a04065c723ull, 0x9d174b2dcec0e47bull, 0x62eb0d64283f9c76ull,
+	0xc45d1df942711d9aull, 0x3ba5d0bd324f8394ull, 0xf5746577930d6500ull, 0xca8f44ec7ee36479ull,
+	0x9968bf6abbe85f20ull, 0x7e998b13cf4e1ecbull, 0xbfc2ef456ae276e8ull, 0x9e3fedd8c321a67eull,
+	0xefb3ab16c59b14a2ull, 0xc5cfe94ef3ea101eull, 0x95d04aee3b80ece5ull, 0xbba1f1d158724a12ull,
+	0xbb445da9ca61281full, 0x2a8a6e45ae8edc97ull, 0xea1575143cf97226ull, 0xf52d09d71a3293bdull,
+	0x924d692ca61be758ull, 0x593c2626705f9c56ull, 0xb6e0c377cfa2e12eull, 0x6f8b2fb00c77836cull,
+	0xe498f455c38b997aull, 0x0b6dfb9c0f956447ull, 0x8edf98b59a373fecull, 0x4724bd4189bd5eacull,
+	0xb2977ee300c50fe7ull, 0x58edec91ec2cb657ull, 0xdf3d5e9bc0f653e1ull, 0x2f2967b66737e3edull,
+	0x8b865b215899f46cull, 0xbd79e0d20082ee74ull, 0xae67f1e9aec07187ull, 0xecd8590680a3aa11ull,
+	0xda01ee641a708de9ull, 0xe80e6f4820cc9495ull, 0x884134fe908658b2ull, 0x3109058d147fdcddull,
+	0xaa51823e34a7eedeull, 0xbd4b46f0599fd415ull, 0xd4e5e2cdc1d1ea96ull, 0x6c9e18ac7007c91aull,
+	0x850fadc09923329eull, 0x03e2cf6bc604ddb0ull, 0xa6539930bf6bff45ull, 0x84db8346b786151cull,
+	0xcfe87f7cef46ff16ull, 0xe612641865679a63ull, 0x81f14fae158c5f6eull, 0x4fcb7e8f3f60c07eull,
+	0xa26da3999aef7749ull, 0xe3be5e330f38f09dull, 0xcb090c8001ab551cull, 0x5cadf5bfd3072cc5ull,
+	0xfdcb4fa002162a63ull, 0x73d9732fc7c8f7f6ull, 0x9e9f11c4014dda7eull, 0x2867e7fddcdd9afaull,
+	0xc646d63501a1511dull, 0xb281e1fd541501b8ull, 0xf7d88bc24209a565ull, 0x1f225a7ca91a4226ull,
+	0x9ae757596946075full, 0x3375788de9b06958ull, 0xc1a12d2fc3978937ull, 0x0052d6b1641c83aeull,
+	0xf209787bb47d6b84ull, 0xc0678c5dbd23a49aull, 0x9745eb4d50ce6332ull, 0xf840b7ba963646e0ull,
+	0xbd176620a501fbffull, 0xb650e5a93bc3d898ull, 0xec5d3fa8ce427affull, 0xa3e51f138ab4cebeull,
+	0x93ba47c980e98cdfull, 0xc66f336c36b10137ull, 0xb8a8d9bbe123f017ull, 0xb80b0047445d4184ull,
+	0xe6d3102ad96cec1dull, 0xa60dc059157491e5ull, 0x9043ea1ac7e41392ull, 0x87c89837ad68db2full,
+	0xb454e4a179dd1877ull, 0x29babe4598c311fbull, 0xe16a1dc9d8545e94ull, 0xf4296dd6fef3d67aull,
+	0x8ce2529e2734bb1dull, 0x1899e4a65f58660cull, 0xb01ae745b101e9e4ull, 0x5ec05dcff72e7f8full,
+	0xdc21a1171d42645dull, 0x76707543f4fa1f73ull, 0x899504ae72497ebaull, 0x6a06494a791c53a8ull,
+	0xabfa45da0edbde69ull, 0x0487db9d17636892ull, 0xd6f8d7509292d603ull, 0x45a9d2845d3c42b6ull,
+	0x865b86925b9bc5c2ull, 0x0b8a2392ba45a9b2ull, 0xa7f26836f282b732ull, 0x8e6cac7768d7141eull,
+	0xd1ef0244af2364ffull, 0x3207d795430cd926ull, 0x8335616aed761f1full, 0x7f44e6bd49e807b8ull,
+	0xa402b9c5a8d3a6e7ull, 0x5f16206c9c6209a6ull, 0xcd036837130890a1ull, 0x36dba887c37a8c0full,
+	0x802221226be55a64ull, 0xc2494954da2c9789ull, 0xa02aa96b06deb0fdull, 0xf2db9baa10b7bd6cull,
+	0xc83553c5c8965d3dull, 0x6f92829494e5acc7ull, 0xfa42a8b73abbf48cull, 0xcb772339ba1f17f9ull,
+	0x9c69a97284b578d7ull, 0xff2a760414536efbull, 0xc38413cf25e2d70dull, 0xfef5138519684abaull,
+	0xf46518c2ef5b8cd1ull, 0x7eb258665fc25d69ull, 0x98bf2f79d5993802ull, 0xef2f773ffbd97a61ull,
+	0xbeeefb584aff8603ull, 0xaafb550ffacfd8faull, 0xeeaaba2e5dbf6784ull, 0x95ba2a53f983cf38ull,
+	0x952ab45cfa97a0b2ull, 0xdd945a747bf26183ull, 0xba756174393d88dfull, 0x94f971119aeef9e4ull,
+	0xe912b9d1478ceb17ull, 0x7a37cd5601aab85dull, 0x91abb422ccb812eeull, 0xac62e055c10ab33aull,
+	0xb616a12b7fe617aaull, 0x577b986b314d6009ull, 0xe39c49765fdf9d94ull, 0xed5a7e85fda0b80bull,
+	0x8e41ade9fbebc27dull, 0x14588f13be847307ull, 0xb1d219647ae6b31cull, 0x596eb2d8ae258fc8ull,
+	0xde469fbd99a05fe3ull, 0x6fca5f8ed9aef3bbull, 0x8aec23d680043beeull, 0x25de7bb9480d5854ull,
+	0xada72ccc20054ae9ull, 0xaf561aa79a10ae6aull, 0xd910f7ff28069da4ull, 0x1b2ba1518094da04ull,
+	0x87aa9aff79042286ull, 0x90fb44d2f05d0842ull, 0xa99541bf57452b28ull, 0x353a1607ac744a53ull,
+	0xd3fa922f2d1675f2ull, 0x42889b8997915ce8ull, 0x847c9b5d7c2e09b7ull, 0x69956135febada11ull,
+	0xa59bc234db398c25ull, 0x43fab9837e699095ull, 0xcf02b2c21207ef2eull, 0x94f967e45e03f4bbull,
+	0x8161afb94b44f57dull, 0x1d1be0eebac278f5ull, 0xa1ba1ba79e1632dcull, 0x6462d92a69731732ull,
+	0xca28a291859bbf93ull, 0x7d7b8f7503cfdcfeull, 0xfcb2cb35e702af78ull, 0x5cda735244c3d43eull,
+	0x9defbf01b061adabull, 0x3a0888136afa64a7ull, 0xc56baec21c7a1916ull, 0x088aaa1845b8fdd0ull,
+	0xf6c69a72a3989f5bull, 0x8aad549e57273d45ull, 0x9a3c2087a63f6399ull, 0x36ac54e2f678864bull,
+	0xc0cb28a98fcf3c7full, 0x84576a1bb416a7ddull, 0xf0fdf2d3f3c30b9full, 0x656d44a2a11c51d5ull,
+	0x969eb7c47859e743ull, 0x9f644ae5a4b1b325ull, 0xbc4665b596706114ull, 0x873d5d9f0dde1feeull,
+	0xeb57ff22fc0c7959ull, 0xa90cb506d155a7eaull, 0x9316ff75dd87cbd8ull, 0x09a7f12442d588f2ull,
+	0xb7dcbf5354e9beceull, 0x0c11ed6d538aeb2full, 0xe5d3ef282a242e81ull, 0x8f1668c8a86da5faull,
+	0x8fa475791a569d10ull, 0xf96e017d694487bcull, 0xb38d92d760ec4455ull, 0x37c981dcc395a9acull,
+	0xe070f78d3927556aull, 0x85bbe253f47b1417ull, 0x8c469ab843b89562ull, 0x93956d7478ccec8eull,
+	0xaf58416654a6babbull, 0x387ac8d1970027b2ull, 0xdb2e51bfe9d0696aull, 0x06997b05fcc0319eull,
+	0x88fcf317f22241e2ull, 0x441fece3bdf81f03ull, 0xab3c2fddeeaad25aull, 0xd527e81cad7626c3ull,
+	0xd60b3bd56a5586f1ull, 0x8a71e223d8d3b074ull, 0x85c7056562757456ull, 0xf6872d5667844e49ull,
+	0xa738c6bebb12d16cull, 0xb428f8ac016561dbull, 0xd106f86e69d785c7ull, 0xe13336d701beba52ull,
+	0x82a45b450226b39cull, 0xecc0024661173473ull, 0xa34d721642b06084ull, 0x27f002d7f95d0190ull,
+	0xcc20ce9bd35c78a5ull, 0x31ec038df7b441f4ull, 0xff290242c83396ceull, 0x7e67047175a15271ull,
+	0x9f79a169bd203e41ull, 0x0f0062c6e984d386ull, 0xc75809c42c684dd1ull, 0x52c07b78a3e60868ull,
+	0xf92e0c3537826145ull, 0xa7709a56ccdf8a82ull, 0x9bbcc7a142b17ccbull, 0x88a66076400bb691ull,
+	0xc2abf989935ddbfeull, 0x6acff893d00ea435ull, 0xf356f7ebf83552feull, 0x0583f6b8c4124d43ull,
+	0x98165af37b2153deull, 0xc3727a337a8b704aull, 0xbe1bf1b059e9a8d6ull, 0x744f18c0592e4c5cull,
+	0xeda2ee1c7064130cull, 0x1162def06f79df73ull, 0x9485d4d1c63e8be7ull, 0x8addcb5645ac2ba8ull,
+	0xb9a74a0637ce2ee1ull, 0x6d953e2bd7173692ull, 0xe8111c87c5c1ba99ull, 0xc8fa8db6ccdd0437ull,
+	0x910ab1d4db9914a0ull, 0x1d9c9892400a22a2ull, 0xb54d5e4a127f59c8ull, 0x2503beb6d00cab4bull,
+	0xe2a0b5dc971f303aull, 0x2e44ae64840fd61dull, 0x8da471a9de737e24ull, 0x5ceaecfed289e5d2ull,
+	0xb10d8e1456105dadull, 0x7425a83e872c5f47ull, 0xdd50f1996b947518ull, 0xd12f124e28f77719ull,
+	0x8a5296ffe33cc92full, 0x82bd6b70d99aaa6full, 0xace73cbfdc0bfb7bull, 0x636cc64d1001550bull,
+	0xd8210befd30efa5aull, 0x3c47f7e05401aa4eull, 0x8714a775e3e95c78ull, 0x65acfaec34810a71ull,
+	0xa8d9d1535ce3b396ull, 0x7f1839a741a14d0dull, 0xd31045a8341ca07cull, 0x1ede48111209a050ull,
+	0x83ea2b892091e44dull, 0x934aed0aab460432ull, 0xa4e4b66b68b65d60ull, 0xf81da84d5617853full,
+	0xce1de40642e3f4b9ull, 0x36251260ab9d668eull, 0x80d2ae83e9ce78f3ull, 0xc1d72b7c6b426019ull,
+	0xa1075a24e4421730ull, 0xb24cf65b8612f81full, 0xc94930ae1d529cfcull, 0xdee033f26797b627ull,
+	0xfb9b7cd9a4a7443cull, 0x169840ef017da3b1ull, 0x9d412e0806e88aa5ull, 0x8e1f289560ee864eull,
+	0xc491798a08a2ad4eull, 0xf1a6f2bab92a27e2ull, 0xf5b5d7ec8acb58a2ull, 0xae10af696774b1dbull,
+	0x9991a6f3d6bf1765ull, 0xacca6da1e0a8ef29ull, 0xbff610b0cc6edd3full, 0x17fd090a58d32af3ull,
+	0xeff394dcff8a948eull, 0xddfc4b4cef07f5b0ull, 0x95f83d0a1fb69cd9ull, 0x4abdaf101564f98eull,
+	0xbb764c4ca7a4440full, 0x9d6d1ad41abe37f1ull, 0xea53df5fd18d5513ull, 0x84c86189216dc5edull,
+	0x92746b9be2f8552cull, 0x32fd3cf5b4e49bb4ull, 0xb7118682dbb66a77ull, 0x3fbc8c33221dc2a1ull,
+	0xe4d5e82392a40515ull, 0x0fabaf3feaa5334aull, 0x8f05b1163ba6832dull, 0x29cb4d87f2a7400eull,
+	0xb2c71d5bca9023f8ull, 0x743e20e9ef511012ull, 0xdf78e4b2bd342cf6ull, 0x914da9246b255416ull,
+	0x8bab8eefb6409c1aull, 0x1ad089b6c2f7548eull, 0xae9672aba3d0c320ull, 0xa184ac2473b529b1ull,
+	0xda3c0f568cc4f3e8ull, 0xc9e5d72d90a2741eull, 0x8865899617fb1871ull, 0x7e2fa67c7a658892ull,
+	0xaa7eebfb9df9de8dull, 0xddbb901b98feeab7ull, 0xd51ea6fa85785631ull, 0x552a74227f3ea565ull,
+	0x8533285c936b35deull, 0xd53a88958f87275full, 0xa67ff273b8460356ull, 0x8a892abaf368f137ull,
+	0xd01fef10a657842cull, 0x2d2b7569b0432d85ull, 0x8213f56a67f6b29bull, 0x9c3b29620e29fc73ull,
+	0xa298f2c501f45f42ull, 0x8349f3ba91b47b8full, 0xcb3f2f7642717713ull, 0x241c70a936219a73ull,
+	0xfe0efb53d30dd4d7ull, 0xed238cd383aa0110ull, 0x9ec95d1463e8a506ull, 0xf4363804324a40aaull,
+	0xc67bb4597ce2ce48ull, 0xb143c6053edcd0d5ull, 0xf81aa16fdc1b81daull, 0xdd94b7868e94050aull,
+	0x9b10a4e5e9913128ull, 0xca7cf2b4191c8326ull, 0xc1d4ce1f63f57d72ull, 0xfd1c2f611f63a3f0ull,
+	0xf24a01a73cf2dccfull, 0xbc633b39673c8cecull, 0x976e41088617ca01ull, 0xd5be0503e085d813ull,
+	0xbd49d14aa79dbc82ull, 0x4b2d8644d8a74e18ull, 0xec9c459d51852ba2ull, 0xddf8e7d60ed1219eull,
+	0x93e1ab8252f33b45ull, 0xcabb90e5c942b503ull, 0xb8da1662e7b00a17ull, 0x3d6a751f3b936243ull,
+	0xe7109bfba19c0c9dull, 0x0cc512670a783ad4ull, 0x906a617d450187e2ull, 0x27fb2b80668b24c5ull,
+	0xb484f9dc9641e9daull, 0xb1f9f660802dedf6ull, 0xe1a63853bbd26451ull, 0x5e7873f8a0396973ull,
+	0x8d07e33455637eb2ull, 0xdb0b487b6423e1e8ull, 0xb049dc016abc5e5full, 0x91ce1a9a3d2cda62ull,
+	0xdc5c5301c56b75f7ull, 0x7641a140cc7810fbull, 0x89b9b3e11b6329baull, 0xa9e904c87fcb0a9dull,
+	0xac2820d9623bf429ull, 0x546345fa9fbdcd44ull, 0xd732290fbacaf133ull, 0xa97c177947ad4095ull,
+	0x867f59a9d4bed6c0ull, 0x49ed8eabcccc485dull, 0xa81f301449ee8c70ull, 0x5c68f256bfff5a74ull,
+	0xd226fc195c6a2f8cull, 0x73832eec6fff3111ull, 0x83585d8fd9c25db7ull, 0xc831fd53c5ff7eabull,
+	0xa42e74f3d032f525ull, 0xba3e7ca8b77f5e55ull, 0xcd3a1230c43fb26full, 0x28ce1bd2e55f35ebull,
+	0x80444b5e7aa7cf85ull, 0x7980d163cf5b81b3ull, 0xa0555e361951c366ull, 0xd7e105bcc332621full,
+	0xc86ab5c39fa63440ull, 0x8dd9472bf3fefaa7ull, 0xfa856334878fc150ull, 0xb14f98f6f0feb951ull,
+	0x9c935e00d4b9d8d2ull, 0x6ed1bf9a569f33d3ull, 0xc3b8358109e84f07ull, 0x0a862f80ec4700c8ull,
+	0xf4a642e14c6262c8ull, 0xcd27bb612758c0faull, 0x98e7e9cccfbd7dbdull, 0x8038d51cb897789cull,
+	0xbf21e44003acdd2cull, 0xe0470a63e6bd56c3ull, 0xeeea5d5004981478ull, 0x1858ccfce06cac74ull,
+	0x95527a5202df0ccbull, 0x0f37801e0c43ebc8ull, 0xbaa718e68396cffdull, 0xd30560258f54e6baull,
+	0xe950df20247c83fdull, 0x47c6b82ef32a2069ull, 0x91d28b7416cdd27eull, 0x4cdc331d57fa5441ull,
+	0xb6472e511c81471dull, 0xe0133fe4adf8e952ull, 0xe3d8f9e563a198e5ull, 0x58180fddd97723a6ull,
+	0x8e679c2f5e44ff8full, 0x570f09eaa7ea7648ull,
+};
+
+global const f64 PARSE_POW10_F64[23] = {
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+typedef struct Parse_Float_Bits {
+	u64 mantissa;
+	i32 power2;
+} Parse_Float_Bits;
+
+// ~geb: w * 10^q to a biased binary exponent and 52-bit mantissa
+internal Parse_Float_Bits
+parse_eisel_lemire(i64 q, u64 w)
+{
+	Parse_Float_Bits result = {0};
+
+	if (w == 0 || q < PARSE_POW5_MIN_EXPONENT)
+		return result;
+
+	if (q > PARSE_POW5_MAX_EXPONENT)
+	{
+		result.power2 = 0x7ff;
+		return result;
+	}
+
+	u32 lz = CountLeadingZeros64(w);
+	w <<= lz;
+
+	usize index = 2 * cast(usize)(q - PARSE_POW5_MIN_EXPONENT);
+	u64 precision_mask = U64_MAX >> 55;
+
+	u64 high;
+	u64 low = u128_mul(w, PARSE_POW5_128[index], &high);
+	if ((high & precision_mask) == precision_mask)
+	{
+		u64 second_high;
+		u128_mul(w, PARSE_POW5_128[index + 1], &second_high);
+		low += second_high;
+		if (second_high > low)
+			high += 1;
+	}
+
+	u32 upper_bit = cast(u32)(high >> 63);
+	u32 shift     = upper_bit + 64 - 52 - 3;
+
+	result.mantissa = high >> shift;
+	result.power2   = cast(i32)((((152170 + 65536) * q) >> 16) + 63) + cast(i32)upper_bit - cast(i32)lz + 1023;
+
+	if (result.power2 <= 0)
+	{
+		// ~geb: subnormal
+		if (-result.power2 + 1 >= 64)
+		{
+			result.power2   = 0;
+			result.mantissa = 0;
+			return result;
+		}
+
+		result.mantissa >>= -result.power2 + 1;
+		result.mantissa  += result.mantissa & 1;
+		result.mantissa >>= 1;
+		result.power2     = result.mantissa < (1ull << 52) ? 0 : 1;
+		return result;
+	}
+
+	// ~geb: exactly halfway with an even mantissa rounds down
+	if (low <= 1 && q >= -4 && q <= 23 && (result.mantissa & 3) == 1)
+	{
+		if ((result.mantissa << shift) == high)
+			result.mantissa &= ~1ull;
+	}
+
+	result.mantissa += result.mantissa & 1;
+	result.mantissa >>= 1;
+	if (result.mantissa >= (2ull << 52))
+	{
+		result.mantissa = 1ull << 52;
+		result.power2  += 1;
+	}
+
+	result.mantissa &= ~(1ull << 52);
+	if (result.power2 >= 0x7ff)
+	{
+		result.power2   = 0x7ff;
+		result.mantissa = 0;
+	}
+
+	return result;
+}
+
+// ~geb: more significant digits than a halfway point between two
+//       doubles has, past these only "anything nonzero" matters
+#define PARSE_DECIMAL_DIGITS 800
+
+// ~geb: the digits in [int_begin, int_end) . [frac_begin, frac_end)
+//       times 10^exponent lie between candidate and the double after
+//       it, picks the nearest of the two, ties to even
+internal u64
+parse_round_exact(u8 *int_begin, u8 *int_end, u8 *frac_begin, u8 *frac_end, i64 exponent, u64 candidate)
+{
+	u64 power2   = candidate >> 52;
+	u64 mantissa = candidate & ((1ull << 52) - 1);
+	i64 e        = -1074;
+	if (power2)
+	{
+		mantissa |= 1ull << 52;
+		e = cast(i64)power2 - 1075;
+	}
+
+	// ~geb: halfway = (2 * mantissa + 1) * 2^(e - 1)
+	u64 odd = 2 * mantissa + 1;
+	Fmt_Big half = { .limbs = { cast(u32)odd, cast(u32)(odd >> 32) }, .count = 2 };
+
+	Fmt_Big digits = {0};
+	u8 *spans[2][2] = { { int_begin, int_end }, { frac_begin, frac_end } };
+	i64  place   = (int_end - int_begin) - 1 + exponent; // ~geb: of the next digit
+	u32  taken   = 0;
+	u32  chunk   = 0;
+	u32  chunk_len = 0;
+	bool sticky  = false;
+
+	for (u32 span = 0; span < 2; ++span)
+	{
+		for (u8 *p = spans[span][0]; p < spans[span][1]; ++p)
+		{
+			u32 digit = cast(u32)(*p - '0');
+			if (taken == PARSE_DECIMAL_DIGITS)
+			{
+				sticky |= digit != 0;
+				continue;
+			}
+
+			place -= 1;
+			if (!taken && !digit)
+				continue;
+
+			chunk = chunk * 10 + digit;
+			taken += 1;
+			if (++chunk_len == 9)
+			{
+				fmt_big_mul_u32(&digits, 1000000000u);
+				fmt_big_add_u32(&digits, chunk);
+				chunk     = 0;
+				chunk_len = 0;
+			}
+		}
+	}
+	if (chunk_len)
+	{
+		fmt_big_mul_u32(&digits, cast(u32)POW10_U64[chunk_len]);
+		fmt_big_add_u32(&digits, chunk);
+	}
+
+	// ~geb: digits * 10^q  vs  odd * 2^(e - 1), fives to one side,
+	//       twos to the other
+	i64 q = place + 1;
+	if (q >= 0) fmt_big_mul_pow5(&digits, cast(u32)q);
+	else        fmt_big_mul_pow5(&half, cast(u32)-q);
+
+	i64 twos = (e - 1) - q;
+	if (twos > 0) fmt_big_shl(&half, cast(u32)twos);
+	else          fmt_big_shl(&digits, cast(u32)-twos);
+
+	while (half.count && !half.limbs[half.count - 1]) half.count -= 1;
+	while (digits.count && !digits.limbs[digits.count - 1]) digits.count -= 1;
+
+	i32 order = fmt_big_cmp(&digits, &half);
+	if (order == 0 && sticky)
+		order = 1;
+
+	if (order > 0 || (order == 0 && (candidate & 1)))
+		return candidate + 1;
+	return candidate;
+}
+
+force_inline bool
+parse_match_nocase(u8 *p, u8 *end, const char *word)
+{
+	for (; *word; ++word, ++p)
+	{
+		if (p >= end || (*p | 0x20) != cast(u8)*word)
+			return false;
+	}
+	return true;
+}
+
+internal usize
+str8_parse_f64(String8 string, f64 *out, Parse_Error *err)
+{
+	Parse_Error dummy;
+	if (!err)
+		err = &dummy;
+	*err = Parse_Err_None;
+
+	u8 *start = string.str;
+	u8 *end   = string.str + string.len;
+	u8 *p     = start;
+
+	bool negative = false;
+	if (p < end && (*p == '+' || *p == '-'))
+	{
+		negative = *p == '-';
+		p += 1;
+	}
+
+	f64 value = 0.0;
+
+	if (p < end && !parse_is_digit(*p) && *p != '.')
+	{
+		usize consumed = 0;
+		if (parse_match_nocase(p, end, "infinity"))
+		{
+			value    = 1.0 / 0.0;
+			consumed = 8;
+		}
+		else if (parse_match_nocase(p, end, "inf"))
+		{
+			value    = 1.0 / 0.0;
+			consumed = 3;
+		}
+		else if (parse_match_nocase(p, end, "nan"))
+		{
+			// ~geb: 0.0 / 0.0 has the sign bit set on x64, strtod's
+			//       nan is the positive quiet one
+			u64 bits = 0x7ff8000000000000ull;
+			MemCopy(&value, &bits, sizeof(value));
+			consumed = 3;
+		}
+
+		if (!consumed)
+		{
+			*err = Parse_Err_Invalid;
+			return 0;
+		}
+
+		if (out)
+			*out = negative ? -value : value;
+		return cast(usize)(p - start) + consumed;
+	}
+
+	u64 mantissa = 0;
+	u8 *int_begin = p;
+	p += parse_digits(p, end, &mantissa);
+	u8 *int_end = p;
+
+	i64 digit_count = int_end - int_begin;
+	i64 exponent    = 0;
+
+	u8 *frac_begin = p;
+	u8 *frac_end   = p;
+	if (p < end && *p == '.')
+	{
+		p += 1;
+		frac_begin = p;
+		p += parse_digits(p, end, &mantissa);
+		frac_end = p;
+
+		exponent     = frac_begin - frac_end;
+		digit_count -= exponent;
+	}
+
+	if (digit_count == 0)
+	{
+		*err = Parse_Err_Invalid;
+		return 0;
+	}
+
+	if (p < end && (*p | 0x20) == 'e')
+	{
+		u8 *e_at = p;
+		p += 1;
+
+		bool exp_negative = false;
+		if (p < end && (*p == '+' || *p == '-'))
+		{
+			exp_negative = *p == '-';
+			p += 1;
+		}
+
+		if (p < end && parse_is_digit(*p))
+		{
+			i64 exp_number = 0;
+			while (p < end && parse_is_digit(*p))
+			{
+				if (exp_number < 0x10000)
+					exp_number = exp_number * 10 + (*p - '0');
+				p += 1;
+			}
+			exponent += exp_negative ? -exp_number : exp_number;
+		}
+		else
+		{
+			p = e_at;
+		}
+	}
+
+	usize consumed = cast(usize)(p - start);
+
+	// ~geb: more than nineteen significant digits overflowed the
+	//       mantissa, redo it with exactly the first nineteen.
+	bool truncated = false;
+	i64  decimal_exponent = 0; // ~geb: the one after 'e'
+	if (digit_count > 19)
+	{
+		u8 *lead = int_begin;
+		while (lead < frac_end && (*lead == '0' || *lead == '.'))
+		{
+			if (*lead == '0')
+				digit_count -= 1;
+			lead += 1;
+		}
+
+		if (digit_count > 19)
+		{
+			truncated = true;
+			decimal_exponent = exponent + (frac_end - frac_begin);
+			i64 exp_number   = decimal_exponent;
+
+			u64 min_19_digits = 1000000000000000000ull;
+			mantissa = 0;
+
+			u8 *q = int_begin;
+			while (mantissa < min_19_digits && q < int_end)
+				mantissa = mantissa * 10 + cast(u64)(*q++ - '0');
+
+			if (mantissa >= min_19_digits)
+			{
+				exponent = (int_end - q) + exp_number;
+			}
+			else
+			{
+				q = frac_begin;
+				while (mantissa < min_19_digits && q < frac_end)
+					mantissa = mantissa * 10 + cast(u64)(*q++ - '0');
+				exponent = (frac_begin - q) + exp_number;
+			}
+		}
+	}
+
+	if (!truncated && exponent >= -22 && exponent <= 22 && mantissa <= (1ull << 53))
+	{
+		value = cast(f64)mantissa;
+		if (exponent < 0)
+			value /= PARSE_POW10_F64[-exponent];
+		else
+			value *= PARSE_POW10_F64[exponent];
+	}
+	else
+	{
+		Parse_Float_Bits bits = parse_eisel_lemire(exponent, mantissa);
+		bool exact = true;
+
+		if (truncated && bits.power2 >= 0)
+		{
+			Parse_Float_Bits upper = parse_eisel_lemire(exponent, mantissa + 1);
+			exact = upper.power2 == bits.power2 && upper.mantissa == bits.mantissa;
+		}
+
+		u64 word = bits.mantissa | (cast(u64)bits.power2 << 52);
+		if (!exact)
+			word = parse_round_exact(int_begin, int_end, frac_begin, frac_end, decimal_exponent, word);
+		MemCopy(&value, &word, sizeof(value));
+	}
+
+	if (negative && value > 0)
+		value = -value;
+	else if (negative && value == 0.0)
+		value = -0.0;
+
+	u64 word;
+	MemCopy(&word, &value, sizeof(word));
+	if ((word & 0x7fffffffffffffffull) == 0x7ff0000000000000ull)
+		*err = Parse_Err_Overflow;
+
+	if (out)
+		*out = value;
+	return consumed;
+}
+
+/////////////////////////////////////////////////////////////////////////
+//                            TOKENIZER                                //
+/////////////////////////////////////////////////////////////////////////
+
+#if ARCH_ARM64
+force_inline u64
+neon_movemask_u8(uint8x16_t m)
+{
+	const uint8x16_t bits = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+	uint8x16_t t = vandq_u8(m, bits);
+	return cast(u64)vaddv_u8(vget_low_u8(t)) | (cast(u64)vaddv_u8(vget_high_u8(t)) << 8);
+}
+#endif
+
+internal void
+_tokenizer_classify(Str8_Tokenizer *tok, u8 *block, u64 *newline, u64 *separator, u64 *quote)
+{
+	u64 n = 0, s = 0, q = 0;
+
+#if ARCH_X64
+	__m128i nl = _mm_set1_epi8('\n');
+	__m128i qt = _mm_set1_epi8(cast(char)tok->quote);
+
+	for (u32 i = 0; i < 4; ++i)
+	{
+		__m128i v     = _mm_loadu_si128(cast(const __m128i *)(block + 16 * i));
+		__m128i m_nl  = _mm_cmpeq_epi8(v, nl);
+		__m128i m_sep = m_nl;
+		for (u32 d = 0; d < tok->delim_count; ++d)
+			m_sep = _mm_or_si128(m_sep, _mm_cmpeq_epi8(v, _mm_set1_epi8(cast(char)tok->delims[d])));
+
+		n |= cast(u64)cast(u16)_mm_movemask_epi8(m_nl) << (16 * i);
+		s |= cast(u64)cast(u16)_mm_movemask_epi8(m_sep) << (16 * i);
+		q |= cast(u64)cast(u16)_mm_movemask_epi8(_mm_cmpeq_epi8(v, qt)) << (16 * i);
+	}
+#elif ARCH_ARM64
+	uint8x16_t nl = vdupq_n_u8('\n');
+	uint8x16_t qt = vdupq_n_u8(tok->quote);
+
+	for (u32 i = 0; i < 4; ++i)
+	{
+		uint8x16_t v     = vld1q_u8(block + 16 * i);
+		uint8x16_t m_nl  = vceqq_u8(v, nl);
+		uint8x16_t m_sep = m_nl;
+		for (u32 d = 0; d < tok->delim_count; ++d)
+			m_sep = vorrq_u8(m_sep, vceqq_u8(v, vdupq_n_u8(tok->delims[d])));
+
+		n |= neon_movemask_u8(m_nl)  << (16 * i);
+		s |= neon_movemask_u8(m_sep) << (16 * i);
+		q |= neon_movemask_u8(vceqq_u8(v, qt)) << (16 * i);
+	}
+#else
+	for (u32 i = 0; i < 64; ++i)
+	{
+		u8 c = block[i];
+		bool is_sep = c == '\n';
+		for (u32 d = 0; d < tok->delim_count; ++d)
+			is_sep |= c == tok->delims[d];
+
+		n |= cast(u64)(c == '\n') << i;
+		s |= cast(u64)is_sep << i;
+		q |= cast(u64)(c == tok->quote) << i;
+	}
+#endif
+
+	*newline   = n;
+	*separator = s;
+	*quote     = tok->quote ? q : 0;
+}
+
+// ~geb: masks for the 64 bytes at offset, bits past the end are clear
+internal void
+_tokenizer_block_masks(Str8_Tokenizer *tok, usize offset, u64 *newline, u64 *separator, u64 *quote)
+{
+	usize remaining = tok->src.len - offset;
+	if (remaining >= 64)
+	{
+		_tokenizer_classify(tok, tok->src.str + offset, newline, separator, quote);
+		return;
+	}
+
+	u8 tail[64] = {0};
+	MemCopy(tail, tok->src.str + offset, remaining);
+	_tokenizer_classify(tok, tail, newline, separator, quote);
+
+	u64 valid = (1ull << remaining) - 1;
+	*newline   &= valid;
+	*separator &= valid;
+	*quote     &= valid;
+}
+
+typedef enum Tokenizer_Scan {
+	Tokenizer_Scan_Newline,
+	Tokenizer_Scan_Separator,
+	Tokenizer_Scan_Quote,
+} Tokenizer_Scan;
+
+// ~geb: offset of the next byte of the given kind at or after from,
+//       or src.len when there is none.
+internal usize
+_tokenizer_find(Str8_Tokenizer *tok, usize from, Tokenizer_Scan scan)
+{
+	while (from < tok->src.len)
+	{
+		usize base = from & ~cast(usize)63;
+		if (base != tok->block_base)
+		{
+			_tokenizer_block_masks(tok, base, &tok->newline_mask, &tok->separator_mask, &tok->quote_mask);
+			tok->block_base = base;
+		}
+
+		u64 mask = scan == Tokenizer_Scan_Newline   ? tok->newline_mask :
+				   scan == Tokenizer_Scan_Separator ? tok->separator_mask :
+													  tok->quote_mask;
+		mask &= U64_MAX << (from - base);
+		if (mask)
+			return base + CountTrailingZeros64(mask);
+
+		from = base + 64;
+	}
+
+	return tok->src.len;
+}
+
+internal Str8_Tokenizer
+str8_tokenizer_make(String8 src, String8 delimiters, u8 quote)
+{
+	Assert(delimiters.len <= STR8_TOKENIZER_MAX_DELIMS);
+
+	Str8_Tokenizer tok = {
+		.src         = src,
+		.quote       = quote,
+		.delim_count = cast(u32)Min(delimiters.len, STR8_TOKENIZER_MAX_DELIMS),
+		.block_base  = USIZE_MAX,
+	};
+
+	for (u32 i = 0; i < tok.delim_count; ++i)
+	{
+		Assert(delimiters.str[i] != 0 && delimiters.str[i] != '\n');
+		tok.delims[i] = delimiters.str[i];
+	}
+
+	return tok;
+}
+
+force_inline String8
+_tokenizer_strip_cr(String8 string)
+{
+	if (string.len && string.str[string.len - 1] == '\r')
+		string.len -= 1;
+	return string;
+}
+
+internal bool
+str8_next_line(Str8_Tokenizer *tok, String8 *line)
+{
+	if (tok->pos >= tok->src.len)
+		return false;
+
+	usize end = _tokenizer_find(tok, tok->pos, Tokenizer_Scan_Newline);
+	*line = _tokenizer_strip_cr(str8_slice(tok->src, tok->pos, end));
+
+	tok->pos           = end < tok->src.len ? end + 1 : end;
+	tok->field_pending = false;
+	return true;
+}
+
+internal bool
+str8_next_field(Str8_Tokenizer *tok, String8 *field, bool *end_of_line)
+{
+	tok->last_field_escaped = false;
+
+	if (tok->pos >= tok->src.len)
+	{
+		if (!tok->field_pending)
+			return false;
+
+		// ~geb: trailing delimiter, one empty field closes the line
+		tok->field_pending = false;
+		*field = str8_slice(tok->src, tok->src.len, tok->src.len);
+		if (end_of_line)
+			*end_of_line = true;
+		return true;
+	}
+
+	usize begin = tok->pos;
+	usize end   = 0;
+	usize next  = 0;
+
+	if (tok->quote && tok->src.str[begin] == tok->quote)
+	{
+		usize close = begin;
+		for (;;)
+		{
+			close = _tokenizer_find(tok, close + 1, Tokenizer_Scan_Quote);
+			if (close + 1 < tok->src.len && tok->src.str[close + 1] == tok->quote)
+			{
+				tok->last_field_escaped = true;
+				close += 1;
+				continue;
+			}
+			break;
+		}
+
+		*field = str8_slice(tok->src, begin + 1, close);
+
+		// ~geb: anything between the closing quote and the separator is dropped
+		usize after = close < tok->src.len ? close + 1 : close;
+		next = _tokenizer_find(tok, after, Tokenizer_Scan_Separator);
+		end  = next;
+	}
+	else
+	{
+		next   = _tokenizer_find(tok, begin, Tokenizer_Scan_Separator);
+		end    = next;
+		*field = str8_slice(tok->src, begin, end);
+	}
+
+	bool line_end = next >= tok->src.len || tok->src.str[next] == '\n';
+	if (line_end && !(tok->quote && tok->src.str[begin] == tok->quote))
+		*field = _tokenizer_strip_cr(*field);
+
+	tok->field_pending = !line_end && next + 1 >= tok->src.len;
+	tok->pos           = next < tok->src.len ? next + 1 : next;
+
+	if (end_of_line)
+		*end_of_line = line_end;
+	return true;
+}
+
+// ~geb: turns a quote mask into a mask of bytes inside quotes,
+//       the opening quote counts as inside, the closing one does not.
+force_inline u64
+_tokenizer_prefix_xor(u64 x)
+{
+	x ^= x << 1;
+	x ^= x << 2;
+	x ^= x << 4;
+	x ^= x << 8;
+	x ^= x << 16;
+	x ^= x << 32;
+	return x;
+}
+
+internal bool
+str8_tokenizer_next_block(Str8_Tokenizer *tok, usize *out_offsets, usize *out_count)
+{
+	*out_count = 0;
+	if (tok->batch_pos >= tok->src.len)
+		return false;
+
+	usize base = tok->batch_pos;
+	u64 newline, separator, quote;
+	_tokenizer_block_masks(tok, base, &newline, &separator, &quote);
+
+	u64 in_quote = _tokenizer_prefix_xor(quote) ^ tok->batch_in_quote;
+	tok->batch_in_quote = cast(u64)(cast(i64)in_quote >> 63);
+
+	u64 mask  = separator & ~in_quote;
+	usize count = PopCount64(mask);
+
+	// ~geb: flatten four at a time, writes past count stay within 64
+	for (usize i = 0; i < count; i += 4)
+	{
+		out_offsets[i + 0] = base + CountTrailingZeros64(mask | (1ull << 63)); mask &= mask - 1;
+		out_offsets[i + 1] = base + CountTrailingZeros64(mask | (1ull << 63)); mask &= mask - 1;
+		out_offsets[i + 2] = base + CountTrailingZeros64(mask | (1ull << 63)); mask &= mask - 1;
+		out_offsets[i + 3] = base + CountTrailingZeros64(mask | (1ull << 63)); mask &= mask - 1;
+	}
+
+	*out_count     = count;
+	tok->batch_pos = base + 64;
+	return true;
+}
+
+/////////////////////////////////////////////////////////////////////////
+//                           TRANSCODING                               //
+/////////////////////////////////////////////////////////////////////////
+
+// ~geb: the measuring pass validates, so the converting pass decodes
+//       without checks. SIMD takes blocks that are all ascii, and for
+//       UTF-16 input any block without surrogates.
+
+#define UTF16_IS_SURROGATE(c) (((c) & 0xf800) == 0xd800)
+#define UTF16_IS_HIGH(c)      (((c) & 0xfc00) == 0xd800)
+#define UTF16_IS_LOW(c)       (((c) & 0xfc00) == 0xdc00)
+
+// ~geb: number of leading ascii bytes of the 16 at p
+internal u32
+_ascii_run16(u8 *p)
+{
+#if ARCH_X64
+	u32 mask = cast(u32)_mm_movemask_epi8(_mm_loadu_si128(cast(const __m128i *)p));
+	return mask ? CountTrailingZeros32(mask) : 16;
+#elif ARCH_ARM64
+	uint8x16_t v = vld1q_u8(p);
+	if (vmaxvq_u8(v) < RUNE_SELF)
+		return 16;
+	return CountTrailingZeros64(neon_movemask_u8(vcgeq_u8(v, vdupq_n_u8(RUNE_SELF))));
+#else
+	u64 lo, hi;
+	MemCopy(&lo, p, 8);
+	MemCopy(&hi, p + 8, 8);
+	if (lo & SWAR_HIGHS)
+		return CountTrailingZeros64(lo & SWAR_HIGHS) >> 3;
+	if (hi & SWAR_HIGHS)
+		return 8 + (CountTrailingZeros64(hi & SWAR_HIGHS) >> 3);
+	return 16;
+#endif
+}
+
+// ~geb: 16 ascii bytes to 16 code units
+force_inline void
+_ascii16_widen_u16(u8 *src, u16 *dst)
+{
+#if ARCH_X64
+	__m128i v    = _mm_loadu_si128(cast(const __m128i *)src);
+	__m128i zero = _mm_setzero_si128();
+	_mm_storeu_si128(cast(__m128i *)dst,       _mm_unpacklo_epi8(v, zero));
+	_mm_storeu_si128(cast(__m128i *)(dst + 8), _mm_unpackhi_epi8(v, zero));
+#elif ARCH_ARM64
+	uint8x16_t v = vld1q_u8(src);
+	vst1q_u16(dst,     vmovl_u8(vget_low_u8(v)));
+	vst1q_u16(dst + 8, vmovl_high_u8(v));
+#else
+	for (u32 i = 0; i < 16; ++i)
+		dst[i] = src[i];
+#endif
+}
+
+force_inline void
+_ascii16_widen_u32(u8 *src, u32 *dst)
+{
+#if ARCH_X64
+	__m128i v    = _mm_loadu_si128(cast(const __m128i *)src);
+	__m128i zero = _mm_setzero_si128();
+	__m128i lo   = _mm_unpacklo_epi8(v, zero);
+	__m128i hi   = _mm_unpackhi_epi8(v, zero);
+	_mm_storeu_si128(cast(__m128i *)dst,        _mm_unpacklo_epi16(lo, zero));
+	_mm_storeu_si128(cast(__m128i *)(dst + 4),  _mm_unpackhi_epi16(lo, zero));
+	_mm_storeu_si128(cast(__m128i *)(dst + 8),  _mm_unpacklo_epi16(hi, zero));
+	_mm_storeu_si128(cast(__m128i *)(dst + 12), _mm_unpackhi_epi16(hi, zero));
+#elif ARCH_ARM64
+	uint8x16_t v  = vld1q_u8(src);
+	uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+	uint16x8_t hi = vmovl_high_u8(v);
+	vst1q_u32(dst,      vmovl_u16(vget_low_u16(lo)));
+	vst1q_u32(dst + 4,  vmovl_high_u16(lo));
+	vst1q_u32(dst + 8,  vmovl_u16(vget_low_u16(hi)));
+	vst1q_u32(dst + 12, vmovl_high_u16(hi));
+#else
+	for (u32 i = 0; i < 16; ++i)
+		dst[i] = src[i];
+#endif
+}
+
+// ~geb: 8 code units to 8 bytes when they are all ascii
+force_inline bool
+_utf16_narrow_ascii8(u16 *src, u8 *dst)
+{
+#if ARCH_X64
+	__m128i v     = _mm_loadu_si128(cast(const __m128i *)src);
+	__m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(cast(short)0xff80)), _mm_setzero_si128());
+	if (_mm_movemask_epi8(ascii) != 0xffff)
+		return false;
+	_mm_storel_epi64(cast(__m128i *)dst, _mm_packus_epi16(v, v));
+	return true;
+#elif ARCH_ARM64
+	uint16x8_t v = vld1q_u16(src);
+	if (vmaxvq_u16(v) >= RUNE_SELF)
+		return false;
+	vst1_u8(dst, vmovn_u16(v));
+	return true;
+#else
+	u16 any = 0;
+	for (u32 i = 0; i < 8; ++i)
+		any |= src[i];
+	if (any >= RUNE_SELF)
+		return false;
+	for (u32 i = 0; i < 8; ++i)
+		dst[i] = cast(u8)src[i];
+	return true;
+#endif
+}
+
+// ~geb: 8 code units to 8 runes when none of them is a surrogate
+force_inline bool
+_utf16_widen8(u16 *src, u32 *dst)
+{
+#if ARCH_X64
+	__m128i v         = _mm_loadu_si128(cast(const __m128i *)src);
+	__m128i surrogate = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(cast(short)0xf800)), _mm_set1_epi16(cast(short)0xd800));
+	if (_mm_movemask_epi8(surrogate))
+		return false;
+	__m128i zero = _mm_setzero_si128();
+	_mm_storeu_si128(cast(__m128i *)dst,       _mm_unpacklo_epi16(v, zero));
+	_mm_storeu_si128(cast(__m128i *)(dst + 4), _mm_unpackhi_epi16(v, zero));
+	return true;
+#elif ARCH_ARM64
+	uint16x8_t v         = vld1q_u16(src);
+	uint16x8_t surrogate = vceqq_u16(vandq_u16(v, vdupq_n_u16(0xf800)), vdupq_n_u16(0xd800));
+	if (vmaxvq_u16(surrogate))
+		return false;
+	vst1q_u32(dst,     vmovl_u16(vget_low_u16(v)));
+	vst1q_u32(dst + 4, vmovl_high_u16(v));
+	return true;
+#else
+	for (u32 i = 0; i < 8; ++i)
+		if (UTF16_IS_SURROGATE(src[i]))
+			return false;
+	for (u32 i = 0; i < 8; ++i)
+		dst[i] = src[i];
+	return true;
+#endif
+}
+
+// ~geb: 4 runes to 4 bytes when they are all ascii
+force_inline bool
+_utf32_narrow_ascii4(u32 *src, u8 *dst)
+{
+#if ARCH_X64
+	__m128i v     = _mm_loadu_si128(cast(const __m128i *)src);
+	__m128i ascii = _mm_cmpeq_epi32(_mm_and_si128(v, _mm_set1_epi32(~0x7f)), _mm_setzero_si128());
+	if (_mm_movemask_epi8(ascii) != 0xffff)
+		return false;
+	__m128i packed = _mm_packs_epi32(v, v);
+	u32 bytes = cast(u32)_mm_cvtsi128_si32(_mm_packus_epi16(packed, packed));
+	MemCopy(dst, &bytes, 4);
+	return true;
+#elif ARCH_ARM64
+	uint32x4_t v = vld1q_u32(src);
+	if (vmaxvq_u32(v) >= RUNE_SELF)
+		return false;
+	uint16x4_t narrow = vmovn_u32(v);
+	u32 bytes = vget_lane_u32(vreinterpret_u32_u8(vmovn_u16(vcombine_u16(narrow, narrow))), 0);
+	MemCopy(dst, &bytes, 4);
+	return true;
+#else
+	if ((src[0] | src[1] | src[2] | src[3]) >= RUNE_SELF)
+		return false;
+	for (u32 i = 0; i < 4; ++i)
+		dst[i] = cast(u8)src[i];
+	return true;
+#endif
+}
+
+// ~geb: 4 runes to 4 code units when they are all below the
+//       surrogates, input is already validated
+force_inline bool
+_utf32_narrow_bmp4(u32 *src, u16 *dst)
+{
+#if ARCH_X64
+	__m128i v = _mm_loadu_si128(cast(const __m128i *)src);
+	if (_mm_movemask_epi8(_mm_cmplt_epi32(v, _mm_set1_epi32(0xd800))) != 0xffff)
+		return false;
+	// ~geb: packs is signed, so bias into i16 range and back
+	__m128i biased = _mm_sub_epi32(v, _mm_set1_epi32(0x8000));
+	__m128i packed = _mm_add_epi16(_mm_packs_epi32(biased, biased), _mm_set1_epi16(cast(short)0x8000));
+	_mm_storel_epi64(cast(__m128i *)dst, packed);
+	return true;
+#elif ARCH_ARM64
+	uint32x4_t v = vld1q_u32(src);
+	if (vmaxvq_u32(v) >= 0xd800)
+		return false;
+	vst1_u16(dst, vmovn_u32(v));
+	return true;
+#else
+	if (Max(Max(src[0], src[1]), Max(src[2], src[3])) >= 0xd800)
+		return false;
+	for (u32 i = 0; i < 4; ++i)
+		dst[i] = cast(u16)src[i];
+	return true;
+#endif
+}
+
+// ~geb: decode of a non ascii sequence that already passed validation
+force_inline rune
+_utf8_decode_valid(u8 *p, u32 *width)
+{
+	u8 lead = p[0];
+	if (lead < 0xe0)
+	{
+		*width = 2;
+		return (cast(rune)(lead & 0x1f) << 6) | (p[1] & 0x3f);
+	}
+	if (lead < 0xf0)
+	{
+		*width = 3;
+		return (cast(rune)(lead & 0x0f) << 12) | (cast(rune)(p[1] & 0x3f) << 6) | (p[2] & 0x3f);
+	}
+	*width = 4;
+	return (cast(rune)(lead & 0x07) << 18) | (cast(rune)(p[1] & 0x3f) << 12) |
+		   (cast(rune)(p[2] & 0x3f) << 6) | (p[3] & 0x3f);
+}
+
+internal Transcode_Error
+_utf8_scan(String8 string, usize *out_runes, usize *out_supplementary)
+{
+	u8 *p   = string.str;
+	u8 *end = string.str + string.len;
+	usize runes = 0;
+	usize supplementary = 0;
+
+	while (p < end)
+	{
+		if (end - p >= 16)
+		{
+			u32 run = _ascii_run16(p);
+			runes += run;
+			p     += run;
+			if (run == 16)
+				continue;
+		}
+		else if (*p < RUNE_SELF)
+		{
+			runes += 1;
+			p     += 1;
+			continue;
+		}
+
+		u32 width = UTF8_LEN_TABLE[*p];
+		if (width == 0 || cast(usize)(end - p) < width)
+			return Transcode_Err_InvalidUTF8;
+
+		UTF8_Error utf8_err = UTF8_Err_None;
+		utf8_decode(p, &utf8_err);
+		if (utf8_err != UTF8_Err_None)
+			return Transcode_Err_InvalidUTF8;
+
+		runes         += 1;
+		supplementary += width == 4;
+		p             += width;
+	}
+
+	*out_runes = runes;
+	*out_supplementary = supplementary;
+	return Transcode_Err_None;
+}
+
+internal Transcode_Error
+_utf16_scan(String16 string, usize *out_bytes, usize *out_runes)
+{
+	u16 *p   = string.str;
+	u16 *end = string.str + string.len;
+	usize bytes = 0;
+	usize runes = 0;
+
+	while (p < end)
+	{
+		// ~geb: without surrogates every unit is one rune of 3 bytes,
+		//       minus one below 0x800 and another below 0x80
+#if ARCH_X64
+		if (end - p >= 8)
+		{
+			__m128i v      = _mm_loadu_si128(cast(const __m128i *)p);
+			__m128i zero   = _mm_setzero_si128();
+			__m128i high5  = _mm_and_si128(v, _mm_set1_epi16(cast(short)0xf800));
+			if (!_mm_movemask_epi8(_mm_cmpeq_epi16(high5, _mm_set1_epi16(cast(short)0xd800))))
+			{
+				u32 below_80  = cast(u32)_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(cast(short)0xff80)), zero));
+				u32 below_800 = cast(u32)_mm_movemask_epi8(_mm_cmpeq_epi16(high5, zero));
+				bytes += 24 - (PopCount64(below_80) + PopCount64(below_800)) / 2;
+				runes += 8;
+				p     += 8;
+				continue;
+			}
+		}
+#elif ARCH_ARM64
+		if (end - p >= 8)
+		{
+			uint16x8_t v     = vld1q_u16(p);
+			uint16x8_t high5 = vandq_u16(v, vdupq_n_u16(0xf800));
+			if (!vmaxvq_u16(vceqq_u16(high5, vdupq_n_u16(0xd800))))
+			{
+				uint16x8_t one   = vdupq_n_u16(1);
+				uint16x8_t extra = vaddq_u16(vandq_u16(vcgeq_u16(v, vdupq_n_u16(0x80)), one),
+				                             vandq_u16(vcgeq_u16(v, vdupq_n_u16(0x800)), one));
+				bytes += 8 + vaddvq_u16(extra);
+				runes += 8;
+				p     += 8;
+				continue;
+			}
+		}
+#endif
+
+		u16 c = *p;
+		if (c < 0x80)
+			bytes += 1;
+		else if (c < 0x800)
+			bytes += 2;
+		else if (!UTF16_IS_SURROGATE(c))
+			bytes += 3;
+		else
+		{
+			if (!UTF16_IS_HIGH(c) || end - p < 2 || !UTF16_IS_LOW(p[1]))
+				return Transcode_Err_UnpairedSurrogate;
+			bytes += 4;
+			p     += 1;
+		}
+		runes += 1;
+		p     += 1;
+	}
+
+	*out_bytes = bytes;
+	*out_runes = runes;
+	return Transcode_Err_None;
+}
+
+internal Transcode_Error
+_utf32_scan(String32 string, usize *out_bytes, usize *out_units16)
+{
+	u32 *p   = string.str;
+	u32 *end = string.str + string.len;
+	usize bytes = 0;
+	usize units = 0;
+
+	while (p < end)
+	{
+#if ARCH_X64
+		if (end - p >= 4)
+		{
+			__m128i v = _mm_loadu_si128(cast(const __m128i *)p);
+			if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(v, _mm_set1_epi32(~0x7f)), _mm_setzero_si128())) == 0xffff)
+			{
+				bytes += 4;
+				units += 4;
+				p     += 4;
+				continue;
+			}
+		}
+#elif ARCH_ARM64
+		if (end - p >= 4 && vmaxvq_u32(vld1q_u32(p)) < RUNE_SELF)
+		{
+			bytes += 4;
+			units += 4;
+			p     += 4;
+			continue;
+		}
+#endif
+
+		rune r = *p++;
+		if (r > Rune_Max)
+			return Transcode_Err_OutOfRange;
+		if (r >= 0xd800 && r <= 0xdfff)
+			return Transcode_Err_UnpairedSurrogate;
+
+		bytes += 1 + (r >= 0x80) + (r >= 0x800) + (r >= 0x10000);
+		units += 1 + (r >= 0x10000);
+	}
+
+	*out_bytes   = bytes;
+	*out_units16 = units;
+	return Transcode_Err_None;
+}
+
+internal usize
+str16_size_from_str8(String8 string, Transcode_Error *err)
+{
+	usize runes = 0, supplementary = 0;
+	Transcode_Error error = _utf8_scan(string, &runes, &supplementary);
+	if (err)
+		*err = error;
+	return error == Transcode_Err_None ? runes + supplementary : 0;
+}
+
+internal usize
+str32_size_from_str8(String8 string, Transcode_Error *err)
+{
+	usize runes = 0, supplementary = 0;
+	Transcode_Error error = _utf8_scan(string, &runes, &supplementary);
+	if (err)
+		*err = error;
+	return error == Transcode_Err_None ? runes : 0;
+}
+
+internal usize
+str8_size_from_str16(String16 string, Transcode_Error *err)
+{
+	usize bytes = 0, runes = 0;
+	Transcode_Error error = _utf16_scan(string, &bytes, &runes);
+	if (err)
+		*err = error;
+	return error == Transcode_Err_None ? bytes : 0;
+}
+
+internal usize
+str32_size_from_str16(String16 string, Transcode_Error *err)
+{
+	usize bytes = 0, runes = 0;
+	Transcode_Error error = _utf16_scan(string, &bytes, &runes);
+	if (err)
+		*err = error;
+	return error == Transcode_Err_None ? runes : 0;
+}
+
+internal usize
+str8_size_from_str32(String32 string, Transcode_Error *err)
+{
+	usize bytes = 0, units = 0;
+	Transcode_Error error = _utf32_scan(string, &bytes, &units);
+	if (err)
+		*err = error;
+	return error == Transcode_Err_None ? bytes : 0;
+}
+
+internal usize
+str16_size_from_str32(String32 string, Transcode_Error *err)
+{
+	usize bytes = 0, units = 0;
+	Transcode_Error error = _utf32_scan(string, &bytes, &units);
+	if (err)
+		*err = error;
+	return error == Transcode_Err_None ? units : 0;
+}
+
+internal String16
+str16_from_str8(String8 string, Allocator alloc, Transcode_Error *err)
+{
+	String16 result = {0};
+	usize size = str16_size_from_str8(string, err);
+	if (size == 0)
+		return result;
+
+	u16 *out = alloc_array(alloc, u16, size, NULL);
+	if (!out)
+		return result;
+	result.str = out;
+	result.len = size;
+
+	u8 *p   = string.str;
+	u8 *end = string.str + string.len;
+	while (p < end)
+	{
+		if (end - p >= 16)
+		{
+			u32 run = _ascii_run16(p);
+			if (run == 16)
+			{
+				_ascii16_widen_u16(p, out);
+				p   += 16;
+				out += 16;
+				continue;
+			}
+			for (u32 i = 0; i < run; ++i)
+				*out++ = *p++;
+		}
+		else if (*p < RUNE_SELF)
+		{
+			*out++ = *p++;
+			continue;
+		}
+
+		u32 width;
+		rune r = _utf8_decode_valid(p, &width);
+		p += width;
+		if (r >= 0x10000)
+		{
+			r -= 0x10000;
+			*out++ = cast(u16)(0xd800 | (r >> 10));
+			*out++ = cast(u16)(0xdc00 | (r & 0x3ff));
+		}
+		else
+		{
+			*out++ = cast(u16)r;
+		}
+	}
+
+	return result;
+}
+
+internal String32
+str32_from_str8(String8 string, Allocator alloc, Transcode_Error *err)
+{
+	String32 result = {0};
+	usize size = str32_size_from_str8(string, err);
+	if (size == 0)
+		return result;
+
+	u32 *out = alloc_array(alloc, u32, size, NULL);
+	if (!out)
+		return result;
+	result.str = out;
+	result.len = size;
+
+	u8 *p   = string.str;
+	u8 *end = string.str + string.len;
+	while (p < end)
+	{
+		if (end - p >= 16)
+		{
+			u32 run = _ascii_run16(p);
+			if (run == 16)
+			{
+				_ascii16_widen_u32(p, out);
+				p   += 16;
+				out += 16;
+				continue;
+			}
+			for (u32 i = 0; i < run; ++i)
+				*out++ = *p++;
+		}
+		else if (*p < RUNE_SELF)
+		{
+			*out++ = *p++;
+			continue;
+		}
+
+		u32 width;
+		*out++ = _utf8_decode_valid(p, &width);
+		p += width;
+	}
+
+	return result;
+}
+
+internal String8
+str8_from_str16(String16 string, Allocator alloc, Transcode_Error *err)
+{
+	usize size = str8_size_from_str16(string, err);
+	if (size == 0)
+		return S("");
+
+	u8 *out = alloc_array(alloc, u8, size, NULL);
+	if (!out)
+		return S("");
+
+	String8 result = {
+		.str = out,
+		.len = size};
+
+	u16 *p   = string.str;
+	u16 *end = string.str + string.len;
+	while (p < end)
+	{
+		if (end - p >= 8 && _utf16_narrow_ascii8(p, out))
+		{
+			p   += 8;
+			out += 8;
+			continue;
+		}
+
+		rune r = *p++;
+		if (UTF16_IS_SURROGATE(r))
+			r = 0x10000 + ((r - 0xd800) << 10) + (*p++ - 0xdc00u);
+		out += utf8_encode(r, out);
+	}
+
+	return result;
+}
+
+internal String32
+str32_from_str16(String16 string, Allocator alloc, Transcode_Error *err)
+{
+	String32 result = {0};
+	usize size = str32_size_from_str16(string, err);
+	if (size == 0)
+		return result;
+
+	u32 *out = alloc_array(alloc, u32, size, NULL);
+	if (!out)
+		return result;
+	result.str = out;
+	result.len = size;
+
+	u16 *p   = string.str;
+	u16 *end = string.str + string.len;
+	while (p < end)
+	{
+		if (end - p >= 8 && _utf16_widen8(p, out))
+		{
+			p   += 8;
+			out += 8;
+			continue;
+		}
+
+		rune r = *p++;
+		if (UTF16_IS_SURROGATE(r))
+			r = 0x10000 + ((r - 0xd800) << 10) + (*p++ - 0xdc00u);
+		*out++ = r;
+	}
+
+	return result;
+}
+
+internal String8
+str8_from_str32(String32 string, Allocator alloc, Transcode_Error *err)
+{
+	usize size = str8_size_from_str32(string, err);
+	if (size == 0)
+		return S("");
+
+	u8 *out = alloc_array(alloc, u8, size, NULL);
+	if (!out)
+		return S("");
+
+	String8 result = {
+		.str = out,
+		.len = size};
+
+	u32 *p   = string.str;
+	u32 *end = string.str + string.len;
+	while (p < end)
+	{
+		if (end - p >= 4 && _utf32_narrow_ascii4(p, out))
+		{
+			p   += 4;
+			out += 4;
+			continue;
+		}
+		out += utf8_encode(*p++, out);
+	}
+
+	return result;
+}
+
+internal String16
+str16_from_str32(String32 string, Allocator alloc, Transcode_Error *err)
+{
+	String16 result = {0};
+	usize size = str16_size_from_str32(string, err);
+	if (size == 0)
+		return result;
+
+	u16 *out = alloc_array(alloc, u16, size, NULL);
+	if (!out)
+		return result;
+	result.str = out;
+	result.len = size;
+
+	u32 *p   = string.str;
+	u32 *end = string.str + string.len;
+	while (p < end)
+	{
+		if (end - p >= 4 && _utf32_narrow_bmp4(p, out))
+		{
+			p   += 4;
+			out += 4;
+			continue;
+		}
+
+		rune r = *p++;
+		if (r >= 0x10000)
+		{
+			r -= 0x10000;
+			*out++ = cast(u16)(0xd800 | (r >> 10));
+			*out++ = cast(u16)(0xdc00 | (r & 0x3ff));
+		}
+		else
+		{
+			*out++ = cast(u16)r;
+		}
+	}
+
+	return result;
+}
+
+/////////////////////////////////////////////////////////////////////////
+//                            RUNE INDEX                               //
+/////////////////////////////////////////////////////////////////////////
+
+// ~geb: rune starts and newlines of the 64 bytes at offset, bits
+//       past the end of the string are clear
+internal void
+_str8_index_masks(String8 string, usize offset, u64 *starts, u64 *newlines)
+{
+	u8 *block = string.str + offset;
+	usize remaining = string.len - offset;
+
+	u8 tail[64];
+	if (remaining < 64)
+	{
+		MemSet(tail, 0, sizeof(tail));
+		MemCopy(tail, block, remaining);
+		block = tail;
+	}
+
+	u64 s = 0, n = 0;
+
+#if ARCH_X64
+	// ~geb: continuation bytes 0x80..0xbf are the signed bytes below -64
+	__m128i cont_end = _mm_set1_epi8(-64);
+	__m128i nl       = _mm_set1_epi8('\n');
+	for (u32 i = 0; i < 4; ++i)
+	{
+		__m128i v = _mm_loadu_si128(cast(const __m128i *)(block + 16 * i));
+		s |= cast(u64)cast(u16)~_mm_movemask_epi8(_mm_cmplt_epi8(v, cont_end)) << (16 * i);
+		n |= cast(u64)cast(u16)_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)) << (16 * i);
+	}
+#elif ARCH_ARM64
+	uint8x16_t top = vdupq_n_u8(0xc0);
+	uint8x16_t cont = vdupq_n_u8(0x80);
+	uint8x16_t nl  = vdupq_n_u8('\n');
+	for (u32 i = 0; i < 4; ++i)
+	{
+		uint8x16_t v = vld1q_u8(block + 16 * i);
+		s |= (~neon_movemask_u8(vceqq_u8(vandq_u8(v, top), cont)) & 0xffff) << (16 * i);
+		n |= neon_movemask_u8(vceqq_u8(v, nl)) << (16 * i);
+	}
+#else
+	for (u32 i = 0; i < 64; ++i)
+	{
+		s |= cast(u64)((block[i] & 0xc0) != 0x80) << i;
+		n |= cast(u64)(block[i] == '\n') << i;
+	}
+#endif
+
+	if (remaining < 64)
+	{
+		u64 valid = (1ull << remaining) - 1;
+		s &= valid;
+		n &= valid;
+	}
+
+	*starts   = s;
+	*newlines = n;
+}
+
+// ~geb: position of the nth (from 0) set bit, n < popcount
+force_inline u32
+_select_bit64(u64 mask, u32 n)
+{
+	for (u32 i = 0; i < n; ++i)
+		mask &= mask - 1;
+	return CountTrailingZeros64(mask);
+}
+
+// ~geb: rune starts (or newlines) in [begin, end)
+internal usize
+_str8_index_count(String8 string, usize begin, usize end, bool newlines)
+{
+	usize count = 0;
+	for (usize offset = begin; offset < end; offset += 64)
+	{
+		u64 starts, nl;
+		_str8_index_masks(string, offset, &starts, &nl);
+
+		u64 mask = newlines ? nl : starts;
+		if (end - offset < 64)
+			mask &= (1ull << (end - offset)) - 1;
+		count += PopCount64(mask);
+	}
+	return count;
+}
+
+// ~geb: byte offset of the nth rune start (or newline) from begin
+internal usize
+_str8_index_select(String8 string, usize begin, usize n, bool newlines)
+{
+	for (usize offset = begin; offset < string.len; offset += 64)
+	{
+		u64 starts, nl;
+		_str8_index_masks(string, offset, &starts, &nl);
+
+		u64 mask  = newlines ? nl : starts;
+		u32 count = cast(u32)PopCount64(mask);
+		if (n < count)
+			return offset + _select_bit64(mask, cast(u32)n);
+		n -= count;
+	}
+	return string.len;
+}
+
+internal bool
+_str8_index_push(Dynamic_Array *arr, usize value)
+{
+	usize len = arr->len;
+	dyn_arr_append(arr, usize, value);
+	return arr->len != len;
+}
+
+// ~geb: there are at most len / stride + 1 checkpoints, so that array
+//       never grows. Lines start with a guess of one per 64 bytes
+internal bool
+str8_index_make(Str8_Index *index, String8 string, u32 stride, Allocator alloc)
+{
+	MemZeroStruct(index);
+	index->string = string;
+	index->stride = stride ? stride : STR8_INDEX_DEFAULT_STRIDE;
+	index->rune_checkpoints = dynamic_array(alloc, usize, string.len / index->stride + 1);
+	index->line_starts      = dynamic_array(alloc, usize, string.len / 64 + 1);
+
+	if (!index->rune_checkpoints.data || !index->line_starts.data)
+	{
+		str8_index_delete(index);
+		return false;
+	}
+	return true;
+}
+
+internal void
+str8_index_delete(Str8_Index *index)
+{
+	dynamic_array_delete(&index->rune_checkpoints);
+	dynamic_array_delete(&index->line_starts);
+	index->built = false;
+}
+
+// ~geb: when an array cannot grow it is dropped and lookups fall
+//       back to scanning from the start of the string
+internal bool
+str8_index_build(Str8_Index *index)
+{
+	String8 string = index->string;
+	index->rune_checkpoints.len = 0;
+	index->line_starts.len      = 0;
+
+	bool checkpoints_ok = true;
+	bool lines_ok       = _str8_index_push(&index->line_starts, 0);
+
+	usize runes = 0;
+	usize lines = 1;
+	usize next_checkpoint = 0;
+	for (usize offset = 0; offset < string.len; offset += 64)
+	{
+		u64 starts, newlines;
+		_str8_index_masks(string, offset, &starts, &newlines);
+
+		usize count = PopCount64(starts);
+		for (; next_checkpoint < runes + count; next_checkpoint += index->stride)
+		{
+			if (checkpoints_ok)
+			{
+				usize byte = offset + _select_bit64(starts, cast(u32)(next_checkpoint - runes));
+				checkpoints_ok = _str8_index_push(&index->rune_checkpoints, byte);
+			}
+		}
+
+		runes += count;
+		lines += PopCount64(newlines);
+		for (; newlines && lines_ok; newlines &= newlines - 1)
+			lines_ok = _str8_index_push(&index->line_starts, offset + CountTrailingZeros64(newlines) + 1);
+	}
+
+	if (!checkpoints_ok)
+		dynamic_array_delete(&index->rune_checkpoints);
+	if (!lines_ok)
+		dynamic_array_delete(&index->line_starts);
+
+	index->rune_count = runes;
+	index->line_count = lines;
+	index->built      = true;
+	return checkpoints_ok && lines_ok;
+}
+
+internal void
+_str8_index_ensure(Str8_Index *index)
+{
+	if (!index->built)
+		str8_index_build(index);
+}
+
+internal usize
+str8_index_rune_count(Str8_Index *index)
+{
+	_str8_index_ensure(index);
+	return index->rune_count;
+}
+
+internal usize
+str8_index_line_count(Str8_Index *index)
+{
+	_str8_index_ensure(index);
+	return index->line_count;
+}
+
+// ~geb: number of entries at or before value in a sorted usize array
+internal usize
+_str8_index_upper_bound(Dynamic_Array *arr, usize value)
+{
+	usize *data = cast(usize *)arr->data;
+	usize lo = 0;
+	usize hi = arr->len;
+	while (lo < hi)
+	{
+		usize mid = lo + (hi - lo) / 2;
+		if (data[mid] <= value)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+internal usize
+str8_index_byte_from_rune(Str8_Index *index, usize rune_index)
+{
+	_str8_index_ensure(index);
+	if (rune_index >= index->rune_count)
+		return index->string.len;
+
+	usize checkpoint = rune_index / index->stride;
+	if (checkpoint < index->rune_checkpoints.len)
+	{
+		usize begin = dyn_arr_index(&index->rune_checkpoints, usize, checkpoint);
+		return _str8_index_select(index->string, begin, rune_index % index->stride, false);
+	}
+	return _str8_index_select(index->string, 0, rune_index, false);
+}
+
+// ~geb: index of the rune the byte belongs to
+internal usize
+str8_index_rune_from_byte(Str8_Index *index, usize byte_offset)
+{
+	_str8_index_ensure(index);
+	if (byte_offset >= index->string.len)
+		return index->rune_count;
+
+	usize base_byte = 0;
+	usize base_rune = 0;
+	usize checkpoints = _str8_index_upper_bound(&index->rune_checkpoints, byte_offset);
+	if (checkpoints)
+	{
+		base_byte = dyn_arr_index(&index->rune_checkpoints, usize, checkpoints - 1);
+		base_rune = (checkpoints - 1) * index->stride;
+	}
+
+	usize count = _str8_index_count(index->string, base_byte, byte_offset + 1, false);
+	return count ? base_rune + count - 1 : base_rune;
+}
+
+internal usize
+str8_index_byte_from_line(Str8_Index *index, usize line)
+{
+	_str8_index_ensure(index);
+	if (line >= index->line_count)
+		return index->string.len;
+	if (line < index->line_starts.len)
+		return dyn_arr_index(&index->line_starts, usize, line);
+	if (line == 0)
+		return 0;
+	return _str8_index_select(index->string, 0, line - 1, true) + 1;
+}
+
+internal usize
+str8_index_line_from_byte(Str8_Index *index, usize byte_offset)
+{
+	_str8_index_ensure(index);
+	byte_offset = Min(byte_offset, index->string.len);
+	if (index->line_starts.len)
+		return _str8_index_upper_bound(&index->line_starts, byte_offset) - 1;
+	return _str8_index_count(index->string, 0, byte_offset, true);
+}
+
+/////////////////////////////////////////////////////////////////////////
+//                            LOGGER                                   //
+/////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdarg.h>
+
+#define ANSI_RESET   "\x1b[0m"
 #define ANSI_GRAY    "\x1b[90m"
 #define ANSI_GREEN   "\x1b[32m"
 #define ANSI_YELLOW  "\x1b[33m"
 #define ANSI_RED     "\x1b[31m"
 
-internal void log_base(const char* color,
-                     const char* level,
-                     const char* fmt,
-                     va_list args)
+// ~geb: the ring holds variable sized records, an 8 byte header
+//       followed by the message, padded to 8 bytes. A producer
+//       claims space by moving head with a CAS, copies the message
+//       and publishes it by storing the state. A record that would
+//       wrap is preceded by a pad record up to the end of the ring.
+//       The flush thread zeroes everything it consumed, so a claimed
+//       but unpublished header always reads as empty.
+
+typedef u32 Log_Record_State;
+enum {
+	Log_Record_Empty,
+	Log_Record_Ready,
+	Log_Record_Pad,
+};
+
+typedef struct {
+	u32 len;
+	u32 state;
+} Log_Record_Header;
+
+typedef struct {
+	u8          *ring;
+	u64          ring_mask;
+	u8          *batch;
+	usize        batch_size;
+	u64          flush_interval_ns;
+	Log_Overflow overflow;
+	OS_Handle    output;
+	usize        output_offset;
+	OS_Thread    thread;
+	bool         binary;
+	u32          running;
+	u32          active;
+	u64          dropped;
+	u64          dropped_reported;
+	u32          wake;          // ~geb: futex, bumped to wake the flush thread early
+
+	u8           pad0[CACHE_LINE_SIZE];
+	u64          head;
+	u32          writers; // ~geb: producers inside a log call
+	u8           pad1[CACHE_LINE_SIZE - sizeof(u64) - sizeof(u32)];
+	u64          tail;
+	u32          drained;       // ~geb: futex, bumped after the tail moves
+	u32          drain_waiters;
+} Logger;
+
+global Logger log_state;
+global Logger log_deferred_state = { .binary = true };
+thread_static u8  log_buffer[LOG_MESSAGE_MAX];
+thread_static u32 log_thread_id;
+
+internal void
+_log_nudge(Logger *log)
+{
+	AtomicAddU32(&log->wake, 1);
+	os_futex_wake(&log->wake, 1);
+}
+
+// ~geb: wakes the flush thread and blocks until the tail moves past
+//       tail, or a flush interval passes
+internal void
+_log_wait_drained(Logger *log, u64 tail)
+{
+	AtomicAddU32(&log->drain_waiters, 1);
+	u32 drained = AtomicLoadU32(&log->drained);
+	if (AtomicLoadU64(&log->tail) == tail)
+	{
+		_log_nudge(log);
+		os_futex_wait(&log->drained, drained, log->flush_interval_ns);
+	}
+	AtomicAddU32(&log->drain_waiters, -1);
+}
+
+internal bool
+_log_push(Logger *log, u8 *message, usize len, bool must_block)
+{
+	u64 size     = AlignPow2(sizeof(Log_Record_Header) + len, 8);
+	u64 capacity = log->ring_mask + 1;
+	u32 spins    = 0;
+
+	for (;;)
+	{
+		u64 head   = AtomicLoadU64(&log->head);
+		u64 tail   = AtomicLoadU64(&log->tail);
+		u64 offset = head & log->ring_mask;
+		u64 pad    = (capacity - offset < size) ? capacity - offset : 0;
+
+		if (head + pad + size - tail > capacity)
+		{
+			if (log->overflow != Log_Overflow_Block && !must_block)
+			{
+				AtomicAddU64(&log->dropped, 1);
+				return false;
+			}
+
+			if (++spins < 64)
+				CpuPause();
+			else
+				_log_wait_drained(log, tail);
+			continue;
+		}
+
+		if (AtomicCompareExchangeU64(&log->head, head, head + pad + size) != head)
+			continue;
+
+		if (pad)
+		{
+			Log_Record_Header *filler = cast(Log_Record_Header *)(log->ring + offset);
+			AtomicStoreU32(&filler->state, Log_Record_Pad);
+			offset = 0;
+		}
+
+		Log_Record_Header *header = cast(Log_Record_Header *)(log->ring + offset);
+		header->len = cast(u32)len;
+		MemCopy(header + 1, message, len);
+		AtomicStoreU32(&header->state, Log_Record_Ready);
+		return true;
+	}
+}
+
+internal void
+_log_write(Logger *log, u8 *data, usize len)
+{
+	log->output_offset += os_file_write(log->output, log->output_offset, log->output_offset + len, data);
+}
+
+// ~geb: binary streams are a sequence of these, see the deferred
+//       logger below for what follows each header
+typedef struct {
+	u32 size; // ~geb: including the header
+	u32 site;
+} Log_Deferred_Header;
+
+#define LOG_DEFERRED_DEFINE  0u
+#define LOG_DEFERRED_DROPPED 0xfffffffeu
+#define LOG_DEFERRED_SESSION 0xffffffffu
+#define LOG_DEFERRED_MAGIC   0x3130474f4c4e4942ull // ~geb: "BINLOG01"
+
+// ~geb: moves every published record into batches, returns false
+//       when there was nothing to do
+internal bool
+_log_drain(Logger *log)
+{
+	u64 capacity = log->ring_mask + 1;
+	u64 tail     = log->tail;
+	u64 head     = AtomicLoadU64(&log->head);
+	bool drained = tail != head;
+	usize batched = 0;
+
+	while (tail < head)
+	{
+		u64 offset = tail & log->ring_mask;
+		Log_Record_Header *header = cast(Log_Record_Header *)(log->ring + offset);
+
+		u32 state = AtomicLoadU32(&header->state);
+		if (state == Log_Record_Empty)
+			break;
+
+		u64 size = capacity - offset;
+		if (state == Log_Record_Ready)
+		{
+			size = AlignPow2(sizeof(Log_Record_Header) + header->len, 8);
+			if (batched + header->len > log->batch_size)
+			{
+				_log_write(log, log->batch, batched);
+				batched = 0;
+				// ~geb: everything before this record is out
+				AtomicStoreU64(&log->tail, tail);
+			}
+			MemCopy(log->batch + batched, header + 1, header->len);
+			batched += header->len;
+		}
+
+		MemZero(header, size);
+		tail += size;
+	}
+
+	if (log->overflow == Log_Overflow_Count)
+	{
+		u64 dropped = AtomicLoadU64(&log->dropped);
+		if (dropped != log->dropped_reported)
+		{
+			if (batched + 64 > log->batch_size)
+			{
+				_log_write(log, log->batch, batched);
+				batched = 0;
+			}
+
+			u64 count = dropped - log->dropped_reported;
+			if (log->binary)
+			{
+				Log_Deferred_Header note = { sizeof(note) + sizeof(count), LOG_DEFERRED_DROPPED };
+				MemCopy(log->batch + batched, &note, sizeof(note));
+				MemCopy(log->batch + batched + sizeof(note), &count, sizeof(count));
+				batched += sizeof(note) + sizeof(count);
+			}
+			else
+			{
+				batched += str8_fmt(log->batch + batched, 64, "%s[log] %llu messages dropped%s\n",
+				                    ANSI_RED, cast(unsigned long long)count, ANSI_RESET);
+			}
+			log->dropped_reported = dropped;
+			drained = true;
+		}
+	}
+
+	if (batched)
+		_log_write(log, log->batch, batched);
+
+	// ~geb: the tail only moves once its records reached the sink, so
+	//       waiting for it in log_flush means written. The fence orders
+	//       it before the waiter check, pairs with the waiter count
+	//       increment in _log_wait_drained
+	AtomicStoreU64(&log->tail, tail);
+	AtomicFence();
+	if (drained && AtomicLoadU32(&log->drain_waiters))
+	{
+		AtomicAddU32(&log->drained, 1);
+		os_futex_wake(&log->drained, OS_FUTEX_WAKE_ALL);
+	}
+	return drained;
+}
+
+internal OS_Thread_Proc(_log_flush_thread)
+{
+	Logger *log = cast(Logger *)param;
+	while (AtomicLoadU32(&log->running))
+	{
+		u32 wake = AtomicLoadU32(&log->wake);
+		if (!_log_drain(log))
+			os_futex_wait(&log->wake, wake, log->flush_interval_ns);
+	}
+
+	while (_log_drain(log))
+	{
+	}
+}
+
+internal bool
+_log_start(Logger *log, Log_Config config)
+{
+	if (log->thread)
+		return false;
+
+	usize ring_size = 2 * LOG_MESSAGE_MAX;
+	while (ring_size < config.ring_size)
+		ring_size <<= 1;
+	if (!config.ring_size)
+		ring_size = LOG_DEFAULT_RING_SIZE;
+
+	usize batch_size = config.batch_size ? config.batch_size : LOG_DEFAULT_BATCH_SIZE;
+	batch_size = Max(batch_size, LOG_MESSAGE_MAX + 64);
+
+	Allocator heap = heap_allocator();
+	u8 *ring  = alloc_array(heap, u8, ring_size, NULL);
+	u8 *batch = alloc_array(heap, u8, batch_size, NULL);
+	if (!ring || !batch)
+	{
+		if (ring)
+			mem_free(heap, ring, NULL);
+		if (batch)
+			mem_free(heap, batch, NULL);
+		return false;
+	}
+
+	log->ring              = ring;
+	log->ring_mask         = ring_size - 1;
+	log->batch             = batch;
+	log->batch_size        = batch_size;
+	log->flush_interval_ns = config.flush_interval_ns ? config.flush_interval_ns : LOG_DEFAULT_INTERVAL;
+	log->overflow          = config.overflow;
+	log->output            = config.output ? config.output : os_stdout();
+	log->output_offset     = os_properties_from_file(log->output).size;
+	log->head              = 0;
+	log->tail              = 0;
+	log->dropped_reported  = AtomicLoadU64(&log->dropped);
+
+	if (log->binary)
+	{
+		struct { Log_Deferred_Header header; u64 magic; } session = {
+			{ sizeof(session), LOG_DEFERRED_SESSION }, LOG_DEFERRED_MAGIC };
+		_log_write(log, cast(u8 *)&session, sizeof(session));
+	}
+	else
+	{
+		// ~geb: whatever was logged synchronously goes out first
+		fflush(stdout);
+	}
+
+	AtomicStoreU32(&log->running, 1);
+	log->thread = os_thread_create(_log_flush_thread, log);
+	if (!log->thread)
+	{
+		mem_free(heap, ring, NULL);
+		mem_free(heap, batch, NULL);
+		return false;
+	}
+
+	AtomicStoreU32(&log->active, 1);
+	return true;
+}
+
+internal void
+_log_stop(Logger *log)
+{
+	if (!log->thread)
+		return;
+
+	// ~geb: store then load on two flags, seq_cst on both sides so a
+	//       writer either sees inactive or gets counted here
+	AtomicExchangeU32(&log->active, 0);
+	while (AtomicLoadSeqCstU32(&log->writers))
+		os_sleep_ns(1000);
+
+	AtomicStoreU32(&log->running, 0);
+	_log_nudge(log);
+	os_thread_join(log->thread);
+
+	Allocator heap = heap_allocator();
+	mem_free(heap, log->ring, NULL);
+	mem_free(heap, log->batch, NULL);
+	log->ring   = 0;
+	log->batch  = 0;
+	log->thread = 0;
+}
+
+// ~geb: waits until everything pushed so far has been written
+internal void
+_log_wait(Logger *log)
+{
+	u64 target = AtomicLoadU64(&log->head);
+	u64 tail;
+	while ((tail = AtomicLoadU64(&log->tail)) < target)
+		_log_wait_drained(log, tail);
+}
+
+internal bool
+log_init(Log_Config config)
+{
+	return _log_start(&log_state, config);
+}
+
+internal void
+log_shutdown(void)
+{
+	_log_stop(&log_state);
+}
+
+internal void
+log_flush(void)
+{
+	if (!AtomicLoadU32(&log_state.active))
+	{
+		fflush(stdout);
+		return;
+	}
+	_log_wait(&log_state);
+}
+
+internal u64
+log_dropped_count(void)
+{
+	return AtomicLoadU64(&log_state.dropped);
+}
+
+internal void
+log_set_level(Log_Level level)
+{
+	AtomicStoreU32(&log_level, level);
+}
+
+internal void log_base(const char* color,
+                     const char* level,
+                     const char* fmt,
+                     va_list args)
+{
+    u8 *buffer = log_buffer;
+    usize len = str8_fmt(buffer, LOG_MESSAGE_MAX, "%s--------[ %s ]--------\n%s", color, level, ANSI_RESET);
+    len += str8_fmtv(buffer + len, LOG_MESSAGE_MAX - len, fmt, args);
+    len = Min(len, LOG_MESSAGE_MAX - 1);
+    buffer[len++] = '\n';
+
+    Logger *log = &log_state;
+    AtomicAddU32(&log->writers, 1);
+    if (AtomicLoadSeqCstU32(&log->active))
+    {
+        _log_push(log, buffer, len, false);
+    }
+    else
+    {
+        fwrite(buffer, 1, len, stdout);
+    }
+    AtomicAddU32(&log->writers, -1);
+}
+
+internal void log_debug(const char* fmt, ...)
+{
+    if (Log_Level_Debug < AtomicLoadU32(&log_level))
+        return;
+    va_list args;
+    va_start(args, fmt);
+    log_base(ANSI_GRAY, "DEBUG", fmt, args);
+    va_end(args);
+}
+
+internal void log_info(const char* fmt, ...)
+{
+    if (Log_Level_Info < AtomicLoadU32(&log_level))
+        return;
+    va_list args;
+    va_start(args, fmt);
+    log_base(ANSI_GREEN, "INFO ", fmt, args);
+    va_end(args);
+}
+
+internal void log_warn(const char* fmt, ...)
+{
+    if (Log_Level_Warn < AtomicLoadU32(&log_level))
+        return;
+    va_list args;
+    va_start(args, fmt);
+    log_base(ANSI_YELLOW, "WARN ", fmt, args);
+    va_end(args);
+}
+
+internal void log_error(const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    log_base(ANSI_RED, "ERROR", fmt, args);
+    va_end(args);
+}
+
+// ~geb: deferred records, all little endian and unaligned:
+//       session  header, u64 magic. Starts a stream, site ids
+//                restart with every session.
+//       define   header, u32 id, level, line, arg_count,
+//                u8 types[arg_count], u32 len + format, u32 len + file
+//       dropped  header, u64 count
+//       event    header (site = id), u64 time ns, u32 thread,
+//                8 bytes per number, u32 len + bytes per string
+
+#define LOG_SITE_BUSY 0xffffffffu
+
+global Log_Site *log_sites;
+global u32       log_site_next_id;
+
+typedef struct {
+	u8 *at;
+	u8 *end;
+} Log_Cursor;
+
+force_inline void
+_log_put(Log_Cursor *c, const void *data, usize size)
+{
+	size = Min(size, cast(usize)(c->end - c->at));
+	MemCopy(c->at, data, size);
+	c->at += size;
+}
+
+force_inline void
+_log_put_u32(Log_Cursor *c, u32 value)
+{
+	_log_put(c, &value, sizeof(value));
+}
+
+force_inline void
+_log_put_string(Log_Cursor *c, const void *data, usize len)
+{
+	usize room = cast(usize)(c->end - c->at);
+	len = room > 4 ? Min(len, room - 4) : 0;
+	_log_put_u32(c, cast(u32)len);
+	_log_put(c, data, len);
+}
+
+// ~geb: the first call on a site pushes its definition, later calls
+//       on other threads wait until it is in the ring
+internal u32
+_log_site_id(Logger *log, Log_Site *site)
+{
+	u32 id = AtomicLoadU32(&site->id);
+	if (id && id != LOG_SITE_BUSY)
+		return id;
+
+	if (id == 0 && AtomicCompareExchangeU32(&site->id, 0, LOG_SITE_BUSY) == 0)
+	{
+		if (!site->listed)
+		{
+			site->listed = true;
+			Log_Site *first;
+			do
+			{
+				first = AtomicLoadPtr(&log_sites);
+				site->next = first;
+			} while (AtomicCompareExchangePtr(&log_sites, first, site) != first);
+		}
+
+		id = AtomicAddU32(&log_site_next_id, 1) + 1;
+
+		u8 define[LOG_MESSAGE_MAX];
+		Log_Cursor c = { define + sizeof(Log_Deferred_Header), define + sizeof(define) };
+		_log_put_u32(&c, id);
+		_log_put_u32(&c, site->level);
+		_log_put_u32(&c, site->line);
+		_log_put_u32(&c, site->arg_count);
+		_log_put(&c, site->arg_types, site->arg_count);
+		_log_put_string(&c, site->fmt, MemStrlen(site->fmt));
+		_log_put_string(&c, site->file, MemStrlen(site->file));
+
+		Log_Deferred_Header header = { cast(u32)(c.at - define), LOG_DEFERRED_DEFINE };
+		MemCopy(define, &header, sizeof(header));
+		_log_push(log, define, header.size, true);
+
+		AtomicStoreU32(&site->id, id);
+		return id;
+	}
+
+	u32 spins = 0;
+	while ((id = AtomicLoadU32(&site->id)) == LOG_SITE_BUSY || id == 0)
+	{
+		if (++spins < 64)
+			CpuPause();
+		else
+			os_sleep_ns(1000);
+	}
+	return id;
+}
+
+internal void
+_log_deferred_write(Log_Site *site, Log_Arg *args)
+{
+	Logger *log = &log_deferred_state;
+	AtomicAddU32(&log->writers, 1);
+	if (AtomicLoadSeqCstU32(&log->active))
+	{
+		u32 id = _log_site_id(log, site);
+		if (!log_thread_id)
+			log_thread_id = os_thread_id();
+
+		u64 time = os_time_now();
+		Log_Cursor c = { log_buffer + sizeof(Log_Deferred_Header), log_buffer + LOG_MESSAGE_MAX };
+		_log_put(&c, &time, sizeof(time));
+		_log_put_u32(&c, log_thread_id);
+		for (u32 i = 0; i < site->arg_count; ++i)
+		{
+			Log_Arg_Type type = site->arg_types[i];
+			if (type == Log_Arg_CString || type == Log_Arg_String8)
+				_log_put_string(&c, cast(u8 *)cast(usize)args[i].value, args[i].len);
+			else
+				_log_put(&c, &args[i].value, sizeof(args[i].value));
+		}
+
+		Log_Deferred_Header header = { cast(u32)(c.at - log_buffer), id };
+		MemCopy(log_buffer, &header, sizeof(header));
+		_log_push(log, log_buffer, header.size, false);
+	}
+	AtomicAddU32(&log->writers, -1);
+}
+
+internal bool
+log_deferred_init(Log_Config config)
+{
+	if (!config.output || log_deferred_state.thread)
+		return false;
+
+	// ~geb: a new stream needs every site defined again
+	for (Log_Site *site = AtomicLoadPtr(&log_sites); site; site = site->next)
+		AtomicStoreU32(&site->id, 0);
+	AtomicStoreU32(&log_site_next_id, 0);
+
+	return _log_start(&log_deferred_state, config);
+}
+
+internal void
+log_deferred_shutdown(void)
+{
+	_log_stop(&log_deferred_state);
+}
+
+internal void
+log_deferred_flush(void)
+{
+	if (AtomicLoadU32(&log_deferred_state.active))
+		_log_wait(&log_deferred_state);
+}
+
+internal u64
+log_deferred_dropped_count(void)
+{
+	return AtomicLoadU64(&log_deferred_state.dropped);
+}
+
+internal Log_Site *
+log_deferred_sites(void)
+{
+	return AtomicLoadPtr(&log_sites);
+}
+
+// ~geb: decoding
+
+typedef struct {
+	bool         defined;
+	Log_Level    level;
+	u32          line;
+	u32          arg_count;
+	Log_Arg_Type arg_types[LOG_DEFERRED_MAX_ARGS];
+	String8      fmt;
+	String8      file;
+} Log_Decoded_Site;
+
+internal bool
+_log_get(Log_Cursor *c, void *out, usize size)
+{
+	if (cast(usize)(c->end - c->at) < size)
+	{
+		c->at = c->end;
+		MemZero(out, size);
+		return false;
+	}
+	MemCopy(out, c->at, size);
+	c->at += size;
+	return true;
+}
+
+internal u32
+_log_get_u32(Log_Cursor *c)
+{
+	u32 value;
+	_log_get(c, &value, sizeof(value));
+	return value;
+}
+
+internal String8
+_log_get_string(Log_Cursor *c)
+{
+	String8 result = {0};
+	usize len = _log_get_u32(c);
+	len = Min(len, cast(usize)(c->end - c->at));
+	result.str = c->at;
+	result.len = len;
+	c->at += len;
+	return result;
+}
+
+internal void
+_log_builder_pushf(Str8_Builder *out, const char *fmt, ...)
+{
+	va_list args, args_copy;
+	va_start(args, fmt);
+	va_copy(args_copy, args);
+
+	usize len = str8_fmtv(NULL, 0, fmt, args);
+	u8 *dst = str8_builder_reserve(out, len);
+	if (dst)
+	{
+		str8_fmtv(dst, len, fmt, args_copy);
+		str8_builder_commit(out, len);
+	}
+
+	va_end(args_copy);
+	va_end(args);
+}
+
+internal bool
+_log_is_one_of(u8 c, const char *set)
+{
+	for (; *set; ++set)
+		if (c == cast(u8)*set)
+			return true;
+	return false;
+}
+
+// ~geb: formats one event, every conversion is rewritten to the
+//       type that was captured and printed on its own
+internal void
+_log_decode_message(Str8_Builder *out, Log_Decoded_Site *site, Log_Cursor *c)
+{
+	Log_Arg args[LOG_DEFERRED_MAX_ARGS] = {0};
+	for (u32 i = 0; i < site->arg_count; ++i)
+	{
+		Log_Arg_Type type = site->arg_types[i];
+		if (type == Log_Arg_CString || type == Log_Arg_String8)
+		{
+			String8 string = _log_get_string(c);
+			args[i].value = cast(u64)cast(usize)string.str;
+			args[i].len   = string.len;
+		}
+		else
+		{
+			_log_get(c, &args[i].value, sizeof(args[i].value));
+		}
+	}
+
+	u8 *at  = site->fmt.str;
+	u8 *end = site->fmt.str + site->fmt.len;
+	u32 next_arg = 0;
+	while (at < end)
+	{
+		u8 *run = at;
+		while (at < end && *at != '%')
+			at += 1;
+		if (at != run)
+			str8_builder_push(out, str8_slice(site->fmt, cast(usize)(run - site->fmt.str), cast(usize)(at - site->fmt.str)));
+		if (at == end)
+			break;
+
+		at += 1;
+		if (at < end && *at == '%')
+		{
+			str8_builder_push_byte(out, '%');
+			at += 1;
+			continue;
+		}
+
+		char spec[32];
+		usize n = 0;
+		spec[n++] = '%';
+		while (at < end && n < 20 && _log_is_one_of(*at, "-+ #0"))
+			spec[n++] = cast(char)*at++;
+		while (at < end && n < 28 && ((*at >= '0' && *at <= '9') || *at == '.'))
+			spec[n++] = cast(char)*at++;
+		while (at < end && _log_is_one_of(*at, "hlLqjzt"))
+			at += 1;
+		u8 conv = at < end ? *at++ : 's';
+
+		if (next_arg >= site->arg_count)
+		{
+			str8_builder_push(out, S("<missing>"));
+			continue;
+		}
+
+		Log_Arg_Type type = site->arg_types[next_arg];
+		Log_Arg arg = args[next_arg++];
+		switch (type)
+		{
+		case Log_Arg_F64:
+		{
+			f64 value;
+			MemCopy(&value, &arg.value, sizeof(value));
+			spec[n++] = _log_is_one_of(conv, "fFeEgG") ? cast(char)conv : 'g';
+			spec[n]   = 0;
+			_log_builder_pushf(out, spec, value);
+		} break;
+
+		case Log_Arg_CString:
+		case Log_Arg_String8:
+		{
+			String8 string = { .len = arg.len, .str = cast(u8 *)cast(usize)arg.value };
+			spec[n++] = 'S';
+			spec[n]   = 0;
+			_log_builder_pushf(out, spec, string);
+		} break;
+
+		case Log_Arg_Ptr:
+			if (conv == 'p')
+			{
+				spec[n++] = 'p';
+				spec[n]   = 0;
+				_log_builder_pushf(out, spec, cast(void *)cast(usize)arg.value);
+				break;
+			}
+			// fallthrough
+		default:
+			if (_log_is_one_of(conv, "fFeEgG"))
+			{
+				f64 value = type == Log_Arg_I64 ? cast(f64)cast(i64)arg.value : cast(f64)arg.value;
+				spec[n++] = cast(char)conv;
+				spec[n]   = 0;
+				_log_builder_pushf(out, spec, value);
+			}
+			else if (conv == 'c')
+			{
+				spec[n++] = 'c';
+				spec[n]   = 0;
+				_log_builder_pushf(out, spec, cast(int)arg.value);
+			}
+			else
+			{
+				spec[n++] = 'l';
+				spec[n++] = 'l';
+				spec[n++] = _log_is_one_of(conv, "diuoxX") ? cast(char)conv : (type == Log_Arg_I64 ? 'd' : 'u');
+				spec[n]   = 0;
+				_log_builder_pushf(out, spec, cast(unsigned long long)arg.value);
+			}
+			break;
+		}
+	}
+}
+
+internal String8
+log_deferred_decode(String8 stream, Allocator alloc)
+{
+	local_persist const char *level_names[Log_Level_Count] = { "DEBUG", "INFO ", "WARN ", "ERROR" };
+
+	// ~geb: an arena cannot grow an array from nothing, the sites
+	//       need their first block here
+	Str8_Builder  out   = str8_builder_make(alloc, 0);
+	Dynamic_Array sites = dynamic_array(alloc, Log_Decoded_Site, LOG_DEFERRED_DECODE_SITES);
+	bool          ok    = sites.data != NULL;
+
+	Log_Cursor c = { stream.str, stream.str + stream.len };
+	while (ok && cast(usize)(c.end - c.at) >= sizeof(Log_Deferred_Header))
+	{
+		Log_Deferred_Header header;
+		_log_get(&c, &header, sizeof(header));
+		if (header.size < sizeof(header) || header.size - sizeof(header) > cast(usize)(c.end - c.at))
+			break;
+
+		Log_Cursor body = { c.at, c.at + header.size - sizeof(header) };
+		c.at = body.end;
+
+		if (header.site == LOG_DEFERRED_SESSION)
+		{
+			u64 magic = 0;
+			_log_get(&body, &magic, sizeof(magic));
+			if (magic != LOG_DEFERRED_MAGIC)
+				break;
+			sites.len = 0;
+		}
+		else if (header.site == LOG_DEFERRED_DROPPED)
+		{
+			u64 count = 0;
+			_log_get(&body, &count, sizeof(count));
+			_log_builder_pushf(&out, "[log] %llu messages dropped\n", cast(unsigned long long)count);
+		}
+		else if (header.site == LOG_DEFERRED_DEFINE)
+		{
+			Log_Decoded_Site site = {0};
+			u32 id         = _log_get_u32(&body);
+			if (id == 0 || id > Mb(1))
+				continue;
+			u32 level      = _log_get_u32(&body);
+			site.line      = _log_get_u32(&body);
+			u32 arg_count  = _log_get_u32(&body);
+			site.defined   = true;
+			site.level     = Min(level, Log_Level_Error);
+			site.arg_count = Min(arg_count, LOG_DEFERRED_MAX_ARGS);
+			_log_get(&body, site.arg_types, site.arg_count);
+			site.fmt  = _log_get_string(&body);
+			site.file = _log_get_string(&body);
+
+			ok = dynamic_array_reserve(&sites, sizeof(Log_Decoded_Site), AlignOf(Log_Decoded_Site), cast(usize)id + 1);
+			if (!ok)
+				break;
+			if (sites.len <= id)
+			{
+				MemZero(cast(Log_Decoded_Site *)sites.data + sites.len, (id + 1 - sites.len) * sizeof(Log_Decoded_Site));
+				sites.len = cast(usize)id + 1;
+			}
+			(cast(Log_Decoded_Site *)sites.data)[id] = site;
+		}
+		else
+		{
+			Log_Decoded_Site *site = header.site < sites.len ? cast(Log_Decoded_Site *)sites.data + header.site : NULL;
+			if (!site || !site->defined)
+			{
+				_log_builder_pushf(&out, "<event of undefined site %u>\n", header.site);
+				continue;
+			}
+
+			u64 time = 0;
+			_log_get(&body, &time, sizeof(time));
+			u32 thread = _log_get_u32(&body);
+
+			_log_builder_pushf(&out, "%llu.%09llu %s %S:%u [%u] ",
+			                   cast(unsigned long long)(time / 1000000000ull),
+			                   cast(unsigned long long)(time % 1000000000ull),
+			                   level_names[site->level], site->file, site->line, thread);
+			_log_decode_message(&out, site, &body);
+			str8_builder_push_byte(&out, '\n');
+		}
+	}
+
+	String8 text = ok ? str8_builder_flatten(&out, alloc) : (String8){0};
+	str8_builder_delete(&out);
+	dynamic_array_delete(&sites);
+	return text;
+}
+
+
+/////////////////////////////////////////////////////////////////////////
+//                            PROFILER                                 //
+/////////////////////////////////////////////////////////////////////////
+
+global Prof_Thread *prof_threads;
+thread_static Prof_Thread *prof_thread_local;
+
+// ~geb: thread state is created on first use and kept after the
+//       thread exits so its zones can still be exported
+internal Prof_Thread *
+_prof_thread(void)
+{
+	Prof_Thread *thread = prof_thread_local;
+	if (thread)
+		return thread;
+
+	thread = alloc_array(heap_allocator(), Prof_Thread, 1, NULL);
+	if (!thread)
+		return NULL;
+	thread->id = os_thread_id();
+
+	Prof_Thread *first;
+	do
+	{
+		first = AtomicLoadPtr(&prof_threads);
+		thread->next = first;
+	} while (AtomicCompareExchangePtr(&prof_threads, first, thread) != first);
+
+	prof_thread_local = thread;
+	return thread;
+}
+
+internal void
+prof_begin(const char *name)
+{
+	Prof_Thread *thread = _prof_thread();
+	if (!thread)
+		return;
+
+	u32 depth = thread->depth++;
+	if (depth < PROF_MAX_DEPTH)
+	{
+		thread->stack_names[depth]  = name;
+		thread->stack_starts[depth] = os_cycles_now();
+	}
+}
+
+internal void
+prof_end(void)
+{
+	u64 end = os_cycles_now();
+	Prof_Thread *thread = prof_thread_local;
+	if (!thread || thread->depth == 0)
+		return;
+
+	u32 depth = --thread->depth;
+	if (depth >= PROF_MAX_DEPTH)
+		return;
+
+	u64 write = thread->write;
+	Prof_Event *event = &thread->events[write & (PROF_EVENTS_PER_THREAD - 1)];
+	event->name     = thread->stack_names[depth];
+	event->start    = thread->stack_starts[depth];
+	event->duration = end - event->start;
+	event->depth    = depth;
+	AtomicStoreU64(&thread->write, write + 1);
+}
+
+internal void
+_prof_scope_end(u8 *scope)
+{
+	(void)scope; // ~geb: cleanup attributes pass the variable
+	prof_end();
+}
+
+internal void
+prof_set_thread_name(const char *name)
+{
+	Prof_Thread *thread = _prof_thread();
+	if (thread)
+		thread->name = name;
+}
+
+internal void
+_prof_push_json_string(Str8_Builder *out, const char *string)
+{
+	str8_builder_push_byte(out, '"');
+	for (const char *at = string ? string : "?"; *at; ++at)
+	{
+		u8 c = cast(u8)*at;
+		if (c == '"' || c == '\\')
+		{
+			str8_builder_push_byte(out, '\\');
+			str8_builder_push_byte(out, c);
+		}
+		else if (c < 0x20)
+		{
+			_log_builder_pushf(out, "\\u%04x", c);
+		}
+		else
+		{
+			str8_builder_push_byte(out, c);
+		}
+	}
+	str8_builder_push_byte(out, '"');
+}
+
+internal bool
+prof_export_chrome(String8 path, Allocator scratch)
+{
+	Str8_Builder out = str8_builder_make(scratch, Kb(64));
+	str8_builder_push(&out, S("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"));
+
+	// ~geb: timestamps count from the earliest zone, which keeps
+	//       them short and exact as doubles
+	u64 base = U64_MAX;
+	for (Prof_Thread *thread = AtomicLoadPtr(&prof_threads); thread; thread = thread->next)
+	{
+		u64 write = AtomicLoadU64(&thread->write);
+		u64 count = Min(write, PROF_EVENTS_PER_THREAD);
+		for (u64 i = write - count; i < write; ++i)
+			base = Min(base, thread->events[i & (PROF_EVENTS_PER_THREAD - 1)].start);
+	}
+
+	bool first = true;
+	for (Prof_Thread *thread = AtomicLoadPtr(&prof_threads); thread; thread = thread->next)
+	{
+		if (thread->name)
+		{
+			_log_builder_pushf(&out, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+			                   first ? "" : ",\n", thread->id);
+			_prof_push_json_string(&out, thread->name);
+			str8_builder_push(&out, S("}}"));
+			first = false;
+		}
+
+		u64 write = AtomicLoadU64(&thread->write);
+		u64 count = Min(write, PROF_EVENTS_PER_THREAD);
+		for (u64 i = write - count; i < write; ++i)
+		{
+			Prof_Event event = thread->events[i & (PROF_EVENTS_PER_THREAD - 1)];
+			_log_builder_pushf(&out, "%s{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"name\":",
+			                   first ? "" : ",\n", thread->id,
+			                   (os_cycles_to_ns(event.start - base) / 1000.0),
+			                   (os_cycles_to_ns(event.duration) / 1000.0));
+			_prof_push_json_string(&out, event.name);
+			_log_builder_pushf(&out, ",\"args\":{\"depth\":%u}}", event.depth);
+			first = false;
+		}
+	}
+
+	str8_builder_push(&out, S("\n]}\n"));
+
+	String8 json = str8_builder_flatten(&out, scratch);
+	str8_builder_delete(&out);
+
+	bool ok = json.len && os_write_to_path(path, json, scratch);
+	if (json.len)
+		str8_delete(scratch, &json);
+	return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////
+//                              JOBS                                   //
+/////////////////////////////////////////////////////////////////////////
+
+// ~geb: slots are written and read field by field through atomics, a
+//       thief may read a slot the owner is refilling but then loses
+//       the CAS on top and throws it away
+
+typedef struct {
+	Job_Proc    *proc;
+	void        *param;
+	Job_Counter *counter;
+} Job;
+
+typedef struct {
+	u64     top;
+	u8      pad0[CACHE_LINE_SIZE - sizeof(u64)];
+	u64     bottom;
+	u8      pad1[CACHE_LINE_SIZE - sizeof(u64)];
+	Job     jobs[JOB_DEQUE_SIZE];
+} Job_Deque;
+
+typedef struct {
+	Job_Deque  deque;
+	Arena     *arena;
+	Allocator  scratch;
+	OS_Thread  thread;
+	u32        index;
+	u64        rng;
+} Job_Worker;
+
+typedef struct {
+	Job_Worker *workers;
+	u32         worker_count;
+	u32         running;
+
+	OS_Mutex    shared_lock;
+	u64         shared_head;
+	u64         shared_tail;
+	Job         shared[JOB_DEQUE_SIZE];
+
+	u8          pad0[CACHE_LINE_SIZE];
+	u32         signal;   // ~geb: futex, bumped on every submit
+	u32         sleepers;
+} Job_System;
+
+global Job_System  *job_system;
+thread_static Job_Worker *job_worker_local;
+
+internal void
+_job_slot_store(Job *slot, Job job)
+{
+	AtomicStorePtr(&slot->proc,    job.proc);
+	AtomicStorePtr(&slot->param,   job.param);
+	AtomicStorePtr(&slot->counter, job.counter);
+}
+
+internal Job
+_job_slot_load(Job *slot)
+{
+	Job job;
+	job.proc    = AtomicLoadPtr(&slot->proc);
+	job.param   = AtomicLoadPtr(&slot->param);
+	job.counter = AtomicLoadPtr(&slot->counter);
+	return job;
+}
+
+internal bool
+_job_deque_push(Job_Deque *deque, Job job)
+{
+	u64 bottom = AtomicLoadRelaxedU64(&deque->bottom);
+	u64 top    = AtomicLoadU64(&deque->top);
+	if (bottom - top >= JOB_DEQUE_SIZE)
+		return false;
+
+	_job_slot_store(&deque->jobs[bottom & (JOB_DEQUE_SIZE - 1)], job);
+	AtomicStoreU64(&deque->bottom, bottom + 1);
+	return true;
+}
+
+internal bool
+_job_deque_pop(Job_Deque *deque, Job *out)
+{
+	u64 bottom = AtomicLoadRelaxedU64(&deque->bottom) - 1;
+	AtomicStoreRelaxedU64(&deque->bottom, bottom);
+	AtomicFence();
+	u64 top = AtomicLoadRelaxedU64(&deque->top);
+
+	if ((i64)(bottom - top) < 0)
+	{
+		AtomicStoreRelaxedU64(&deque->bottom, bottom + 1);
+		return false;
+	}
+
+	*out = _job_slot_load(&deque->jobs[bottom & (JOB_DEQUE_SIZE - 1)]);
+	if (top != bottom)
+		return true;
+
+	// ~geb: last job, race the thieves for it
+	bool won = AtomicCompareExchangeU64(&deque->top, top, top + 1) == top;
+	AtomicStoreRelaxedU64(&deque->bottom, bottom + 1);
+	return won;
+}
+
+internal bool
+_job_deque_steal(Job_Deque *deque, Job *out)
+{
+	u64 top = AtomicLoadU64(&deque->top);
+	AtomicFence();
+	u64 bottom = AtomicLoadU64(&deque->bottom);
+
+	if ((i64)(bottom - top) <= 0)
+		return false;
+
+	*out = _job_slot_load(&deque->jobs[top & (JOB_DEQUE_SIZE - 1)]);
+	return AtomicCompareExchangeU64(&deque->top, top, top + 1) == top;
+}
+
+internal bool
+_job_shared_push(Job_System *system, Job job)
+{
+	bool pushed = false;
+	os_mutex_lock(&system->shared_lock);
+	if (system->shared_head - system->shared_tail < JOB_DEQUE_SIZE)
+	{
+		system->shared[system->shared_head & (JOB_DEQUE_SIZE - 1)] = job;
+		AtomicStoreU64(&system->shared_head, system->shared_head + 1);
+		pushed = true;
+	}
+	os_mutex_unlock(&system->shared_lock);
+	return pushed;
+}
+
+internal bool
+_job_shared_pop(Job_System *system, Job *out)
+{
+	// ~geb: racy peek, keeps idle workers off the lock
+	if (AtomicLoadU64(&system->shared_head) == AtomicLoadU64(&system->shared_tail))
+		return false;
+
+	bool popped = false;
+	os_mutex_lock(&system->shared_lock);
+	if (system->shared_tail != system->shared_head)
+	{
+		*out   = system->shared[system->shared_tail & (JOB_DEQUE_SIZE - 1)];
+		AtomicStoreU64(&system->shared_tail, system->shared_tail + 1);
+		popped = true;
+	}
+	os_mutex_unlock(&system->shared_lock);
+	return popped;
+}
+
+internal bool
+_job_find(Job_System *system, Job_Worker *worker, Job *out)
+{
+	if (_job_deque_pop(&worker->deque, out))
+		return true;
+
+	if (_job_shared_pop(system, out))
+		return true;
+
+	// ~geb: xorshift for where to start, so thieves spread out
+	u64 x = worker->rng;
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	worker->rng = x;
+
+	u32 count = system->worker_count;
+	u32 start = cast(u32)(x % count);
+	for (u32 i = 0; i < count; ++i)
+	{
+		u32 victim = (start + i) % count;
+		if (victim != worker->index && _job_deque_steal(&system->workers[victim].deque, out))
+			return true;
+	}
+
+	return false;
+}
+
+internal void
+_job_run(Job_Worker *worker, Job job)
+{
+	Arena_Scope scope = arena_scope_begin(worker->arena);
+	job.proc(job.param, worker->scratch);
+	arena_scope_end(scope);
+
+	if (job.counter && AtomicAddU32(&job.counter->pending, -1) == 1)
+		os_futex_wake(&job.counter->pending, OS_FUTEX_WAKE_ALL);
+}
+
+internal void
+_job_signal(Job_System *system)
+{
+	AtomicAddU32(&system->signal, 1);
+	if (AtomicLoadU32(&system->sleepers))
+		os_futex_wake(&system->signal, 1);
+}
+
+internal OS_Thread_Proc(_job_worker_thread)
+{
+	Job_Worker *worker = cast(Job_Worker *)param;
+	Job_System *system = job_system;
+	job_worker_local = worker;
+
+	u32 idle = 0;
+	while (AtomicLoadU32(&system->running))
+	{
+		Job job;
+		if (_job_find(system, worker, &job))
+		{
+			_job_run(worker, job);
+			idle = 0;
+			continue;
+		}
+
+		if (++idle < 64)
+		{
+			CpuPause();
+			continue;
+		}
+
+		// ~geb: announce ourselves before the last look, a submit that
+		//       we miss here has to see us and wake us
+		AtomicAddU32(&system->sleepers, 1);
+		u32 signal = AtomicLoadU32(&system->signal);
+		if (_job_find(system, worker, &job))
+		{
+			AtomicAddU32(&system->sleepers, -1);
+			_job_run(worker, job);
+			idle = 0;
+			continue;
+		}
+		if (AtomicLoadU32(&system->running))
+			os_futex_wait(&system->signal, signal, OS_WAIT_INFINITE);
+		AtomicAddU32(&system->sleepers, -1);
+		idle = 0;
+	}
+
+	job_worker_local = 0;
+}
+
+internal bool
+job_system_init(u32 worker_count)
+{
+	if (job_system)
+		return false;
+
+	if (!worker_count)
+		worker_count = os_core_count();
+	// ~geb: worker 0 only runs jobs while the caller waits, keep one
+	//       thread that always does
+	worker_count = Clamp(2, worker_count, JOB_MAX_WORKERS);
+
+	Allocator heap = heap_allocator();
+	Job_System *system  = alloc(heap, Job_System, NULL);
+	Job_Worker *workers = cast(Job_Worker *)mem_alloc_aligned(heap, worker_count * sizeof(Job_Worker),
+	                                                           CACHE_LINE_SIZE, true, NULL);
+	if (!system || !workers)
+	{
+		if (system)
+			mem_free(heap, system, NULL);
+		if (workers)
+			mem_free(heap, workers, NULL);
+		return false;
+	}
+
+	system->workers      = workers;
+	system->worker_count = worker_count;
+	system->running      = 1;
+
+	for (u32 i = 0; i < worker_count; ++i)
+	{
+		Job_Worker *worker   = &workers[i];
+		worker->index        = i;
+		worker->rng          = 0x9e3779b97f4a7c15ull * (i + 1);
+		worker->deque.top    = 1;
+		worker->deque.bottom = 1;
+		worker->arena        = _arena_new(JOB_SCRATCH_SIZE);
+		worker->scratch      = (Allocator){ .proc = arena_allocator_proc, .data = worker->arena };
+		if (!worker->arena)
+		{
+			job_system = system;
+			job_system_shutdown();
+			return false;
+		}
+	}
+
+	job_system       = system;
+	job_worker_local = &workers[0];
+	workers[0].thread = os_thread_self();
+
+	for (u32 i = 1; i < worker_count; ++i)
+	{
+		workers[i].thread = os_thread_create(_job_worker_thread, &workers[i]);
+		if (!workers[i].thread)
+		{
+			job_system_shutdown();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+internal void
+job_system_shutdown(void)
+{
+	Job_System *system = job_system;
+	if (!system)
+		return;
+
+	AtomicStoreU32(&system->running, 0);
+	AtomicAddU32(&system->signal, 1);
+	os_futex_wake(&system->signal, OS_FUTEX_WAKE_ALL);
+
+	// ~geb: init may have failed part way, worker 0 is the caller
+	for (u32 i = 1; i < system->worker_count; ++i)
+	{
+		if (system->workers[i].thread)
+			os_thread_join(system->workers[i].thread);
+	}
+
+	for (u32 i = 0; i < system->worker_count; ++i)
+	{
+		Arena *arena = system->workers[i].arena;
+		if (arena)
+			os_release(arena, sizeof(Arena) + arena->reserved);
+	}
+
+	Allocator heap = heap_allocator();
+	mem_free(heap, system->workers, NULL);
+	mem_free(heap, system, NULL);
+	job_system       = 0;
+	job_worker_local = 0;
+}
+
+internal u32
+job_worker_count(void)
+{
+	return job_system ? job_system->worker_count : 0;
+}
+
+internal u32
+job_worker_index(void)
+{
+	return job_worker_local ? job_worker_local->index : U32_MAX;
+}
+
+internal void
+job_submit(Job_Proc *proc, void *param, Job_Counter *counter)
+{
+	if (counter)
+		AtomicAddU32(&counter->pending, 1);
+
+	Job job = { proc, param, counter };
+	Job_System *system = job_system;
+	Job_Worker *worker = job_worker_local;
+
+	bool queued = false;
+	if (system && worker)
+		queued = _job_deque_push(&worker->deque, job);
+	else if (system)
+		queued = _job_shared_push(system, job);
+
+	if (queued)
+	{
+		_job_signal(system);
+		return;
+	}
+
+	// ~geb: no system or the queue is full
+	if (worker)
+	{
+		_job_run(worker, job);
+	}
+	else
+	{
+		Allocator scratch = arena_allocator(JOB_SCRATCH_SIZE);
+		proc(param, scratch);
+		Arena *arena = cast(Arena *)scratch.data;
+		if (arena)
+			os_release(arena, sizeof(Arena) + arena->reserved);
+		if (counter && AtomicAddU32(&counter->pending, -1) == 1)
+			os_futex_wake(&counter->pending, OS_FUTEX_WAKE_ALL);
+	}
+}
+
+internal void
+job_wait(Job_Counter *counter)
+{
+	Job_System *system = job_system;
+	Job_Worker *worker = job_worker_local;
+	u32 idle = 0;
+
+	u32 pending;
+	while ((pending = AtomicLoadU32(&counter->pending)) != 0)
+	{
+		Job job;
+		if (system && worker && _job_find(system, worker, &job))
+		{
+			_job_run(worker, job);
+			idle = 0;
+			continue;
+		}
+
+		if (++idle < 64)
+		{
+			CpuPause();
+			continue;
+		}
+
+		// ~geb: workers wake us on zero but new stealable work does not,
+		//       so helpers only nap
+		os_futex_wait(&counter->pending, pending, worker ? 50000 : OS_WAIT_INFINITE);
+		idle = 0;
+	}
+}
+
+// ~geb: parallel algorithms
+
+typedef struct {
+	void                 *items;
+	usize                 count;
+	usize                 grain;
+	Parallel_For_Proc    *for_proc;
+	Parallel_Reduce_Proc *reduce_proc;
+	void                 *param;
+	u8                   *partials;
+	usize                 partial_stride;
+	bool                  per_chunk;
+} Parallel_Task;
+
+typedef struct {
+	Parallel_Task *task;
+	usize          chunk_begin;
+	usize          chunk_end;
+} Parallel_Range;
+
+internal usize
+_parallel_grain(usize count, usize grain)
+{
+	if (grain)
+		return grain;
+	return Max(count / PARALLEL_AUTO_CHUNKS, PARALLEL_MIN_GRAIN);
+}
+
+internal Job_Proc(_parallel_range_job)
+{
+	(void)scratch;
+	Parallel_Range  range = *cast(Parallel_Range *)param;
+	Parallel_Task  *task  = range.task;
+
+	// ~geb: hand off the right half until one chunk is left, the
+	//       halves sit on this stack until the wait below
+	Parallel_Range right[64];
+	u32            right_count = 0;
+	Job_Counter    counter     = {0};
+	while (range.chunk_end - range.chunk_begin > 1 && right_count < ArrayCount(right))
+	{
+		usize mid = range.chunk_begin + (range.chunk_end - range.chunk_begin) / 2;
+		right[right_count] = (Parallel_Range){ task, mid, range.chunk_end };
+		job_submit(_parallel_range_job, &right[right_count], &counter);
+		right_count += 1;
+		range.chunk_end = mid;
+	}
+
+	for (usize chunk = range.chunk_begin; chunk < range.chunk_end; ++chunk)
+	{
+		usize begin = chunk * task->grain;
+		usize end   = Min(begin + task->grain, task->count);
+		if (task->for_proc)
+		{
+			task->for_proc(task->items, begin, end, task->param);
+		}
+		else
+		{
+			u32 slot = task->per_chunk ? cast(u32)chunk : job_worker_index();
+			if (slot == U32_MAX)
+				slot = job_worker_count(); // ~geb: the caller, running a chunk inline
+			task->reduce_proc(task->items, begin, end, task->param,
+			                  task->partials + slot * task->partial_stride);
+		}
+	}
+
+	job_wait(&counter);
+}
+
+internal void
+_parallel_run(Parallel_Task *task)
+{
+	Parallel_Range root = { task, 0, (task->count + task->grain - 1) / task->grain };
+	if (job_worker_index() != U32_MAX)
+	{
+		_parallel_range_job(&root, job_worker_local->scratch);
+		return;
+	}
+
+	Job_Counter counter = {0};
+	job_submit(_parallel_range_job, &root, &counter);
+	job_wait(&counter);
+}
+
+internal void
+parallel_for(void *items, usize count, usize grain, Parallel_For_Proc *proc, void *param)
+{
+	grain = _parallel_grain(count, grain);
+	if (!job_system || count <= grain)
+	{
+		if (count)
+			proc(items, 0, count, param);
+		return;
+	}
+
+	Parallel_Task task = {0};
+	task.items    = items;
+	task.count    = count;
+	task.grain    = grain;
+	task.for_proc = proc;
+	task.param    = param;
+	_parallel_run(&task);
+}
+
+internal bool
+parallel_reduce(void *items, usize count, usize grain,
+                Parallel_Reduce_Proc *proc, Parallel_Combine_Proc *combine, void *param,
+                void *identity, void *result, usize result_size, bool deterministic)
+{
+	grain = _parallel_grain(count, grain);
+	if (!count)
+		return true;
+	if (!deterministic && (!job_system || count <= grain))
+	{
+		proc(items, 0, count, param, result);
+		return true;
+	}
+
+	usize chunks = (count + grain - 1) / grain;
+	usize stride = AlignPow2(result_size, CACHE_LINE_SIZE);
+	if (deterministic && chunks >= U32_MAX)
+		return false;
+
+	Allocator heap = heap_allocator();
+	if (!job_system || chunks == 1)
+	{
+		// ~geb: same chunks and the same combine order as the
+		//       parallel path, one partial reused for every chunk
+		u8 *partial = cast(u8 *)mem_alloc_aligned(heap, stride, CACHE_LINE_SIZE, false, NULL);
+		if (!partial)
+			return false;
+		for (usize chunk = 0; chunk < chunks; ++chunk)
+		{
+			usize begin = chunk * grain;
+			usize end   = Min(begin + grain, count);
+			MemCopy(partial, identity, result_size);
+			proc(items, begin, end, param, partial);
+			combine(result, partial, param);
+		}
+		mem_free(heap, partial, NULL);
+		return true;
+	}
+
+	usize slots = deterministic ? chunks : job_worker_count() + 1;
+	u8 *partials = cast(u8 *)mem_alloc_aligned(heap, slots * stride, CACHE_LINE_SIZE, false, NULL);
+	if (!partials)
+		return false;
+	for (usize i = 0; i < slots; ++i)
+		MemCopy(partials + i * stride, identity, result_size);
+
+	Parallel_Task task = {0};
+	task.items          = items;
+	task.count          = count;
+	task.grain          = grain;
+	task.reduce_proc    = proc;
+	task.param          = param;
+	task.partials       = partials;
+	task.partial_stride = stride;
+	task.per_chunk      = deterministic;
+	_parallel_run(&task);
+
+	// ~geb: *result is the seed and only goes in once, slots nobody
+	//       ran on still hold the identity
+	for (usize i = 0; i < slots; ++i)
+		combine(result, partials + i * stride, param);
+
+	mem_free(heap, partials, NULL);
+	return true;
+}
+
+internal void
+parallel_for_array(Dynamic_Array *array, usize grain, Parallel_For_Proc *proc, void *param)
+{
+	parallel_for(array->data, array->len, grain, proc, param);
+}
+
+internal bool
+parallel_reduce_array(Dynamic_Array *array, usize grain,
+                      Parallel_Reduce_Proc *proc, Parallel_Combine_Proc *combine, void *param,
+                      void *identity, void *result, usize result_size, bool deterministic)
+{
+	return parallel_reduce(array->data, array->len, grain, proc, combine, param,
+	                       identity, result, result_size, deterministic);
+}
+
+// ~geb: blocked scan, sum every block, scan the block sums serially,
+//       then scan every block again starting from its offset
+
+typedef struct {
+	u64   *out;
+	u64   *in;
+	u64   *sums;
+	usize  count;
+	usize  block;
+	bool   exclusive;
+} Parallel_Scan;
+
+internal Parallel_For_Proc(_parallel_scan_sum_blocks)
+{
+	(void)items;
+	Parallel_Scan *scan = cast(Parallel_Scan *)param;
+	for (usize b = begin; b < end; ++b)
+	{
+		usize first = b * scan->block;
+		usize last  = Min(first + scan->block, scan->count);
+		u64 sum = 0;
+		for (usize i = first; i < last; ++i)
+			sum += scan->in[i];
+		scan->sums[b] = sum;
+	}
+}
+
+internal Parallel_For_Proc(_parallel_scan_blocks)
+{
+	(void)items;
+	Parallel_Scan *scan = cast(Parallel_Scan *)param;
+	for (usize b = begin; b < end; ++b)
+	{
+		usize first = b * scan->block;
+		usize last  = Min(first + scan->block, scan->count);
+		u64 sum = scan->sums[b];
+		if (scan->exclusive)
+		{
+			for (usize i = first; i < last; ++i)
+			{
+				u64 value = scan->in[i];
+				scan->out[i] = sum;
+				sum += value;
+			}
+		}
+		else
+		{
+			for (usize i = first; i < last; ++i)
+			{
+				sum += scan->in[i];
+				scan->out[i] = sum;
+			}
+		}
+	}
+}
+
+internal u64
+parallel_prefix_sum_u64(u64 *out, u64 *in, usize count, bool exclusive)
+{
+	usize block  = _parallel_grain(count, 0);
+	usize blocks = (count + block - 1) / block;
+
+	Allocator heap = heap_allocator();
+	u64 *sums = 0;
+	if (job_system && blocks > 1)
+		sums = alloc_array(heap, u64, blocks, NULL);
+
+	if (!sums)
+	{
+		u64 sum = 0;
+		for (usize i = 0; i < count; ++i)
+		{
+			u64 value = in[i];
+			sum += value;
+			out[i] = exclusive ? sum - value : sum;
+		}
+		return sum;
+	}
+
+	Parallel_Scan scan = { out, in, sums, count, block, exclusive };
+	parallel_for(sums, blocks, 1, _parallel_scan_sum_blocks, &scan);
+
+	u64 total = 0;
+	for (usize b = 0; b < blocks; ++b)
+	{
+		u64 sum = sums[b];
+		sums[b] = total;
+		total  += sum;
+	}
+
+	parallel_for(sums, blocks, 1, _parallel_scan_blocks, &scan);
+	mem_free(heap, sums, NULL);
+	return total;
+}
+
+/////////////////////////////////////////////////////////////////////////
+//                             QUEUES                                  //
+/////////////////////////////////////////////////////////////////////////
+
+#define QUEUE_SPIN 64
+
+internal u64
+_queue_capacity(usize capacity)
+{
+	u64 result = 2;
+	while (result < capacity)
+		result <<= 1;
+	return result;
+}
+
+// ~geb: sleeps on *futex unless it moved past seen, false once the
+//       deadline (0 for none) has passed
+internal bool
+_queue_sleep(u32 *futex, u32 seen, OS_Time_Stamp deadline)
+{
+	u64 timeout = OS_WAIT_INFINITE;
+	if (deadline)
+	{
+		OS_Time_Stamp now = os_time_now();
+		if (now >= deadline)
+			return false;
+		timeout = deadline - now;
+	}
+	os_futex_wait(futex, seen, timeout);
+	return true;
+}
+
+internal OS_Time_Stamp
+_queue_deadline(u64 timeout_ns)
+{
+	return timeout_ns == OS_WAIT_INFINITE ? 0 : os_time_now() + timeout_ns;
+}
+
+// ~geb: spsc
+
+internal bool
+spsc_queue_make(Spsc_Queue *queue, Allocator alloc, usize capacity, usize item_size)
+{
+	MemZeroStruct(queue);
+	u64 slots = _queue_capacity(capacity);
+	queue->data = cast(u8 *)mem_alloc_aligned(alloc, slots * item_size, CACHE_LINE_SIZE, false, NULL);
+	if (!queue->data)
+		return false;
+
+	queue->item_size = item_size;
+	queue->mask      = slots - 1;
+	queue->alloc     = alloc;
+	return true;
+}
+
+internal void
+spsc_queue_delete(Spsc_Queue *queue)
+{
+	if (queue->data)
+		mem_free(queue->alloc, queue->data, NULL);
+	MemZeroStruct(queue);
+}
+
+// ~geb: copies count items into the ring starting at position pos,
+//       wrapping at the end
+internal void
+_spsc_copy_in(Spsc_Queue *queue, u64 pos, u8 *items, usize count)
+{
+	u64 capacity = queue->mask + 1;
+	u64 offset   = pos & queue->mask;
+	u64 first    = Min(count, capacity - offset);
+	MemCopy(queue->data + offset * queue->item_size, items, first * queue->item_size);
+	MemCopy(queue->data, items + first * queue->item_size, (count - first) * queue->item_size);
+}
+
+internal void
+_spsc_copy_out(Spsc_Queue *queue, u64 pos, u8 *out, usize count)
+{
+	u64 capacity = queue->mask + 1;
+	u64 offset   = pos & queue->mask;
+	u64 first    = Min(count, capacity - offset);
+	MemCopy(out, queue->data + offset * queue->item_size, first * queue->item_size);
+	MemCopy(out + first * queue->item_size, queue->data, (count - first) * queue->item_size);
+}
+
+internal usize
+spsc_queue_push(Spsc_Queue *queue, void *items, usize count)
+{
+	u64 capacity = queue->mask + 1;
+	u64 head     = queue->head;
+
+	// ~geb: only look at the consumer's line when the cached tail
+	//       says we are full
+	u64 space = capacity - (head - queue->tail_cache);
+	if (space < count)
+	{
+		queue->tail_cache = AtomicLoadU64(&queue->tail);
+		space = capacity - (head - queue->tail_cache);
+	}
+
+	count = Min(count, space);
+	if (!count)
+		return 0;
+
+	_spsc_copy_in(queue, head, cast(u8 *)items, count);
+	AtomicStoreU64(&queue->head, head + count);
+	return count;
+}
+
+internal usize
+spsc_queue_pop(Spsc_Queue *queue, void *out, usize max_count)
+{
+	u64 tail      = queue->tail;
+	u64 available = queue->head_cache - tail;
+	if (available < max_count)
+	{
+		queue->head_cache = AtomicLoadU64(&queue->head);
+		available = queue->head_cache - tail;
+	}
+
+	usize count = Min(max_count, available);
+	if (!count)
+		return 0;
+
+	_spsc_copy_out(queue, tail, cast(u8 *)out, count);
+	AtomicStoreU64(&queue->tail, tail + count);
+	return count;
+}
+
+internal usize
+spsc_queue_push_wait(Spsc_Queue *queue, void *items, usize count, u64 timeout_ns)
+{
+	OS_Time_Stamp deadline = _queue_deadline(timeout_ns);
+	u8   *bytes  = cast(u8 *)items;
+	usize pushed = 0;
+	u32   spins  = 0;
+
+	for (;;)
+	{
+		usize n = spsc_queue_push(queue, bytes + pushed * queue->item_size, count - pushed);
+		pushed += n;
+		if (n)
+		{
+			// ~geb: orders the head store before the flag check, pairs
+			//       with the fence in pop_wait
+			AtomicFence();
+			if (AtomicLoadU32(&queue->items_waiting))
+			{
+				AtomicAddU32(&queue->pushed, 1);
+				os_futex_wake(&queue->pushed, 1);
+			}
+			spins = 0;
+		}
+		if (pushed == count)
+			return pushed;
+
+		if (++spins < QUEUE_SPIN)
+		{
+			CpuPause();
+			continue;
+		}
+
+		u32 seen = AtomicLoadU32(&queue->popped);
+		AtomicStoreU32(&queue->space_waiting, 1);
+		AtomicFence();
+		bool full = AtomicLoadU64(&queue->tail) + queue->mask + 1 == queue->head;
+		bool alive = !full || _queue_sleep(&queue->popped, seen, deadline);
+		AtomicStoreU32(&queue->space_waiting, 0);
+		if (!alive)
+			return pushed;
+	}
+}
+
+internal usize
+spsc_queue_pop_wait(Spsc_Queue *queue, void *out, usize max_count, u64 timeout_ns)
+{
+	OS_Time_Stamp deadline = _queue_deadline(timeout_ns);
+	u32 spins = 0;
+
+	for (;;)
+	{
+		usize n = spsc_queue_pop(queue, out, max_count);
+		if (n)
+		{
+			AtomicFence();
+			if (AtomicLoadU32(&queue->space_waiting))
+			{
+				AtomicAddU32(&queue->popped, 1);
+				os_futex_wake(&queue->popped, 1);
+			}
+			return n;
+		}
+
+		if (++spins < QUEUE_SPIN)
+		{
+			CpuPause();
+			continue;
+		}
+
+		u32 seen = AtomicLoadU32(&queue->pushed);
+		AtomicStoreU32(&queue->items_waiting, 1);
+		AtomicFence();
+		bool empty = AtomicLoadU64(&queue->head) == queue->tail;
+		bool alive = !empty || _queue_sleep(&queue->pushed, seen, deadline);
+		AtomicStoreU32(&queue->items_waiting, 0);
+		if (!alive)
+			return 0;
+	}
+}
+
+// ~geb: mpmc, every cell carries a sequence number. A cell at
+//       position p is free for the producer that claims p when its
+//       sequence is p, and full for the consumer of p at p + 1. The
+//       consumer hands it to the next lap with p + capacity.
+
+internal bool
+mpmc_queue_make(Mpmc_Queue *queue, Allocator alloc, usize capacity, usize item_size)
+{
+	MemZeroStruct(queue);
+	u64   slots     = _queue_capacity(capacity);
+	usize cell_size = AlignPow2(sizeof(u64) + item_size, sizeof(u64));
+	queue->cells = cast(u8 *)mem_alloc_aligned(alloc, slots * cell_size, CACHE_LINE_SIZE, false, NULL);
+	if (!queue->cells)
+		return false;
+
+	for (u64 i = 0; i < slots; ++i)
+		*cast(u64 *)(queue->cells + i * cell_size) = i;
+
+	queue->cell_size = cell_size;
+	queue->item_size = item_size;
+	queue->mask      = slots - 1;
+	queue->alloc     = alloc;
+	return true;
+}
+
+internal void
+mpmc_queue_delete(Mpmc_Queue *queue)
+{
+	if (queue->cells)
+		mem_free(queue->alloc, queue->cells, NULL);
+	MemZeroStruct(queue);
+}
+
+internal bool
+mpmc_queue_push(Mpmc_Queue *queue, void *item)
+{
+	u64 pos = AtomicLoadRelaxedU64(&queue->enqueue);
+	for (;;)
+	{
+		u8 *cell = queue->cells + (pos & queue->mask) * queue->cell_size;
+		u64 seq  = AtomicLoadU64(cast(u64 *)cell);
+		i64 diff = cast(i64)(seq - pos);
+		if (diff == 0)
+		{
+			u64 seen = AtomicCompareExchangeU64(&queue->enqueue, pos, pos + 1);
+			if (seen == pos)
+			{
+				MemCopy(cell + sizeof(u64), item, queue->item_size);
+				AtomicStoreU64(cast(u64 *)cell, pos + 1);
+				return true;
+			}
+			pos = seen;
+		}
+		else if (diff < 0)
+		{
+			return false;
+		}
+		else
+		{
+			pos = AtomicLoadRelaxedU64(&queue->enqueue);
+		}
+	}
+}
+
+internal bool
+mpmc_queue_pop(Mpmc_Queue *queue, void *out)
+{
+	u64 pos = AtomicLoadRelaxedU64(&queue->dequeue);
+	for (;;)
+	{
+		u8 *cell = queue->cells + (pos & queue->mask) * queue->cell_size;
+		u64 seq  = AtomicLoadU64(cast(u64 *)cell);
+		i64 diff = cast(i64)(seq - (pos + 1));
+		if (diff == 0)
+		{
+			u64 seen = AtomicCompareExchangeU64(&queue->dequeue, pos, pos + 1);
+			if (seen == pos)
+			{
+				MemCopy(out, cell + sizeof(u64), queue->item_size);
+				AtomicStoreU64(cast(u64 *)cell, pos + queue->mask + 1);
+				return true;
+			}
+			pos = seen;
+		}
+		else if (diff < 0)
+		{
+			return false;
+		}
+		else
+		{
+			pos = AtomicLoadRelaxedU64(&queue->dequeue);
+		}
+	}
+}
+
+internal bool
+mpmc_queue_push_wait(Mpmc_Queue *queue, void *item, u64 timeout_ns)
+{
+	OS_Time_Stamp deadline = _queue_deadline(timeout_ns);
+	u32 spins = 0;
+
+	for (;;)
+	{
+		bool pushed = mpmc_queue_push(queue, item);
+		if (!pushed && ++spins < QUEUE_SPIN)
+		{
+			CpuPause();
+			continue;
+		}
+
+		bool alive = true;
+		if (!pushed)
+		{
+			AtomicAddU32(&queue->push_waiters, 1);
+			u32 seen = AtomicLoadU32(&queue->popped);
+			pushed = mpmc_queue_push(queue, item);
+			alive  = pushed || _queue_sleep(&queue->popped, seen, deadline);
+			AtomicAddU32(&queue->push_waiters, -1);
+		}
+
+		if (pushed)
+		{
+			AtomicFence();
+			if (AtomicLoadU32(&queue->pop_waiters))
+			{
+				AtomicAddU32(&queue->pushed, 1);
+				os_futex_wake(&queue->pushed, 1);
+			}
+			return true;
+		}
+		if (!alive)
+			return false;
+	}
+}
+
+internal bool
+mpmc_queue_pop_wait(Mpmc_Queue *queue, void *out, u64 timeout_ns)
+{
+	OS_Time_Stamp deadline = _queue_deadline(timeout_ns);
+	u32 spins = 0;
+
+	for (;;)
+	{
+		bool popped = mpmc_queue_pop(queue, out);
+		if (!popped && ++spins < QUEUE_SPIN)
+		{
+			CpuPause();
+			continue;
+		}
+
+		bool alive = true;
+		if (!popped)
+		{
+			AtomicAddU32(&queue->pop_waiters, 1);
+			u32 seen = AtomicLoadU32(&queue->pushed);
+			popped = mpmc_queue_pop(queue, out);
+			alive  = popped || _queue_sleep(&queue->pushed, seen, deadline);
+			AtomicAddU32(&queue->pop_waiters, -1);
+		}
+
+		if (popped)
+		{
+			AtomicFence();
+			if (AtomicLoadU32(&queue->push_waiters))
+			{
+				AtomicAddU32(&queue->popped, 1);
+				os_futex_wake(&queue->popped, 1);
+			}
+			return true;
+		}
+		if (!alive)
+			return false;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////
+//                             FIBERS                                  //
+/////////////////////////////////////////////////////////////////////////
+
+// ~geb: base_fiber_switch(&from->sp, to->sp) pushes the callee saved
+//       registers, stores the stack pointer, switches to the other
+//       stack and pops its registers. A new fiber's stack is built to
+//       look like it switched out just before base_fiber_start, which
+//       calls the entry with the fiber. The symbols stay local to
+//       this object.
+
+void base_fiber_switch(void **from_sp, void *to_sp);
+void base_fiber_start(void);
+
+#if FIBER_SUPPORTED && ARCH_X64
+__asm__(
+	".text\n"
+	".p2align 4\n"
+	"base_fiber_switch:\n"
+	"	pushq %rbp\n"
+	"	pushq %rbx\n"
+	"	pushq %r12\n"
+	"	pushq %r13\n"
+	"	pushq %r14\n"
+	"	pushq %r15\n"
+	"	subq $8, %rsp\n"
+	"	stmxcsr (%rsp)\n"
+	"	fnstcw 4(%rsp)\n"
+	"	movq %rsp, (%rdi)\n"
+	"	movq %rsi, %rsp\n"
+	"	ldmxcsr (%rsp)\n"
+	"	fldcw 4(%rsp)\n"
+	"	addq $8, %rsp\n"
+	"	popq %r15\n"
+	"	popq %r14\n"
+	"	popq %r13\n"
+	"	popq %r12\n"
+	"	popq %rbx\n"
+	"	popq %rbp\n"
+	"	ret\n"
+	".p2align 4\n"
+	"base_fiber_start:\n"
+	"	movq %r12, %rdi\n"
+	"	callq *%r13\n"
+	"	ud2\n"
+);
+
+#define FIBER_FRAME_WORDS 8
+
+internal void *
+_fiber_initial_sp(u8 *top, Fiber *fiber, void (*entry)(Fiber *))
+{
+	// ~geb: ret pops the last word, leaving rsp 16 byte aligned for the call
+	u64 *sp = cast(u64 *)(AlignDownPow2(cast(usize)top, 16) - FIBER_FRAME_WORDS * sizeof(u64));
+	sp[0] = 0x1f80 | (cast(u64)0x037f << 32); // ~geb: default mxcsr and x87 control word
+	sp[1] = 0;                                // ~geb: r15
+	sp[2] = 0;                                // ~geb: r14
+	sp[3] = cast(u64)entry;                   // ~geb: r13
+	sp[4] = cast(u64)fiber;                   // ~geb: r12
+	sp[5] = 0;                                // ~geb: rbx
+	sp[6] = 0;                                // ~geb: rbp
+	sp[7] = cast(u64)base_fiber_start;
+	return sp;
+}
+#elif FIBER_SUPPORTED && ARCH_ARM64
+__asm__(
+	".text\n"
+	".p2align 4\n"
+	"base_fiber_switch:\n"
+	"	sub sp, sp, #160\n"
+	"	stp x19, x20, [sp, #0]\n"
+	"	stp x21, x22, [sp, #16]\n"
+	"	stp x23, x24, [sp, #32]\n"
+	"	stp x25, x26, [sp, #48]\n"
+	"	stp x27, x28, [sp, #64]\n"
+	"	stp x29, x30, [sp, #80]\n"
+	"	stp d8,  d9,  [sp, #96]\n"
+	"	stp d10, d11, [sp, #112]\n"
+	"	stp d12, d13, [sp, #128]\n"
+	"	stp d14, d15, [sp, #144]\n"
+	"	mov x2, sp\n"
+	"	str x2, [x0]\n"
+	"	mov sp, x1\n"
+	"	ldp x19, x20, [sp, #0]\n"
+	"	ldp x21, x22, [sp, #16]\n"
+	"	ldp x23, x24, [sp, #32]\n"
+	"	ldp x25, x26, [sp, #48]\n"
+	"	ldp x27, x28, [sp, #64]\n"
+	"	ldp x29, x30, [sp, #80]\n"
+	"	ldp d8,  d9,  [sp, #96]\n"
+	"	ldp d10, d11, [sp, #112]\n"
+	"	ldp d12, d13, [sp, #128]\n"
+	"	ldp d14, d15, [sp, #144]\n"
+	"	add sp, sp, #160\n"
+	"	ret\n"
+	".p2align 4\n"
+	"base_fiber_start:\n"
+	"	mov x0, x19\n"
+	"	blr x20\n"
+	"	brk #0\n"
+);
+
+#define FIBER_FRAME_WORDS 20
+
+internal void *
+_fiber_initial_sp(u8 *top, Fiber *fiber, void (*entry)(Fiber *))
+{
+	u64 *sp = cast(u64 *)(AlignDownPow2(cast(usize)top, 16) - FIBER_FRAME_WORDS * sizeof(u64));
+	MemZero(sp, FIBER_FRAME_WORDS * sizeof(u64));
+	sp[0]  = cast(u64)fiber;            // ~geb: x19
+	sp[1]  = cast(u64)entry;            // ~geb: x20
+	sp[11] = cast(u64)base_fiber_start; // ~geb: x30
+	return sp;
+}
+#endif
+
+thread_static Fiber *fiber_current_local;
+
+internal void
+_fiber_main(Fiber *fiber)
+{
+	fiber->proc(fiber->param);
+	fiber->done = true;
+	base_fiber_switch(&fiber->sp, fiber->caller_sp);
+}
+
+// ~geb: (re)starts a fiber on the mapping it already has
+internal void
+_fiber_prepare(Fiber *fiber, Fiber_Proc *proc, void *param)
+{
+#if FIBER_SUPPORTED
+	u8   *mapping = fiber->mapping;
+	usize size    = fiber->mapping_size;
+	MemZeroStruct(fiber);
+	fiber->mapping      = mapping;
+	fiber->mapping_size = size;
+	fiber->proc         = proc;
+	fiber->param        = param;
+	fiber->sp           = _fiber_initial_sp(cast(u8 *)fiber, fiber, _fiber_main);
+#endif
+}
+
+internal Fiber *
+fiber_create(Fiber_Proc *proc, void *param, usize stack_size)
+{
+#if FIBER_SUPPORTED
+	usize page = os_page_size();
+	usize guard = FIBER_GUARD_PAGE ? page : 0;
+	stack_size = AlignPow2(stack_size ? stack_size : FIBER_DEFAULT_STACK, page);
+
+	// ~geb: [guard page][stack ... Fiber], overflowing runs into the guard
+	usize header  = AlignPow2(sizeof(Fiber), 16);
+	usize size    = guard + stack_size + AlignPow2(header, page);
+	u8   *mapping = cast(u8 *)os_reserve(size);
+	if (!mapping)
+		return 0;
+	if (os_commit(mapping + guard, size - guard) != 0)
+	{
+		os_release(mapping, size);
+		return 0;
+	}
+
+	Fiber *fiber = cast(Fiber *)(mapping + size - header);
+	fiber->mapping      = mapping;
+	fiber->mapping_size = size;
+	_fiber_prepare(fiber, proc, param);
+	return fiber;
+#else
+	return 0;
+#endif
+}
+
+internal void
+fiber_delete(Fiber *fiber)
+{
+	if (fiber)
+		os_release(fiber->mapping, fiber->mapping_size);
+}
+
+internal bool
+fiber_resume(Fiber *fiber)
+{
+	if (fiber->done)
+		return false;
+
+	Fiber *previous = fiber_current_local;
+	fiber_current_local = fiber;
+	base_fiber_switch(&fiber->caller_sp, fiber->sp);
+	fiber_current_local = previous;
+	return !fiber->done;
+}
+
+internal void
+fiber_yield(void)
+{
+	Fiber *fiber = fiber_current_local;
+	if (fiber)
+		base_fiber_switch(&fiber->sp, fiber->caller_sp);
+}
+
+internal Fiber *
+fiber_current(void)
+{
+	return fiber_current_local;
+}
+
+// ~geb: scheduler
+
+internal bool
+fiber_scheduler_make(Fiber_Scheduler *scheduler, Allocator alloc, usize stack_size)
+{
+	MemZeroStruct(scheduler);
+	scheduler->stack_size = stack_size ? stack_size : FIBER_DEFAULT_STACK;
+	timer_wheel_make(&scheduler->timers, alloc, FIBER_TIMER_RESOLUTION, os_time_now());
+
+	// ~geb: an arena cannot grow an array from nothing
+	scheduler->io = dynamic_array(alloc, Fiber_Io, FIBER_IO_HANDLES);
+	if (!scheduler->io.data || !os_event_loop_make(&scheduler->loop, alloc))
+	{
+		dynamic_array_delete(&scheduler->io);
+		timer_wheel_delete(&scheduler->timers);
+		return false;
+	}
+	return true;
+}
+
+internal void
+_fiber_delete_list(Fiber *fiber)
+{
+	while (fiber)
+	{
+		Fiber *next = fiber->next;
+		fiber_delete(fiber);
+		fiber = next;
+	}
+}
+
+internal void
+fiber_scheduler_delete(Fiber_Scheduler *scheduler)
+{
+	_fiber_delete_list(scheduler->ready_first);
+	_fiber_delete_list(scheduler->parked);
+	_fiber_delete_list(scheduler->pool);
+	os_event_loop_delete(&scheduler->loop);
+	timer_wheel_delete(&scheduler->timers);
+	dynamic_array_delete(&scheduler->io);
+	MemZeroStruct(scheduler);
+}
+
+internal void
+_fiber_make_ready(Fiber_Scheduler *scheduler, Fiber *fiber)
+{
+	fiber->next    = 0;
+	fiber->waiting = false;
+	if (scheduler->ready_last)
+		scheduler->ready_last->next = fiber;
+	else
+		scheduler->ready_first = fiber;
+	scheduler->ready_last = fiber;
+}
+
+internal bool
+fiber_spawn(Fiber_Scheduler *scheduler, Fiber_Proc *proc, void *param)
+{
+	Fiber *fiber = scheduler->pool;
+	if (fiber)
+	{
+		scheduler->pool    = fiber->next;
+		scheduler->pooled -= 1;
+		_fiber_prepare(fiber, proc, param);
+	}
+	else
+	{
+		fiber = fiber_create(proc, param, scheduler->stack_size);
+		if (!fiber)
+			return false;
+	}
+
+	fiber->scheduler = scheduler;
+	scheduler->live += 1;
+	_fiber_make_ready(scheduler, fiber);
+	return true;
+}
+
+internal void
+_fiber_retire(Fiber_Scheduler *scheduler, Fiber *fiber)
+{
+	scheduler->live -= 1;
+	if (scheduler->pooled >= FIBER_POOL_MAX)
+	{
+		fiber_delete(fiber);
+		return;
+	}
+
+	fiber->next     = scheduler->pool;
+	scheduler->pool = fiber;
+	scheduler->pooled += 1;
+}
+
+internal OS_Watch_Proc(_fiber_io_ready);
+
+// ~geb: points the handle's watch at what its waiters still want,
+//       dropping it with the last one
+internal bool
+_fiber_io_update(Fiber_Scheduler *scheduler, OS_Handle handle, Fiber_Io *io)
+{
+	OS_IoFlags events = 0;
+	for (Fiber *waiter = io->waiters; waiter; waiter = waiter->wait_next)
+		events |= waiter->wait_events;
+
+	bool ok = true;
+	if (!events)
+	{
+		if (io->watch)
+			os_event_loop_unwatch(&scheduler->loop, io->watch);
+		io->watch = 0;
+	}
+	else if (!io->watch)
+	{
+		io->watch = os_event_loop_watch(&scheduler->loop, handle, events, _fiber_io_ready, scheduler);
+		ok = io->watch != 0;
+	}
+	else if (events != io->events)
+	{
+		ok = os_event_loop_modify(&scheduler->loop, io->watch, events);
+	}
+
+	io->events = ok ? events : io->events;
+	return ok;
+}
+
+internal void
+_fiber_io_leave(Fiber_Scheduler *scheduler, Fiber *fiber)
+{
+	Fiber_Io *io = cast(Fiber_Io *)scheduler->io.data + fiber->wait_handle;
+	for (Fiber **link = &io->waiters; *link; link = &(*link)->wait_next)
+	{
+		if (*link == fiber)
+		{
+			*link = fiber->wait_next;
+			break;
+		}
+	}
+
+	fiber->wait_next   = 0;
+	fiber->wait_events = 0;
+	_fiber_io_update(scheduler, fiber->wait_handle, io);
+}
+
+// ~geb: whichever of the watch and the timer comes first wakes the
+//       fiber and takes the other one down
+internal void
+_fiber_wake(Fiber *fiber, OS_IoFlags ready)
+{
+	Fiber_Scheduler *scheduler = fiber->scheduler;
+	if (fiber->wait_events)
+		_fiber_io_leave(scheduler, fiber);
+	timer_wheel_cancel(&scheduler->timers, fiber->wait_timer);
+	fiber->wait_timer = (Timer_Handle){0};
+	fiber->wait_ready = ready;
+
+	if (fiber->prev)
+		fiber->prev->next = fiber->next;
+	else
+		scheduler->parked = fiber->next;
+	if (fiber->next)
+		fiber->next->prev = fiber->prev;
+	_fiber_make_ready(scheduler, fiber);
+}
+
+// ~geb: errors and hang ups wake every waiter, the rest only the
+//       ones asking for that direction
+internal OS_Watch_Proc(_fiber_io_ready)
+{
+	(void)loop;
+	Fiber_Scheduler *scheduler = cast(Fiber_Scheduler *)param;
+	Fiber_Io        *io        = cast(Fiber_Io *)scheduler->io.data + handle;
+	Fiber           *waiter    = io->waiters;
+	while (waiter)
+	{
+		Fiber *next = waiter->wait_next;
+		OS_IoFlags mine = ready & (waiter->wait_events | OS_IoFlag_Error | OS_IoFlag_HangUp);
+		if (mine)
+			_fiber_wake(waiter, mine);
+		waiter = next;
+	}
+}
+
+internal Timer_Wheel_Proc(_fiber_timed_out)
+{
+	(void)wheel;
+	_fiber_wake(cast(Fiber *)param, 0);
+}
+
+// ~geb: dispatches what woke up, blocking until the next timer when
+//       nothing is ready yet
+internal void
+_fiber_poll_parked(Fiber_Scheduler *scheduler, bool block)
+{
+	u64 timeout = 0;
+	if (block)
+	{
+		OS_Time_Stamp deadline = timer_wheel_next_deadline(&scheduler->timers);
+		OS_Time_Stamp now      = os_time_now();
+		timeout = !deadline ? OS_WAIT_INFINITE : (deadline > now ? deadline - now : 0);
+	}
+
+	os_event_loop_run_once(&scheduler->loop, timeout);
+	if (scheduler->timers.count)
+		timer_wheel_advance(&scheduler->timers, os_time_now());
+}
+
+internal void
+fiber_scheduler_run(Fiber_Scheduler *scheduler)
+{
+	while (scheduler->live)
+	{
+		if (!scheduler->ready_first)
+		{
+			_fiber_poll_parked(scheduler, true);
+			continue;
+		}
+
+		// ~geb: one lap over what is ready now, then a look at the
+		//       parked fibers so a busy run queue cannot starve them.
+		//       Fibers that park put themselves on the parked list
+		Fiber *last = scheduler->ready_last;
+		for (;;)
+		{
+			Fiber *fiber = scheduler->ready_first;
+			scheduler->ready_first = fiber->next;
+			if (!scheduler->ready_first)
+				scheduler->ready_last = 0;
+			fiber->next = 0;
+
+			if (!fiber_resume(fiber))
+				_fiber_retire(scheduler, fiber);
+			else if (!fiber->waiting)
+				_fiber_make_ready(scheduler, fiber);
+
+			if (fiber == last)
+				break;
+		}
+
+		if (scheduler->parked)
+			_fiber_poll_parked(scheduler, false);
+	}
+}
+
+internal OS_Time_Stamp
+_fiber_deadline(u64 timeout_ns)
+{
+	OS_Time_Stamp now = os_time_now();
+	return timeout_ns > U64_MAX - now ? U64_MAX : now + timeout_ns;
+}
+
+internal void
+_fiber_park(Fiber *fiber)
+{
+	Fiber_Scheduler *scheduler = fiber->scheduler;
+	fiber->waiting = true;
+	fiber->prev    = 0;
+	fiber->next    = scheduler->parked;
+	if (scheduler->parked)
+		scheduler->parked->prev = fiber;
+	scheduler->parked = fiber;
+	fiber_yield();
+}
+
+internal OS_IoFlags
+fiber_wait_io(OS_Handle handle, OS_IoFlags events, u64 timeout_ns)
+{
+	Fiber *fiber = fiber_current_local;
+	if (!fiber || !fiber->scheduler)
+	{
+		OS_Poll_Entry entry = { handle, events, 0 };
+		os_poll(&entry, 1, timeout_ns);
+		return entry.ready;
+	}
+
+	// ~geb: epoll refuses regular files, they and a failed watch get
+	//       one look instead of parking
+	Fiber_Scheduler *scheduler = fiber->scheduler;
+	OS_IoFlags       wanted    = events & (OS_IoFlag_Read | OS_IoFlag_Write);
+	Fiber_Io        *io        = 0;
+	if (timeout_ns && wanted && handle > 0 &&
+	    dynamic_array_reserve(&scheduler->io, sizeof(Fiber_Io), AlignOf(Fiber_Io), cast(usize)handle + 1))
+	{
+		if (scheduler->io.len <= cast(usize)handle)
+		{
+			MemZero(cast(Fiber_Io *)scheduler->io.data + scheduler->io.len,
+			        (cast(usize)handle + 1 - scheduler->io.len) * sizeof(Fiber_Io));
+			scheduler->io.len = cast(usize)handle + 1;
+		}
+		io = cast(Fiber_Io *)scheduler->io.data + handle;
+
+		fiber->wait_handle = handle;
+		fiber->wait_events = wanted;
+		fiber->wait_next   = io->waiters;
+		io->waiters        = fiber;
+		if (!_fiber_io_update(scheduler, handle, io))
+		{
+			_fiber_io_leave(scheduler, fiber);
+			io = 0;
+		}
+	}
+	if (!io)
+	{
+		OS_Poll_Entry entry = { handle, events, 0 };
+		os_poll(&entry, 1, 0);
+		return entry.ready;
+	}
+
+	if (timeout_ns != OS_WAIT_INFINITE)
+	{
+		fiber->wait_timer = timer_wheel_add(&scheduler->timers, _fiber_deadline(timeout_ns), _fiber_timed_out, fiber);
+		if (!fiber->wait_timer.node)
+		{
+			_fiber_io_leave(scheduler, fiber);
+			return 0;
+		}
+	}
+
+	_fiber_park(fiber);
+	return fiber->wait_ready;
+}
+
+internal void
+fiber_sleep_ns(u64 ns)
+{
+	Fiber *fiber = fiber_current_local;
+	if (!fiber || !fiber->scheduler)
+	{
+		os_sleep_ns(ns);
+		return;
+	}
+
+	// ~geb: out of timer nodes, block the thread rather than wake early
+	Fiber_Scheduler *scheduler = fiber->scheduler;
+	fiber->wait_timer = timer_wheel_add(&scheduler->timers, _fiber_deadline(ns), _fiber_timed_out, fiber);
+	if (!fiber->wait_timer.node)
+	{
+		os_sleep_ns(ns);
+		return;
+	}
+
+	_fiber_park(fiber);
+}
+
+/////////////////////////////////////////////////////////////////////////
+//                          RING BUFFER                                //
+/////////////////////////////////////////////////////////////////////////
+
+internal Ring_Buffer
+ring_buffer_make(usize min_size)
 {
-    printf("%s--------[ %s ]--------\n%s", color, level, ANSI_RESET);
-    vprintf(fmt, args);
-    printf("\n");
+	Ring_Buffer ring = {0};
+
+	usize page = os_page_size();
+	usize size = page;
+	while (size < min_size && size <= USIZE_MAX / 4)
+		size <<= 1;
+
+	ring.data = cast(u8 *)os_ring_map(size);
+	if (ring.data)
+		ring.size = size;
+	return ring;
 }
 
-internal void log_debug(const char* fmt, ...)
+internal void
+ring_buffer_delete(Ring_Buffer *ring)
 {
-    va_list args;
-    va_start(args, fmt);
-    log_base(ANSI_GRAY, "DEBUG", fmt, args);
-    va_end(args);
+	os_ring_unmap(ring->data, ring->size);
+	MemZeroStruct(ring);
 }
 
-internal void log_info(const char* fmt, ...)
+internal String8
+ring_buffer_readable(Ring_Buffer *ring)
 {
-    va_list args;
-    va_start(args, fmt);
-    log_base(ANSI_GREEN, "INFO ", fmt, args);
-    va_end(args);
+	u64 read  = ring->read;
+	u64 write = AtomicLoadU64(&ring->write);
+	return (String8){ .len = write - read, .str = ring->data + (read & (ring->size - 1)) };
 }
 
-internal void log_warn(const char* fmt, ...)
+internal String8
+ring_buffer_writable(Ring_Buffer *ring)
 {
-    va_list args;
-    va_start(args, fmt);
-    log_base(ANSI_YELLOW, "WARN ", fmt, args);
-    va_end(args);
+	u64 read  = AtomicLoadU64(&ring->read);
+	u64 write = ring->write;
+	return (String8){ .len = ring->size - (write - read), .str = ring->data + (write & (ring->size - 1)) };
 }
 
-internal void log_error(const char* fmt, ...)
+internal void
+ring_buffer_commit(Ring_Buffer *ring, usize size)
 {
-    va_list args;
-    va_start(args, fmt);
-    log_base(ANSI_RED, "ERROR", fmt, args);
-    va_end(args);
+	Assert(size <= ring_buffer_writable(ring).len);
+	AtomicStoreU64(&ring->write, ring->write + size);
+}
+
+internal void
+ring_buffer_consume(Ring_Buffer *ring, usize size)
+{
+	Assert(size <= ring_buffer_readable(ring).len);
+	AtomicStoreU64(&ring->read, ring->read + size);
+}
+
+internal usize
+ring_buffer_write(Ring_Buffer *ring, String8 data)
+{
+	String8 space = ring_buffer_writable(ring);
+	usize size = Min(space.len, data.len);
+	MemCopy(space.str, data.str, size);
+	ring_buffer_commit(ring, size);
+	return size;
+}
+
+internal usize
+ring_buffer_read_file(Ring_Buffer *ring, OS_Handle file, usize offset)
+{
+	String8 space = ring_buffer_writable(ring);
+	if (!space.len)
+		return 0;
+
+	usize size = os_file_read(file, offset, offset + space.len, space.str);
+	ring_buffer_commit(ring, size);
+	return size;
+}
+
+internal usize
+ring_buffer_write_file(Ring_Buffer *ring, OS_Handle file, usize offset)
+{
+	String8 data = ring_buffer_readable(ring);
+	if (!data.len)
+		return 0;
+
+	usize size = os_file_write(file, offset, offset + data.len, data.str);
+	ring_buffer_consume(ring, size);
+	return size;
+}
+
+/////////////////////////////////////////////////////////////////////////
+//                          TIMER WHEEL                                //
+/////////////////////////////////////////////////////////////////////////
+
+#define TIMER_WHEEL_BITS   6
+#define TIMER_WHEEL_FIRING U16_MAX
+
+internal void
+_timer_link_init(Timer_Link *head)
+{
+	head->next = head;
+	head->prev = head;
+}
+
+internal void
+_timer_link_remove(Timer_Link *link)
+{
+	link->prev->next = link->next;
+	link->next->prev = link->prev;
+}
+
+internal void
+_timer_link_push(Timer_Link *head, Timer_Link *link)
+{
+	link->prev       = head->prev;
+	link->next       = head;
+	head->prev->next = link;
+	head->prev       = link;
+}
+
+internal void
+timer_wheel_make(Timer_Wheel *wheel, Allocator alloc, u64 resolution_ns, OS_Time_Stamp now)
+{
+	MemZeroStruct(wheel);
+	wheel->alloc      = alloc;
+	wheel->origin     = now;
+	wheel->resolution = Max(resolution_ns, 1);
+	for (u32 level = 0; level < TIMER_WHEEL_LEVELS; ++level)
+	{
+		for (u32 slot = 0; slot < TIMER_WHEEL_SLOTS; ++slot)
+			_timer_link_init(&wheel->slots[level][slot]);
+	}
+}
+
+internal void
+timer_wheel_delete(Timer_Wheel *wheel)
+{
+	void *block = wheel->blocks;
+	while (block)
+	{
+		void *next = *cast(void **)block;
+		mem_free(wheel->alloc, block, NULL);
+		block = next;
+	}
+	MemZeroStruct(wheel);
+}
+
+internal void
+_timer_wheel_place(Timer_Wheel *wheel, Timer_Node *node)
+{
+	// ~geb: overdue timers go in the current slot
+	u64 tick  = Max(node->tick, wheel->tick);
+	u64 diff  = tick ^ wheel->tick;
+	u32 level = diff ? (63 - CountLeadingZeros64(diff)) / TIMER_WHEEL_BITS : 0;
+	if (level >= TIMER_WHEEL_LEVELS)
+	{
+		// ~geb: the top level wraps around. Within one lap the timer
+		//       goes in its own slot, further out it waits in the slot
+		//       the wheel reaches last and is placed again from there
+		level = TIMER_WHEEL_LEVELS - 1;
+		u32 shift = level * TIMER_WHEEL_BITS;
+		if ((tick >> shift) - (wheel->tick >> shift) >= TIMER_WHEEL_SLOTS)
+			tick = wheel->tick - (1ull << shift);
+	}
+
+	u32 slot = cast(u32)(tick >> (level * TIMER_WHEEL_BITS)) & (TIMER_WHEEL_SLOTS - 1);
+	node->slot = cast(u16)(level * TIMER_WHEEL_SLOTS + slot);
+	_timer_link_push(&wheel->slots[level][slot], &node->link);
+	wheel->occupied[level] |= 1ull << slot;
+}
+
+internal Timer_Handle
+timer_wheel_add(Timer_Wheel *wheel, OS_Time_Stamp deadline, Timer_Wheel_Proc *proc, void *param)
+{
+	Timer_Handle handle = {0};
+
+	if (!wheel->free_nodes)
+	{
+		usize header = AlignPow2(sizeof(void *), AlignOf(Timer_Node));
+		u8 *block = cast(u8 *)mem_alloc_aligned(wheel->alloc, header + TIMER_WHEEL_BLOCK * sizeof(Timer_Node),
+		                                         AlignOf(Timer_Node), false, NULL);
+		if (!block)
+			return handle;
+
+		*cast(void **)block = wheel->blocks;
+		wheel->blocks = block;
+
+		Timer_Node *nodes = cast(Timer_Node *)(block + header);
+		for (u32 i = 0; i < TIMER_WHEEL_BLOCK; ++i)
+		{
+			nodes[i].generation = 0;
+			nodes[i].link.next  = (i + 1 < TIMER_WHEEL_BLOCK) ? &nodes[i + 1].link : 0;
+		}
+		wheel->free_nodes = nodes;
+	}
+
+	Timer_Node *node = wheel->free_nodes;
+	wheel->free_nodes = cast(Timer_Node *)node->link.next;
+
+	// ~geb: round up, a timer never fires before its deadline
+	u64 elapsed = deadline > wheel->origin ? deadline - wheel->origin : 0;
+	node->tick  = (elapsed + wheel->resolution - 1) / wheel->resolution;
+	node->proc  = proc;
+	node->param = param;
+	node->generation += 1;
+	_timer_wheel_place(wheel, node);
+	wheel->count += 1;
+
+	handle.node       = node;
+	handle.generation = node->generation;
+	return handle;
+}
+
+internal void
+_timer_wheel_release(Timer_Wheel *wheel, Timer_Node *node)
+{
+	node->generation += 1;
+	node->link.next   = cast(Timer_Link *)wheel->free_nodes;
+	wheel->free_nodes = node;
+	wheel->count     -= 1;
+}
+
+internal bool
+timer_wheel_cancel(Timer_Wheel *wheel, Timer_Handle handle)
+{
+	Timer_Node *node = handle.node;
+	if (!node || node->generation != handle.generation)
+		return false;
+
+	_timer_link_remove(&node->link);
+	if (node->slot != TIMER_WHEEL_FIRING)
+	{
+		u32 level = node->slot / TIMER_WHEEL_SLOTS;
+		u32 slot  = node->slot % TIMER_WHEEL_SLOTS;
+		if (wheel->slots[level][slot].next == &wheel->slots[level][slot])
+			wheel->occupied[level] &= ~(1ull << slot);
+	}
+
+	_timer_wheel_release(wheel, node);
+	return true;
+}
+
+// ~geb: moves a slot's list onto head, leaving the slot empty
+internal void
+_timer_wheel_take(Timer_Wheel *wheel, u32 level, u32 slot, Timer_Link *head)
+{
+	Timer_Link *list = &wheel->slots[level][slot];
+	_timer_link_init(head);
+	if (list->next != list)
+	{
+		head->next       = list->next;
+		head->prev       = list->prev;
+		head->next->prev = head;
+		head->prev->next = head;
+		_timer_link_init(list);
+	}
+	wheel->occupied[level] &= ~(1ull << slot);
+}
+
+// ~geb: the first tick from the current one on at which an occupied
+//       slot comes due, U64_MAX when the wheel is empty
+internal u64
+_timer_wheel_next_tick(Timer_Wheel *wheel)
+{
+	u64 next = U64_MAX;
+	for (u32 level = 0; level < TIMER_WHEEL_LEVELS; ++level)
+	{
+		u32 shift = level * TIMER_WHEEL_BITS;
+		u32 digit = cast(u32)(wheel->tick >> shift) & (TIMER_WHEEL_SLOTS - 1);
+
+		// ~geb: above level 0 the current slot has been cascaded, unless
+		//       the tick sits right on its start
+		bool current = level == 0 || (wheel->tick & ((1ull << shift) - 1)) == 0;
+		u64 mask = wheel->occupied[level];
+		mask &= current ? ~0ull << digit : (digit == 63 ? 0 : ~0ull << (digit + 1));
+
+		u64 above = shift + TIMER_WHEEL_BITS;
+		u64 base  = (wheel->tick >> above) << above;
+		if (!mask && level == TIMER_WHEEL_LEVELS - 1)
+		{
+			// ~geb: the top level's slots behind the current one belong
+			//       to its next lap
+			mask  = wheel->occupied[level];
+			base += 1ull << above;
+		}
+		if (!mask)
+			continue;
+
+		u64 slot = CountTrailingZeros64(mask);
+		next = Min(next, base | (slot << shift));
+	}
+	return next;
+}
+
+internal u64
+timer_wheel_advance(Timer_Wheel *wheel, OS_Time_Stamp now)
+{
+	if (now < wheel->origin)
+		return 0;
+
+	u64 target = (now - wheel->origin) / wheel->resolution;
+	u64 fired  = 0;
+
+	while (wheel->tick <= target && wheel->count)
+	{
+		// ~geb: entering a new slot on a level sends its timers down,
+		//       highest level first
+		for (u32 level = TIMER_WHEEL_LEVELS - 1; level > 0; --level)
+		{
+			u32 shift = level * TIMER_WHEEL_BITS;
+			if (wheel->tick & ((1ull << shift) - 1))
+				continue;
+
+			u32 slot = cast(u32)(wheel->tick >> shift) & (TIMER_WHEEL_SLOTS - 1);
+			if (!(wheel->occupied[level] & (1ull << slot)))
+				continue;
+
+			Timer_Link moving;
+			_timer_wheel_take(wheel, level, slot, &moving);
+			while (moving.next != &moving)
+			{
+				Timer_Node *node = cast(Timer_Node *)moving.next;
+				_timer_link_remove(&node->link);
+				_timer_wheel_place(wheel, node);
+			}
+		}
+
+		// ~geb: detach the whole slot and move on before firing, timers
+		//       the callbacks add for now land in the next tick and
+		//       cancelling one of this batch unlinks it from here
+		u32 slot = cast(u32)wheel->tick & (TIMER_WHEEL_SLOTS - 1);
+		wheel->tick += 1;
+		if (wheel->occupied[0] & (1ull << slot))
+		{
+			Timer_Link batch;
+			_timer_wheel_take(wheel, 0, slot, &batch);
+			for (Timer_Link *link = batch.next; link != &batch; link = link->next)
+				(cast(Timer_Node *)link)->slot = TIMER_WHEEL_FIRING;
+
+			while (batch.next != &batch)
+			{
+				Timer_Node *node = cast(Timer_Node *)batch.next;
+				_timer_link_remove(&node->link);
+
+				Timer_Wheel_Proc *proc  = node->proc;
+				void             *param = node->param;
+				_timer_wheel_release(wheel, node);
+				proc(wheel, param);
+				fired += 1;
+			}
+		}
+
+		// ~geb: jump straight to the next slot that has work
+		wheel->tick = Max(wheel->tick, Min(_timer_wheel_next_tick(wheel), target + 1));
+	}
+
+	if (wheel->tick <= target)
+		wheel->tick = target + 1;
+	return fired;
+}
+
+internal OS_Time_Stamp
+timer_wheel_next_deadline(Timer_Wheel *wheel)
+{
+	if (!wheel->count)
+		return 0;
+
+	u64 tick = _timer_wheel_next_tick(wheel);
+	if (tick == U64_MAX)
+		return 0;
+	return wheel->origin + tick * wheel->resolution;
+}
+
+/////////////////////////////////////////////////////////////////////////
+//                          IPC CHANNEL                                //
+/////////////////////////////////////////////////////////////////////////
+
+#define IPC_CHANNEL_MAGIC 0x4c4e4e4148435049ull // ~geb: "IPCHANNL"
+
+internal usize
+_ipc_channel_header_size(void)
+{
+	return AlignPow2(sizeof(Ipc_Shared), os_page_size());
+}
+
+internal u64
+_ipc_record_span(u64 size)
+{
+	return AlignPow2(sizeof(Ipc_Record) + size, sizeof(Ipc_Record));
+}
+
+// ~geb: like _queue_sleep, on a futex other processes wake
+internal bool
+_ipc_channel_sleep(u32 *futex, u32 seen, OS_Time_Stamp deadline)
+{
+	u64 timeout = OS_WAIT_INFINITE;
+	if (deadline)
+	{
+		OS_Time_Stamp now = os_time_now();
+		if (now >= deadline)
+			return false;
+		timeout = deadline - now;
+	}
+	os_futex_wait_shared(futex, seen, timeout);
+	return true;
+}
+
+internal Ipc_Channel
+_ipc_channel_map(OS_Handle handle, usize ring_size)
+{
+	Ipc_Channel channel = {0};
+
+	u8 *base = cast(u8 *)os_shared_ring_map(handle, _ipc_channel_header_size(), ring_size);
+	if (!base)
+		return channel;
+
+	channel.shared = cast(Ipc_Shared *)base;
+	channel.data   = base + _ipc_channel_header_size();
+	channel.size   = ring_size;
+	channel.handle = handle;
+	return channel;
+}
+
+internal Ipc_Channel
+ipc_channel_make(usize min_size)
+{
+	Ipc_Channel channel = {0};
+
+	usize header = _ipc_channel_header_size();
+	usize size   = os_page_size();
+	while (size < min_size && size <= USIZE_MAX / 4)
+		size <<= 1;
+
+	OS_Handle handle = os_shared_memory_make(header + size);
+	if (!handle)
+		return channel;
+
+	channel = _ipc_channel_map(handle, size);
+	if (!channel.shared)
+	{
+		os_file_close(handle);
+		return channel;
+	}
+
+	// ~geb: the memory starts zeroed, a zero stamp never reads as
+	//       committed, so only the header needs filling in
+	channel.shared->size = size;
+	AtomicStoreU64(&channel.shared->magic, IPC_CHANNEL_MAGIC);
+	return channel;
+}
+
+internal Ipc_Channel
+ipc_channel_open(OS_Handle handle)
+{
+	Ipc_Channel channel = {0};
+	if (!handle)
+		return channel;
+
+	usize header = _ipc_channel_header_size();
+	usize total  = os_properties_from_file(handle).size;
+	usize size   = total > header ? total - header : 0;
+	if (size && (size & (size - 1)) == 0)
+		channel = _ipc_channel_map(handle, size);
+
+	// ~geb: the handle is ours until it is mapped, after that
+	//       ipc_channel_close owns it
+	if (!channel.shared)
+	{
+		os_file_close(handle);
+		return channel;
+	}
+	if (AtomicLoadU64(&channel.shared->magic) != IPC_CHANNEL_MAGIC || channel.shared->size != size)
+	{
+		ipc_channel_close(&channel);
+		return channel;
+	}
+
+	// ~geb: the receiver picks up wherever the ring was left
+	channel.next = AtomicLoadU64(&channel.shared->read);
+	return channel;
+}
+
+internal void
+ipc_channel_close(Ipc_Channel *channel)
+{
+	if (channel->shared)
+	{
+		os_shared_ring_unmap(channel->shared, _ipc_channel_header_size(), channel->size);
+		os_file_close(channel->handle);
+	}
+	MemZeroStruct(channel);
+}
+
+internal bool
+ipc_channel_send_handle(Ipc_Channel *channel, OS_Handle socket)
+{
+	return channel->shared && os_handle_send(socket, channel->handle);
+}
+
+internal Ipc_Channel
+ipc_channel_receive_handle(OS_Handle socket)
+{
+	return ipc_channel_open(os_handle_receive(socket));
+}
+
+internal String8
+ipc_channel_reserve(Ipc_Channel *channel, usize size, u64 timeout_ns)
+{
+	Ipc_Shared *shared = channel->shared;
+	if (!shared || size > channel->size - sizeof(Ipc_Record))
+		return (String8){0};
+
+	OS_Time_Stamp deadline = _queue_deadline(timeout_ns);
+	u64 span  = _ipc_record_span(size);
+	u32 spins = 0;
+
+	for (;;)
+	{
+		// ~geb: read first, a reserve loaded after it is never behind it
+		u64 read = AtomicLoadU64(&shared->read);
+		u64 pos  = AtomicLoadU64(&shared->reserve);
+		if (pos + span - read <= channel->size)
+		{
+			if (AtomicCompareExchangeU64(&shared->reserve, pos, pos + span) != pos)
+				continue;
+
+			// ~geb: commit finds the position again through the stamp
+			Ipc_Record *record = cast(Ipc_Record *)(channel->data + (pos & (channel->size - 1)));
+			record->size = size;
+			AtomicStoreRelaxedU64(&record->stamp, pos);
+			return (String8){ .len = size, .str = cast(u8 *)(record + 1) };
+		}
+
+		if (++spins < QUEUE_SPIN)
+		{
+			CpuPause();
+			continue;
+		}
+
+		AtomicAddU32(&shared->send_waiting, 1);
+		u32 seen = AtomicLoadU32(&shared->released);
+		read = AtomicLoadU64(&shared->read);
+		pos  = AtomicLoadU64(&shared->reserve);
+		bool alive = pos + span - read <= channel->size ||
+		             _ipc_channel_sleep(&shared->released, seen, deadline);
+		AtomicAddU32(&shared->send_waiting, -1);
+		if (!alive)
+			return (String8){0};
+	}
+}
+
+internal void
+ipc_channel_commit(Ipc_Channel *channel, String8 message)
+{
+	Ipc_Shared *shared = channel->shared;
+	Ipc_Record *record = cast(Ipc_Record *)message.str - 1;
+	AtomicStoreU64(&record->stamp, AtomicLoadRelaxedU64(&record->stamp) | IPC_RECORD_READY);
+
+	AtomicFence();
+	if (AtomicLoadU32(&shared->receive_waiting))
+	{
+		AtomicAddU32(&shared->committed, 1);
+		os_futex_wake_shared(&shared->committed, 1);
+	}
+}
+
+internal bool
+ipc_channel_send(Ipc_Channel *channel, String8 data, u64 timeout_ns)
+{
+	String8 message = ipc_channel_reserve(channel, data.len, timeout_ns);
+	if (!message.str)
+		return false;
+
+	MemCopy(message.str, data.str, data.len);
+	ipc_channel_commit(channel, message);
+	return true;
+}
+
+internal String8
+ipc_channel_receive(Ipc_Channel *channel, u64 timeout_ns)
+{
+	Ipc_Shared *shared = channel->shared;
+	if (!shared)
+		return (String8){0};
+
+	OS_Time_Stamp deadline = _queue_deadline(timeout_ns);
+	u64 pos   = channel->next;
+	u64 ready = pos | IPC_RECORD_READY;
+	u32 spins = 0;
+
+	Ipc_Record *record = cast(Ipc_Record *)(channel->data + (pos & (channel->size - 1)));
+	while (AtomicLoadU64(&record->stamp) != ready)
+	{
+		if (++spins < QUEUE_SPIN)
+		{
+			CpuPause();
+			continue;
+		}
+
+		AtomicAddU32(&shared->receive_waiting, 1);
+		u32 seen = AtomicLoadU32(&shared->committed);
+		bool alive = AtomicLoadU64(&record->stamp) == ready ||
+		             _ipc_channel_sleep(&shared->committed, seen, deadline);
+		AtomicAddU32(&shared->receive_waiting, -1);
+		if (!alive)
+			return (String8){0};
+	}
+
+	// ~geb: the size comes from another process, keep it inside the ring
+	u64 size = Min(record->size, channel->size - sizeof(Ipc_Record));
+	channel->next = pos + _ipc_record_span(size);
+	return (String8){ .len = size, .str = cast(u8 *)(record + 1) };
 }
 
+internal void
+ipc_channel_release(Ipc_Channel *channel)
+{
+	Ipc_Shared *shared = channel->shared;
+	if (!shared)
+		return;
+
+	AtomicStoreU64(&shared->read, channel->next);
+
+	AtomicFence();
+	if (AtomicLoadU32(&shared->send_waiting))
+	{
+		AtomicAddU32(&shared->released, 1);
+		os_futex_wake_shared(&shared->released, OS_FUTEX_WAKE_ALL);
+	}
+}
 
 /////////////////////////////////////////////////////////////////////////
 //                      DYNAMIC ARRAY                                  //
@@ -263,11 +263,18 @@ typedef u8 bool;
 
 #define OffsetOf(type, member) offsetof(type, member)
 #define AlignPow2(x,b)     (((x) + (b) - 1)&(~((b) - 1)))
+#define AlignDownPow2(x,b) ((x)&(~((b) - 1)))
 
 #define global        static
 #define internal      static 
 #define local_persist static 
 
+#if COMPILER_MSVC
+# define thread_static static __declspec(thread)
+#else
+# define thread_static static _Thread_local
+#endif
+
 #define Bit(x) (1u << (x))
 #define MaskCheck(flags, mask) cast(bool)(((flags) & (mask)) != 0)
 #define MaskSet(var, set, mask) do { \
@@ -280,12 +287,15 @@ typedef u8 bool;
 #define Clamp(lower, x, upper) Min(Max((x), (lower)), (upper))
 #define Is_Between(lower, x, upper) (((lower) <= (x)) && ((x) <= (upper)))
 #define Abs(x) ((x) < 0 ? -(x) : (x))
+#define ArrayCount(a) (sizeof(a) / sizeof((a)[0]))
 
 ////////////////////////////////
 // ~geb: Mem operations
 
 #include <string.h>
 #define MemMove(dst, src, size)   memmove((dst), (src), (size))
+#define MemCopy(dst, src, size)   memcpy((dst), (src), (size))
+#define MemSet(dst, byte, size)   memset((dst), (byte), (size))
 #define MemZero(dst, size)        memset((dst), 0x00, (size))
 #define MemZeroStruct(dst)        memset((dst), 0x00, (sizeof(*dst)))
 #define MemCompare(a, b, size)    memcmp((a), (b), (size))
@@ -307,6 +317,110 @@ typedef u8 bool;
 # define Assert(x) ((void)0)
 #endif
 
+////////////////////////////////
+// ~geb: Atomics
+// Sized wrappers over the compiler intrinsics. Loads acquire,
+// stores release, read-modify-writes are sequentially consistent.
+// Add/Exchange/CompareExchange/Or/And return the previous value.
+// Relaxed variants only promise the access itself is not torn.
+
+#if COMPILER_CLANG || COMPILER_GCC
+# define AtomicLoadU32(ptr)                      __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+# define AtomicStoreU32(ptr, v)                  __atomic_store_n((ptr), (u32)(v), __ATOMIC_RELEASE)
+# define AtomicAddU32(ptr, v)                    __atomic_fetch_add((ptr), (u32)(v), __ATOMIC_SEQ_CST)
+# define AtomicExchangeU32(ptr, v)               __atomic_exchange_n((ptr), (u32)(v), __ATOMIC_SEQ_CST)
+# define AtomicCompareExchangeU32(ptr, exp, des) __sync_val_compare_and_swap((ptr), (u32)(exp), (u32)(des))
+# define AtomicLoadU64(ptr)                      __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+# define AtomicStoreU64(ptr, v)                  __atomic_store_n((ptr), (u64)(v), __ATOMIC_RELEASE)
+# define AtomicAddU64(ptr, v)                    __atomic_fetch_add((ptr), (u64)(v), __ATOMIC_SEQ_CST)
+# define AtomicExchangeU64(ptr, v)               __atomic_exchange_n((ptr), (u64)(v), __ATOMIC_SEQ_CST)
+# define AtomicCompareExchangeU64(ptr, exp, des) __sync_val_compare_and_swap((ptr), (u64)(exp), (u64)(des))
+# define AtomicLoadPtr(ptr)                      __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+# define AtomicStorePtr(ptr, v)                  __atomic_store_n((ptr), (v), __ATOMIC_RELEASE)
+# define AtomicCompareExchangePtr(ptr, exp, des) __sync_val_compare_and_swap((ptr), (exp), (des))
+# define AtomicExchangePtr(ptr, v)               __atomic_exchange_n((ptr), (v), __ATOMIC_SEQ_CST)
+# define AtomicOrU32(ptr, v)                     __atomic_fetch_or((ptr), (u32)(v), __ATOMIC_SEQ_CST)
+# define AtomicAndU32(ptr, v)                    __atomic_fetch_and((ptr), (u32)(v), __ATOMIC_SEQ_CST)
+# define AtomicLoadSeqCstU32(ptr)                __atomic_load_n((ptr), __ATOMIC_SEQ_CST)
+# define AtomicLoadRelaxedU32(ptr)               __atomic_load_n((ptr), __ATOMIC_RELAXED)
+# define AtomicLoadRelaxedU64(ptr)               __atomic_load_n((ptr), __ATOMIC_RELAXED)
+# define AtomicStoreRelaxedU32(ptr, v)           __atomic_store_n((ptr), (u32)(v), __ATOMIC_RELAXED)
+# define AtomicStoreRelaxedU64(ptr, v)           __atomic_store_n((ptr), (u64)(v), __ATOMIC_RELAXED)
+# define AtomicFence()                           __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#elif COMPILER_MSVC
+# include <intrin.h>
+# define AtomicLoadU32(ptr)                      (*(volatile u32 *)(ptr))
+# define AtomicStoreU32(ptr, v)                  (*(volatile u32 *)(ptr) = (u32)(v))
+# define AtomicAddU32(ptr, v)                    (u32)_InterlockedExchangeAdd((volatile long *)(ptr), (long)(v))
+# define AtomicExchangeU32(ptr, v)               (u32)_InterlockedExchange((volatile long *)(ptr), (long)(v))
+# define AtomicCompareExchangeU32(ptr, exp, des) (u32)_InterlockedCompareExchange((volatile long *)(ptr), (long)(des), (long)(exp))
+# define AtomicLoadU64(ptr)                      (*(volatile u64 *)(ptr))
+# define AtomicStoreU64(ptr, v)                  (*(volatile u64 *)(ptr) = (u64)(v))
+# define AtomicAddU64(ptr, v)                    (u64)_InterlockedExchangeAdd64((volatile __int64 *)(ptr), (__int64)(v))
+# define AtomicExchangeU64(ptr, v)               (u64)_InterlockedExchange64((volatile __int64 *)(ptr), (__int64)(v))
+# define AtomicCompareExchangeU64(ptr, exp, des) (u64)_InterlockedCompareExchange64((volatile __int64 *)(ptr), (__int64)(des), (__int64)(exp))
+# define AtomicLoadPtr(ptr)                      (*(void *volatile *)(ptr))
+# define AtomicStorePtr(ptr, v)                  (*(void *volatile *)(ptr) = (v))
+# define AtomicCompareExchangePtr(ptr, exp, des) _InterlockedCompareExchangePointer((void *volatile *)(ptr), (des), (exp))
+# define AtomicExchangePtr(ptr, v)               _InterlockedExchangePointer((void *volatile *)(ptr), (v))
+# define AtomicOrU32(ptr, v)                     (u32)_InterlockedOr((volatile long *)(ptr), (long)(v))
+# define AtomicAndU32(ptr, v)                    (u32)_InterlockedAnd((volatile long *)(ptr), (long)(v))
+# define AtomicLoadSeqCstU32(ptr)                (*(volatile u32 *)(ptr))
+# define AtomicLoadRelaxedU32(ptr)               (*(volatile u32 *)(ptr))
+# define AtomicLoadRelaxedU64(ptr)               (*(volatile u64 *)(ptr))
+# define AtomicStoreRelaxedU32(ptr, v)           (*(volatile u32 *)(ptr) = (u32)(v))
+# define AtomicStoreRelaxedU64(ptr, v)           (*(volatile u64 *)(ptr) = (u64)(v))
+# define AtomicFence()                           MemoryBarrier()
+#else
+# error Atomics not defined for this compiler.
+#endif
+
+#define CACHE_LINE_SIZE 64
+
+#if ARCH_X64 || ARCH_X86
+# if COMPILER_MSVC
+#  define CpuPause() _mm_pause()
+# else
+#  define CpuPause() __builtin_ia32_pause()
+# endif
+#elif ARCH_ARM64 || ARCH_ARM32
+# if COMPILER_MSVC
+#  define CpuPause() __yield()
+# else
+#  define CpuPause() __asm__ __volatile__("yield")
+# endif
+#endif
+
+////////////////////////////////
+// ~geb: SIMD, the baseline of each 64-bit target
+
+#if ARCH_X64
+# include <emmintrin.h>
+# if COMPILER_MSVC
+#  include <intrin.h>
+# else
+#  include <x86intrin.h>
+#  include <cpuid.h>
+# endif
+#elif ARCH_ARM64
+# include <arm_neon.h>
+#endif
+
+////////////////////////////////
+// ~geb: Bit scanning, x must be non-zero
+
+#if COMPILER_CLANG || COMPILER_GCC
+# define CountLeadingZeros64(x)  cast(u32) __builtin_clzll(x)
+# define CountTrailingZeros64(x) cast(u32) __builtin_ctzll(x)
+# define CountTrailingZeros32(x) cast(u32) __builtin_ctz(x)
+# define PopCount64(x)           cast(u32) __builtin_popcountll(x)
+#elif COMPILER_MSVC
+# define CountLeadingZeros64(x)  cast(u32) __lzcnt64(x)
+# define CountTrailingZeros64(x) cast(u32) _tzcnt_u64(x)
+# define CountTrailingZeros32(x) cast(u32) _tzcnt_u32(x)
+# define PopCount64(x)           cast(u32) __popcnt64(x)
+#endif
+
 ///////////////////////////////////
 // ~geb: Allocator
 
@@ -540,6 +654,16 @@ internal isize find_right(String8 str, rune c);
 internal String8_List str8_make_list(const char **cstrings, usize count, Allocator allocator);
 internal Alloc_Error  str8_delete_list(String8_List *list);
 internal String8      str8_list_index(String8_List *list, usize i);
+internal String8      str8_list_join(String8_List *list, String8 separator, Allocator alloc);
+
+// ~geb: split returns slices into string, free the result
+//       with dynamic_array_delete not str8_delete_list.
+typedef u32 Str8_SplitFlags;
+enum {
+	Str8_SplitFlag_KeepEmpty = Bit(0),
+};
+
+internal String8_List str8_split(String8 string, String8 separators, Str8_SplitFlags flags, Allocator alloc);
 
 internal String8 str8_slice(String8 string, usize begin, usize end_exclusive);
 internal bool    str8_equal(String8 first, String8 second);
@@ -549,6 +673,20 @@ internal String8 str8_copy_cstring(String8 string, Allocator alloc);
 internal String8 str8_file_extension(String8 path);
 internal String8 str8_file_name(String8 path);
 
+internal u64     str8_hash(String8 string);
+
+// ~geb: case. The ascii transforms leave every other byte alone.
+//       Folding is Unicode simple case folding, one rune to one
+//       rune, so folded text can change byte length (K -> k).
+internal void    str8_lower_ascii_inplace(String8 string);
+internal void    str8_upper_ascii_inplace(String8 string);
+internal String8 str8_lower_ascii(String8 string, Allocator alloc);
+internal String8 str8_upper_ascii(String8 string, Allocator alloc);
+internal rune    rune_fold(rune r);
+internal String8 str8_fold(String8 string, Allocator alloc);
+internal bool    str8_equal_nocase(String8 first, String8 second);
+internal u64     str8_hash_nocase(String8 string); // == str8_hash(str8_fold(string))
+
 typedef struct {
 	u8 *ptr;
 	u32  width;
@@ -567,10 +705,277 @@ enum {
 
 internal bool str8_iter(String8 string, Str_Iterator *it);
 internal rune utf8_decode(u8 *ptr, UTF8_Error *err);
+internal u32  utf8_encode(rune r, u8 *out); // out needs 4 bytes, returns the width
+
+// ~geb: Unicode properties come from generated two stage tables
+//       (src/base_unicode_tables.c), ascii takes a single branch.
+
+typedef u8 Unicode_Category;
+enum {
+	Unicode_Category_Cn, // unassigned
+	Unicode_Category_Lu,
+	Unicode_Category_Ll,
+	Unicode_Category_Lt,
+	Unicode_Category_Lm,
+	Unicode_Category_Lo,
+	Unicode_Category_Mn,
+	Unicode_Category_Mc,
+	Unicode_Category_Me,
+	Unicode_Category_Nd,
+	Unicode_Category_Nl,
+	Unicode_Category_No,
+	Unicode_Category_Pc,
+	Unicode_Category_Pd,
+	Unicode_Category_Ps,
+	Unicode_Category_Pe,
+	Unicode_Category_Pi,
+	Unicode_Category_Pf,
+	Unicode_Category_Po,
+	Unicode_Category_Sm,
+	Unicode_Category_Sc,
+	Unicode_Category_Sk,
+	Unicode_Category_So,
+	Unicode_Category_Zs,
+	Unicode_Category_Zl,
+	Unicode_Category_Zp,
+	Unicode_Category_Cc,
+	Unicode_Category_Cf,
+	Unicode_Category_Cs,
+	Unicode_Category_Co,
+};
 
-internal bool is_letter(rune r);
+typedef u8 Rune_Class;
+enum {
+	Rune_Class_Letter       = Bit(0), // L*
+	Rune_Class_Digit        = Bit(1), // Nd
+	Rune_Class_Upper        = Bit(2), // Lu
+	Rune_Class_Lower        = Bit(3), // Ll
+	Rune_Class_Punct        = Bit(4), // P*
+	Rune_Class_Space        = Bit(5), // White_Space
+	Rune_Class_XID_Start    = Bit(6),
+	Rune_Class_XID_Continue = Bit(7),
+};
+
+internal Unicode_Category rune_category(rune r);
+internal Rune_Class       rune_class(rune r);
+// ~geb: writes the class of every rune, returns the classes they all share
+internal Rune_Class       rune_classify_batch(rune *runes, usize count, Rune_Class *out_classes);
+
+internal bool is_letter(rune r); // also '_'
 internal bool is_digit(rune r);
 internal bool is_space(rune r);
+internal bool is_xid_start(rune r);
+internal bool is_xid_continue(rune r);
+
+///////////////////////////////////
+// ~geb: String formatting
+// printf compatible formatting that never touches libc or the
+// locale. Supports flags "-+ #0", width and precision (also '*'),
+// length modifiers hh h l ll z j t and conversions
+// d i u o x X c s p f F e E g G %. %S takes a String8 by value.
+// Floats start from their shortest round trip digits and switch to
+// the exact decimal value of the double (a bignum expansion) when
+// the precision asks for more digits than those, then round half
+// to even on the exact value.
+
+#include <stdarg.h>
+
+#define U64_CHARS_MAX 20
+#define F64_CHARS_MAX 32
+
+internal usize   u64_to_chars(u8 *dst, u64 value);
+internal usize   i64_to_chars(u8 *dst, i64 value);
+internal usize   f64_to_chars(u8 *dst, f64 value);
+
+internal usize   str8_fmtv(u8 *buffer, usize capacity, const char *fmt, va_list args);
+internal usize   str8_fmt(u8 *buffer, usize capacity, const char *fmt, ...);
+internal String8 str8_pushfv(Allocator alloc, const char *fmt, va_list args);
+internal String8 str8_pushf(Allocator alloc, const char *fmt, ...);
+
+///////////////////////////////////
+// ~geb: Number parsing
+// Parses straight out of a String8 without a terminator or locale.
+// Returns the number of bytes consumed, 0 when the string does not
+// start with a number. Integers are decimal with an optional sign,
+// floats also take a fraction, an exponent, inf and nan.
+// On overflow the whole number is consumed and the result saturates
+// (floats become +-inf).
+
+typedef u32 Parse_Error;
+enum {
+	Parse_Err_None,
+	Parse_Err_Invalid,
+	Parse_Err_Overflow,
+};
+
+internal usize str8_parse_u64(String8 string, u64 *out, Parse_Error *err);
+internal usize str8_parse_i64(String8 string, i64 *out, Parse_Error *err);
+internal usize str8_parse_f64(String8 string, f64 *out, Parse_Error *err);
+
+///////////////////////////////////
+// ~geb: Tokenizer
+// Zero copy line and field iteration over a String8. Newlines,
+// delimiters and quotes are found 64 bytes at a time as bitmasks,
+// so the byte loop only runs at the tail of the input.
+// Fields handle CRLF and quoting: a quoted field is returned
+// without its outer quotes, doubled quotes inside it are left as
+// is and flagged through last_field_escaped.
+
+#define STR8_TOKENIZER_MAX_DELIMS 8
+
+typedef struct Str8_Tokenizer {
+	String8 src;
+	usize   pos;
+	bool    field_pending;      // a delimiter ended the last field
+	bool    last_field_escaped; // last field had "" inside quotes
+
+	u8      delims[STR8_TOKENIZER_MAX_DELIMS];
+	u32     delim_count;
+	u8      quote;              // 0 disables quoting
+
+	// ~geb: cached masks of the block at block_base
+	usize   block_base;
+	u64     newline_mask;
+	u64     separator_mask;     // delimiters and newlines
+	u64     quote_mask;
+
+	// ~geb: batch mode cursor
+	usize   batch_pos;
+	u64     batch_in_quote;
+} Str8_Tokenizer;
+
+internal Str8_Tokenizer str8_tokenizer_make(String8 src, String8 delimiters, u8 quote);
+internal bool           str8_next_line(Str8_Tokenizer *tok, String8 *line);
+internal bool           str8_next_field(Str8_Tokenizer *tok, String8 *field, bool *end_of_line);
+
+// ~geb: batch mode, walks the input in 64-byte blocks from the
+//       start and writes the offset of every delimiter and newline
+//       outside of quotes. out_offsets must hold 64 entries.
+//       Returns false once the input is exhausted.
+internal bool           str8_tokenizer_next_block(Str8_Tokenizer *tok, usize *out_offsets, usize *out_count);
+
+///////////////////////////////////
+// ~geb: UTF-16 and UTF-32
+// Native endian code unit strings, no BOM handling. Every
+// conversion validates its input while measuring the exact output
+// size, allocates once, then converts without further checks.
+// Invalid input (bad UTF-8, unpaired surrogates, runes past
+// Rune_Max) gives an empty result and sets err.
+
+typedef struct {
+	usize len;
+	u16 *str;
+} String16;
+
+typedef struct {
+	usize len;
+	u32 *str;
+} String32;
+
+typedef u32 Transcode_Error;
+enum {
+	Transcode_Err_None,
+	Transcode_Err_InvalidUTF8,
+	Transcode_Err_UnpairedSurrogate,
+	Transcode_Err_OutOfRange,
+};
+
+// ~geb: output length in code units of the target encoding
+internal usize str16_size_from_str8(String8 string, Transcode_Error *err);
+internal usize str32_size_from_str8(String8 string, Transcode_Error *err);
+internal usize str8_size_from_str16(String16 string, Transcode_Error *err);
+internal usize str32_size_from_str16(String16 string, Transcode_Error *err);
+internal usize str8_size_from_str32(String32 string, Transcode_Error *err);
+internal usize str16_size_from_str32(String32 string, Transcode_Error *err);
+
+internal String16 str16_from_str8(String8 string, Allocator alloc, Transcode_Error *err);
+internal String32 str32_from_str8(String8 string, Allocator alloc, Transcode_Error *err);
+internal String8  str8_from_str16(String16 string, Allocator alloc, Transcode_Error *err);
+internal String32 str32_from_str16(String16 string, Allocator alloc, Transcode_Error *err);
+internal String8  str8_from_str32(String32 string, Allocator alloc, Transcode_Error *err);
+internal String16 str16_from_str32(String32 string, Allocator alloc, Transcode_Error *err);
+
+///////////////////////////////////
+// ~geb: Rune index
+// Optional side index over a String8 for random access by rune and
+// by line. Built lazily on the first lookup in one SIMD pass that
+// records the byte offset of every stride-th rune and of every
+// line start. A rune starts at each byte that is not a UTF-8
+// continuation byte, lines start after each '\n'.
+// The index borrows the string, rebuild it after the string changes.
+
+#define STR8_INDEX_DEFAULT_STRIDE 256
+
+typedef struct {
+	String8       string;
+	u32           stride;
+	bool          built;
+	usize         rune_count;
+	usize         line_count;
+	Dynamic_Array rune_checkpoints; // usize, byte offset of rune i * stride
+	Dynamic_Array line_starts;      // usize, byte offset of line i
+} Str8_Index;
+
+// ~geb: stride 0 picks the default. make fails when the index arrays
+//       can't be allocated, build when they can't grow, lookups
+//       then scan the string instead
+internal bool       str8_index_make(Str8_Index *index, String8 string, u32 stride, Allocator alloc);
+internal void       str8_index_delete(Str8_Index *index);
+internal bool       str8_index_build(Str8_Index *index);
+
+internal usize      str8_index_rune_count(Str8_Index *index);
+internal usize      str8_index_line_count(Str8_Index *index);
+// ~geb: lookups past the end return string.len, rune_count or the last line
+internal usize      str8_index_byte_from_rune(Str8_Index *index, usize rune_index);
+internal usize      str8_index_rune_from_byte(Str8_Index *index, usize byte_offset);
+internal usize      str8_index_byte_from_line(Str8_Index *index, usize line);
+internal usize      str8_index_line_from_byte(Str8_Index *index, usize byte_offset);
+
+///////////////////////////////////
+// ~geb: String interning
+// Deduplicates strings into the interner's allocator and hands
+// out dense u32 ids. Ids start at 0 (always the empty string)
+// and never move, so id -> String8 is a two level array index.
+// With Str8_InternFlag_ThreadSafe the hash table is split into
+// shards with their own spin locks, lookups by id take no lock.
+
+#define STR8_INTERN_SHARD_COUNT 16
+#define STR8_INTERN_PAGE_SHIFT  12
+#define STR8_INTERN_PAGE_SIZE   (1u << STR8_INTERN_PAGE_SHIFT)
+#define STR8_INTERN_MAX_PAGES   16384
+#define STR8_INTERN_NONE        U32_MAX // ~geb: str8_intern failed
+
+typedef u32 Str8_Intern_Flags;
+enum {
+	Str8_InternFlag_ThreadSafe = Bit(0),
+};
+
+typedef struct Str8_Intern_Shard {
+	u64 *slots;    // (hash tag << 32) | (id + 1), 0 is empty
+	u32  lock;
+	u32  count;
+	u32  capacity; // power of two
+	u8   pad[CACHE_LINE_SIZE - sizeof(u64 *) - 3 * sizeof(u32)];
+} Str8_Intern_Shard;
+
+typedef struct Str8_Interner {
+	Allocator         alloc;
+	Str8_Intern_Flags flags;
+	u32               shard_mask;
+	u32               alloc_lock;
+	u32               count;
+	String8         **pages;
+	Str8_Intern_Shard shards[STR8_INTERN_SHARD_COUNT];
+} Str8_Interner;
+
+internal Str8_Interner *str8_interner_make(Allocator alloc, u32 capacity_hint, Str8_Intern_Flags flags);
+internal void           str8_interner_delete(Str8_Interner *interner);
+// ~geb: STR8_INTERN_NONE when the table, a page or the copy can't
+//       be allocated, or every id is taken
+internal u32            str8_intern(Str8_Interner *interner, String8 string);
+internal bool           str8_intern_find(Str8_Interner *interner, String8 string, u32 *out_id);
+internal String8        str8_from_intern(Str8_Interner *interner, u32 id);
+internal u32            str8_interner_count(Str8_Interner *interner);
 
 ///////////////////////////////////
 // ~geb: OS layer
@@ -580,6 +985,13 @@ internal void *os_reserve(usize size);
 internal int   os_commit(void *ptr, usize size);
 internal void  os_decommit(void *ptr, usize size);
 internal void  os_release(void *ptr, usize size);
+internal usize os_page_size(void);
+
+// ~geb: size bytes of memory mapped twice back to back, a write at
+//       base[i] shows up at base[i + size]. size must be a multiple
+//       of os_page_size
+internal void *os_ring_map(usize size);
+internal void  os_ring_unmap(void *base, usize size);
 
 // ~geb: file handling
 typedef i32 OS_Handle;
@@ -592,6 +1004,7 @@ enum {
   OS_AccessFlag_Execute    = Bit(3),
   OS_AccessFlag_ShareRead  = Bit(4),
   OS_AccessFlag_ShareWrite = Bit(5),
+  OS_AccessFlag_Truncate   = Bit(6),
 };
 
 typedef u32 OS_FileFlags;
@@ -622,9 +1035,124 @@ internal void         os_file_close(OS_Handle file);
 internal usize        os_file_read(OS_Handle file, usize begin, usize end, void *out_data);
 internal usize        os_file_write(OS_Handle file, usize begin, usize end, void *data);
 internal OS_FileProps os_properties_from_file(OS_Handle file);
+internal bool         os_file_set_size(OS_Handle file, usize size);
+internal bool         os_file_same(OS_Handle a, OS_Handle b); // ~geb: both open the same file
+// ~geb: copies size bytes from src at src_offset to dst at dst_offset
+//       without passing them through this process, returns how many
+//       were copied, short only at the end of src or on an error.
+//       Offsets are ignored on handles that have none, like pipes
+internal usize        os_copy_range(OS_Handle dst, usize dst_offset, OS_Handle src, usize src_offset, usize size);
+
+// ~geb: shared memory, a handle other processes can map. It is
+//       sealed at size bytes so nobody can shrink it under a peer
+//       and fault its accesses. os_shared_ring_map maps header_size
+//       bytes of it followed by the next ring_size bytes twice like
+//       os_ring_map, both multiples of os_page_size, and refuses
+//       memory that is unsealed or too small
+internal OS_Handle os_shared_memory_make(usize size);
+internal void     *os_shared_ring_map(OS_Handle handle, usize header_size, usize ring_size);
+internal void      os_shared_ring_unmap(void *base, usize header_size, usize ring_size);
 
 internal String8      os_data_from_path(String8 path, Allocator alloc, Allocator scratch);
 internal bool         os_write_to_path(String8 path, String8 data, Allocator scratch);
+internal bool         os_file_copy(String8 dst_path, String8 src_path, Allocator scratch);
+
+// ~geb: readiness polling
+
+typedef u32 OS_IoFlags;
+enum {
+	OS_IoFlag_Read   = Bit(0),
+	OS_IoFlag_Write  = Bit(1),
+	OS_IoFlag_Error  = Bit(2), // ~geb: only ever reported
+	OS_IoFlag_HangUp = Bit(3), // ~geb: only ever reported
+	OS_IoFlag_Edge   = Bit(4), // ~geb: event loop, report changes only
+};
+
+typedef struct {
+	OS_Handle  handle;
+	OS_IoFlags events;
+	OS_IoFlags ready;
+} OS_Poll_Entry;
+
+// ~geb: fills in ready, returns how many entries have any
+internal u32 os_poll(OS_Poll_Entry *entries, u32 count, u64 timeout_ns);
+internal bool os_handle_set_nonblocking(OS_Handle handle, bool nonblocking);
+
+// ~geb: connected pair of local stream sockets, and passing handles
+//       over one to another process. The receiver gets its own
+//       handle to the same object, the sender may close its copy
+internal bool      os_socket_pair(OS_Handle out[2]);
+internal bool      os_handle_send(OS_Handle socket, OS_Handle handle);
+internal OS_Handle os_handle_receive(OS_Handle socket);
+
+// ~geb: event loop
+// One thread serving many handles. Watches call back when their
+// handle turns ready, level triggered unless OS_IoFlag_Edge is set,
+// in which case read or write until it would block. Timers fire
+// once after delay_ns, or every period_ns when that is not 0.
+// Callbacks run in batches of up to OS_EVENT_LOOP_BATCH ready
+// handles followed by every due timer. os_event_loop_wake and
+// os_event_loop_stop are the only calls safe from other threads.
+// Timer ids carry a slot and a generation, the slot records where
+// the timer sits in the heap so cancel does not search for it.
+
+#define OS_EVENT_LOOP_BATCH  64
+#define OS_EVENT_LOOP_TIMERS 32 // ~geb: initial timer capacity
+
+struct OS_Event_Loop;
+#define OS_Watch_Proc(name) void name(struct OS_Event_Loop *loop, OS_Handle handle, OS_IoFlags ready, void *param)
+#define OS_Timer_Proc(name) void name(struct OS_Event_Loop *loop, u64 timer, void *param)
+typedef OS_Watch_Proc(OS_Watch_Proc);
+typedef OS_Timer_Proc(OS_Timer_Proc);
+
+typedef struct OS_Watch {
+	struct OS_Watch *next;  // ~geb: free list
+	OS_Handle        handle;
+	OS_Watch_Proc   *proc;
+	void            *param;
+	bool             dead;
+} OS_Watch;
+
+typedef struct {
+	OS_Time_Stamp  deadline;
+	u64            period;
+	u64            id;        // ~geb: generation << 32 | slot
+	u64            sequence;  // ~geb: add order
+	OS_Timer_Proc *proc;
+	void          *param;
+} OS_Timer;
+
+typedef struct {
+	u32 index;       // ~geb: heap index, next free slot once released
+	u32 generation;
+} OS_Timer_Slot;
+
+typedef struct OS_Event_Loop {
+	OS_Handle      poller;
+	OS_Handle      timer_handle;
+	OS_Handle      wake_handle;
+	Allocator      alloc;
+	OS_Watch      *free_watches;
+	OS_Watch      *dead_watches;
+	Dynamic_Array  timers;       // ~geb: OS_Timer, min heap on deadline
+	Dynamic_Array  timer_slots;  // ~geb: OS_Timer_Slot, by id
+	u32            free_timer_slot;
+	OS_Time_Stamp  armed;
+	u64            next_timer;
+	u32            running;
+} OS_Event_Loop;
+
+internal bool      os_event_loop_make(OS_Event_Loop *loop, Allocator alloc);
+internal void      os_event_loop_delete(OS_Event_Loop *loop);
+internal OS_Watch *os_event_loop_watch(OS_Event_Loop *loop, OS_Handle handle, OS_IoFlags events, OS_Watch_Proc *proc, void *param);
+internal bool      os_event_loop_modify(OS_Event_Loop *loop, OS_Watch *watch, OS_IoFlags events);
+internal void      os_event_loop_unwatch(OS_Event_Loop *loop, OS_Watch *watch);
+internal u64       os_event_loop_timer(OS_Event_Loop *loop, u64 delay_ns, u64 period_ns, OS_Timer_Proc *proc, void *param);
+internal bool      os_event_loop_cancel(OS_Event_Loop *loop, u64 timer);
+internal u32       os_event_loop_run_once(OS_Event_Loop *loop, u64 timeout_ns);
+internal void      os_event_loop_run(OS_Event_Loop *loop);
+internal void      os_event_loop_stop(OS_Event_Loop *loop);
+internal void      os_event_loop_wake(OS_Event_Loop *loop);
 
 // ~geb: time interface
 
@@ -639,13 +1167,818 @@ internal OS_Time_Stamp    os_time_now();
 internal OS_Time_Stamp    os_time_frequency();
 internal void             os_sleep_ns(u64 ns);
 internal OS_Time_Duration os_time_diff(OS_Time_Stamp start, OS_Time_Stamp end);
+internal OS_Time_Duration os_time_duration(u64 ticks, u64 frequency);
+
+// ~geb: precise waiting
+// os_sleep_until_ns sleeps to an absolute os_time_now deadline, so
+// wakeups and signals never stretch a periodic loop. The kernel still
+// wakes it late by up to the timer slack (50us by default for normal
+// threads), which os_set_timer_slack_ns can shrink to 1ns.
+// os_wait_until_ns sleeps until spin_ns before the deadline and spins
+// out the rest, pick spin_ns from sleep_late_max_ns in the stats.
+
+typedef struct {
+	u64 waits;
+	u64 late_total_ns;      // ~geb: how far past the deadline we returned
+	u64 late_max_ns;
+	u64 sleep_late_max_ns;  // ~geb: how far past its target the sleep woke
+	u64 spin_total_ns;
+} OS_Wait_Stats;
+
+internal void             os_sleep_until_ns(OS_Time_Stamp deadline);
+internal bool             os_set_timer_slack_ns(u64 ns); // ~geb: 0 restores the default
+internal u64              os_timer_slack_ns(void);
+internal u64              os_wait_until_ns(OS_Time_Stamp deadline, u64 spin_ns, OS_Wait_Stats *stats);
+
+// ~geb: cycle counter, rdtsc on x64 and cntvct_el0 on arm64, or
+//       os_time_now where neither exists. The x64 frequency is
+//       calibrated against os_time_now on first use (a few ms) and
+//       only holds across cores and sleep states when the counter
+//       is invariant. _serialized waits for earlier instructions.
+internal u64              os_cycles_now(void);
+internal u64              os_cycles_now_serialized(void);
+internal u64              os_cycles_frequency(void);
+internal bool             os_cycles_invariant(void);
+internal f64              os_cycles_to_ns(u64 cycles);
+internal OS_Time_Duration os_cycles_diff(u64 start, u64 end);
+
+// ~geb: threads
+
+typedef u64 OS_Thread; // ~geb: 0 is invalid
+
+#define OS_Thread_Proc(name) void name(void *param)
+typedef OS_Thread_Proc(OS_Thread_Proc);
+
+internal OS_Thread os_thread_create(OS_Thread_Proc *proc, void *param);
+internal void      os_thread_join(OS_Thread thread);
+internal u32       os_thread_id(void);
+internal OS_Thread os_thread_self(void);
+internal void      os_thread_yield(void);
+internal bool      os_thread_set_affinity(OS_Thread thread, u32 core);
+internal u32       os_core_count(void); // ~geb: cores this process may run on
+
+// ~geb: synchronization
+// All of these are a single u32 (or two) that waits in the kernel
+// through a futex only when contended, so zero-initialized values
+// are ready to use and they cost nothing while unused. Uncontended
+// lock and unlock are one atomic op each. Waits take an
+// os_time_now relative timeout, OS_WAIT_INFINITE blocks forever,
+// and return false when it expired. Waits may wake spuriously,
+// re-check the condition.
+
+#define OS_WAIT_INFINITE  U64_MAX
+#define OS_FUTEX_WAKE_ALL U32_MAX
+
+typedef struct { u32 state; } OS_Mutex;     // ~geb: 0 free, 1 locked, 2 locked with waiters
+typedef struct { u32 seq; } OS_Cond;
+typedef struct { u32 count; u32 waiters; } OS_Semaphore;
+typedef struct { u32 signaled; } OS_Event;
+
+// ~geb: blocks while *addr == expected
+internal bool os_futex_wait(u32 *addr, u32 expected, u64 timeout_ns);
+internal void os_futex_wake(u32 *addr, u32 count);
+// ~geb: same on memory shared with other processes
+internal bool os_futex_wait_shared(u32 *addr, u32 expected, u64 timeout_ns);
+internal void os_futex_wake_shared(u32 *addr, u32 count);
+
+internal void os_mutex_lock(OS_Mutex *mutex);
+internal bool os_mutex_try_lock(OS_Mutex *mutex);
+internal void os_mutex_unlock(OS_Mutex *mutex);
+
+internal bool os_cond_wait(OS_Cond *cond, OS_Mutex *mutex, u64 timeout_ns);
+internal void os_cond_signal(OS_Cond *cond);
+internal void os_cond_broadcast(OS_Cond *cond);
+
+internal bool os_semaphore_wait(OS_Semaphore *sem, u64 timeout_ns);
+internal bool os_semaphore_try_wait(OS_Semaphore *sem);
+internal void os_semaphore_post(OS_Semaphore *sem, u32 count);
+
+internal bool os_event_wait(OS_Event *event, u64 timeout_ns);
+internal bool os_event_is_set(OS_Event *event);
+internal void os_event_set(OS_Event *event);
+internal void os_event_reset(OS_Event *event);
+
+// ~geb: hardware counters
+// Counts events for the calling thread in user space, opened as one
+// group so every counter covers the same instructions. Counters the
+// kernel refuses (perf_event_paranoid, containers, no PMU) are left
+// out of the mask instead of failing, so check mask before trusting
+// a value. When the kernel multiplexes the group the values are
+// scaled by time_enabled / time_running.
+
+typedef enum {
+	OS_Perf_Cycles,
+	OS_Perf_Instructions,
+	OS_Perf_CacheReferences,
+	OS_Perf_CacheMisses,
+	OS_Perf_BranchMisses,
+	OS_Perf_PageFaults,
+	OS_Perf_Count,
+} OS_Perf_Counter;
+
+#define OS_PERF_ALL ((1u << OS_Perf_Count) - 1)
+
+typedef struct {
+	u32 mask;                  // ~geb: counters that opened
+	i32 leader;                // ~geb: -1 when nothing opened
+	i32 fds[OS_Perf_Count];
+	u8  order[OS_Perf_Count];  // ~geb: counter per group slot
+	u32 count;
+} OS_Perf_Group;
+
+typedef struct {
+	u32 mask;
+	u64 values[OS_Perf_Count];
+	u64 time_enabled;
+	u64 time_running;
+} OS_Perf_Sample;
+
+internal OS_Perf_Group  os_perf_open(u32 counter_mask);
+internal void           os_perf_close(OS_Perf_Group *group);
+internal void           os_perf_start(OS_Perf_Group *group);
+internal void           os_perf_stop(OS_Perf_Group *group);
+internal OS_Perf_Sample os_perf_read(OS_Perf_Group *group);
+internal String8        os_perf_counter_name(OS_Perf_Counter counter);
+
+///////////////////////////////////
+// ~geb: String builder
+// Appends into a linked list of chunks taken from the allocator.
+// Chunks never move, so pushing never copies what is already
+// there. Flatten once at the end or write the chunks straight
+// to a file.
+
+#define STR8_BUILDER_DEFAULT_CHUNK Kb(16)
+
+typedef struct Str8_Chunk {
+	struct Str8_Chunk *next;
+	usize len;
+	usize capacity;
+	u8   *data;
+} Str8_Chunk;
+
+typedef struct Str8_Builder {
+	Allocator   alloc;
+	Str8_Chunk *first;
+	Str8_Chunk *last;
+	usize       chunk_size;
+	usize       len;
+} Str8_Builder;
+
+internal Str8_Builder str8_builder_make(Allocator alloc, usize chunk_size);
+internal void         str8_builder_delete(Str8_Builder *builder);
+internal u8          *str8_builder_reserve(Str8_Builder *builder, usize size);
+internal void         str8_builder_commit(Str8_Builder *builder, usize size);
+internal void         str8_builder_push(Str8_Builder *builder, String8 string);
+internal void         str8_builder_push_byte(Str8_Builder *builder, u8 byte);
+internal String8      str8_builder_flatten(Str8_Builder *builder, Allocator alloc);
+internal usize        str8_builder_write(Str8_Builder *builder, OS_Handle file, usize offset);
 
 ///////////////////////////////////
 // ~geb: Logging
+// Messages are formatted on the calling thread into a thread local
+// buffer and pushed on a lock-free ring. After log_init a flush
+// thread drains the ring in large os_file_writes, before it (or
+// after log_shutdown) every message is one synchronous write to
+// stdout. Messages longer than LOG_MESSAGE_MAX are truncated.
+
+#define LOG_MESSAGE_MAX        Kb(4)
+#define LOG_DEFAULT_RING_SIZE  Mb(1)
+#define LOG_DEFAULT_BATCH_SIZE Kb(64)
+#define LOG_DEFAULT_INTERVAL   1000000ull // ~geb: ns between idle polls
+
+typedef u32 Log_Overflow;
+enum {
+	Log_Overflow_Block, // wait for the flush thread to make room
+	Log_Overflow_Drop,  // drop the message
+	Log_Overflow_Count, // drop it and report how many were dropped
+};
+
+typedef struct {
+	OS_Handle    output;           // 0 picks stdout
+	usize        ring_size;        // bytes, rounded up to a power of two
+	usize        batch_size;       // bytes per write
+	u64          flush_interval_ns;
+	Log_Overflow overflow;
+} Log_Config;
+
+// ~geb: the defines are for LOG_COMPILE_LEVEL in the preprocessor
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_ERROR 3
+
+typedef u32 Log_Level;
+enum {
+	Log_Level_Debug = LOG_LEVEL_DEBUG,
+	Log_Level_Info  = LOG_LEVEL_INFO,
+	Log_Level_Warn  = LOG_LEVEL_WARN,
+	Log_Level_Error = LOG_LEVEL_ERROR,
+	Log_Level_Count,
+};
+
+internal bool log_init(Log_Config config);
+internal void log_shutdown(void);
+internal void log_flush(void);    // returns once everything logged so far is written
+internal u64  log_dropped_count(void);
+// ~geb: messages below the level are skipped, text and deferred
+internal void log_set_level(Log_Level level);
 
 internal void log_debug(const char* fmt, ...);
 internal void log_info (const char* fmt, ...);
 internal void log_warn (const char* fmt, ...);
 internal void log_error(const char* fmt, ...);
 
+///////////////////////////////////
+// ~geb: Deferred logging
+// log_deferred_* capture a static descriptor per call site (format,
+// level, file, line and the argument types) and only copy the raw
+// arguments into a binary stream, the same ring and flush thread as
+// the text logger but with its own output. Formatting happens later
+// in log_deferred_decode.
+// Arguments are integers, floats, pointers, C strings and String8,
+// at most LOG_DEFERRED_MAX_ARGS of them, '*' width and precision are
+// not supported. Sites below LOG_COMPILE_LEVEL expand to nothing,
+// the rest cost two loads when filtered at runtime.
+
+#ifndef LOG_COMPILE_LEVEL
+# define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+#define LOG_DEFERRED_MAX_ARGS     8
+#define LOG_DEFERRED_DECODE_SITES 64 // ~geb: initial site table capacity
+
+typedef u8 Log_Arg_Type;
+enum {
+	Log_Arg_None,
+	Log_Arg_I64,
+	Log_Arg_U64,
+	Log_Arg_F64,
+	Log_Arg_Ptr,
+	Log_Arg_CString,
+	Log_Arg_String8,
+};
+
+typedef struct {
+	u64   value; // ~geb: bits of the number, or the string pointer
+	usize len;
+} Log_Arg;
+
+typedef struct Log_Site {
+	const char      *fmt;
+	const char      *file;
+	u32              line;
+	Log_Level        level;
+	u32              enabled; // ~geb: runtime switch for this site
+	u32              arg_count;
+	Log_Arg_Type     arg_types[LOG_DEFERRED_MAX_ARGS + 1];
+	u32              id;      // ~geb: assigned on first use per stream
+	u32              listed;
+	struct Log_Site *next;
+} Log_Site;
+
+internal bool      log_deferred_init(Log_Config config); // output is required
+internal void      log_deferred_shutdown(void);
+internal void      log_deferred_flush(void);
+internal u64       log_deferred_dropped_count(void);
+// ~geb: every site that logged at least once, linked through next
+internal Log_Site *log_deferred_sites(void);
+// ~geb: turns a stream written by the deferred logger into text,
+//       empty when the site table cannot be allocated
+internal String8   log_deferred_decode(String8 stream, Allocator alloc);
+
+internal void      _log_deferred_write(Log_Site *site, Log_Arg *args);
+
+#define LOG__CAT_(a, b) a##b
+#define LOG__CAT(a, b)  LOG__CAT_(a, b)
+#define LOG__FIRST_(first, ...) first
+#define LOG__FIRST(...) LOG__FIRST_(__VA_ARGS__, _)
+
+// ~geb: the argument list is handed down as `x , ## __VA_ARGS__`, which
+//       gcc, clang and msvc pass on unexpanded. Otherwise S("...")
+//       would turn into a compound literal, and its comma would be
+//       counted as an argument. x is any token ahead of the list
+//       (the level) and is dropped again. LOG__TYPE and LOG__ARG are
+//       variadic, so an argument that expands to commas reaches them
+//       whole.
+#define LOG__NARG_(x, fmt, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+#define LOG__NARG(x, ...) LOG__NARG_(x , ## __VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0, _)
+
+// ~geb: M(arg), for every argument after the format
+#define LOG__MAP0(M, fmt)
+#define LOG__MAP1(M, fmt, a)                      M(a),
+#define LOG__MAP2(M, fmt, a, b)                   M(a), M(b),
+#define LOG__MAP3(M, fmt, a, b, c)                M(a), M(b), M(c),
+#define LOG__MAP4(M, fmt, a, b, c, d)             M(a), M(b), M(c), M(d),
+#define LOG__MAP5(M, fmt, a, b, c, d, e)          M(a), M(b), M(c), M(d), M(e),
+#define LOG__MAP6(M, fmt, a, b, c, d, e, f)       M(a), M(b), M(c), M(d), M(e), M(f),
+#define LOG__MAP7(M, fmt, a, b, c, d, e, f, g)    M(a), M(b), M(c), M(d), M(e), M(f), M(g),
+#define LOG__MAP8(M, fmt, a, b, c, d, e, f, g, h) M(a), M(b), M(c), M(d), M(e), M(f), M(g), M(h),
+#define LOG__MAP(M, x, ...) LOG__CAT(LOG__MAP, LOG__NARG(x , ## __VA_ARGS__))(M , ## __VA_ARGS__)
+
+#define LOG__TYPE(...) _Generic((__VA_ARGS__),                              \
+	char: Log_Arg_I64, signed char: Log_Arg_I64, short: Log_Arg_I64,       \
+	int: Log_Arg_I64, long: Log_Arg_I64, long long: Log_Arg_I64,           \
+	unsigned char: Log_Arg_U64, unsigned short: Log_Arg_U64,               \
+	unsigned int: Log_Arg_U64, unsigned long: Log_Arg_U64,                 \
+	unsigned long long: Log_Arg_U64,                                       \
+	float: Log_Arg_F64, double: Log_Arg_F64,                               \
+	char *: Log_Arg_CString, const char *: Log_Arg_CString,                \
+	String8: Log_Arg_String8,                                              \
+	default: Log_Arg_Ptr)
+
+#define LOG__ARG(...) _Generic((__VA_ARGS__),                               \
+	char: log__arg_i64, signed char: log__arg_i64, short: log__arg_i64,    \
+	int: log__arg_i64, long: log__arg_i64, long long: log__arg_i64,        \
+	unsigned char: log__arg_u64, unsigned short: log__arg_u64,             \
+	unsigned int: log__arg_u64, unsigned long: log__arg_u64,               \
+	unsigned long long: log__arg_u64,                                      \
+	float: log__arg_f64, double: log__arg_f64,                             \
+	char *: log__arg_cstring, const char *: log__arg_cstring,              \
+	String8: log__arg_str8,                                                \
+	default: log__arg_ptr)(__VA_ARGS__)
+
+force_inline Log_Arg log__arg_i64(i64 x)             { Log_Arg a = { cast(u64)x, 0 }; return a; }
+force_inline Log_Arg log__arg_u64(u64 x)             { Log_Arg a = { x, 0 }; return a; }
+force_inline Log_Arg log__arg_f64(f64 x)             { Log_Arg a = { 0, 0 }; MemCopy(&a.value, &x, 8); return a; }
+force_inline Log_Arg log__arg_ptr(const void *x)     { Log_Arg a = { cast(u64)cast(usize)x, 0 }; return a; }
+force_inline Log_Arg log__arg_cstring(const char *x) { Log_Arg a = { cast(u64)cast(usize)x, x ? MemStrlen(x) : 0 }; return a; }
+force_inline Log_Arg log__arg_str8(String8 x)        { Log_Arg a = { cast(u64)cast(usize)x.str, x.len }; return a; }
+
+global u32 log_level;
+
+#define LOG__DEFERRED(lvl, ...) do {                                         \
+	local_persist Log_Site log__site = {                                   \
+		.fmt       = LOG__FIRST(__VA_ARGS__),                              \
+		.file      = __FILE__,                                             \
+		.line      = __LINE__,                                             \
+		.level     = (lvl),                                                \
+		.enabled   = true,                                                 \
+		.arg_count = LOG__NARG(lvl , ## __VA_ARGS__),                      \
+		.arg_types = { LOG__MAP(LOG__TYPE, lvl , ## __VA_ARGS__) Log_Arg_None }, \
+	};                                                                     \
+	if ((lvl) >= AtomicLoadU32(&log_level) && AtomicLoadU32(&log__site.enabled)) \
+		_log_deferred_write(&log__site, (Log_Arg[]){ LOG__MAP(LOG__ARG, lvl , ## __VA_ARGS__) {0} }); \
+} while (0)
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_DEBUG
+# define log_deferred_debug(...) LOG__DEFERRED(Log_Level_Debug , ## __VA_ARGS__)
+#else
+# define log_deferred_debug(...) ((void)0)
+#endif
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_INFO
+# define log_deferred_info(...)  LOG__DEFERRED(Log_Level_Info , ## __VA_ARGS__)
+#else
+# define log_deferred_info(...)  ((void)0)
+#endif
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_WARN
+# define log_deferred_warn(...)  LOG__DEFERRED(Log_Level_Warn , ## __VA_ARGS__)
+#else
+# define log_deferred_warn(...)  ((void)0)
+#endif
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_ERROR
+# define log_deferred_error(...) LOG__DEFERRED(Log_Level_Error , ## __VA_ARGS__)
+#else
+# define log_deferred_error(...) ((void)0)
+#endif
+
+///////////////////////////////////
+// ~geb: Profiler
+// Named zones recorded with their thread and nesting depth into a
+// ring per thread, the oldest zones are overwritten. Build with
+// PROF_ENABLED=1, otherwise the macros expand to nothing.
+// Prof_Scope ends its zone when the enclosing block exits.
+// Export while the profiled threads are quiet, zones that are
+// written during the export may come out torn.
+
+#ifndef PROF_ENABLED
+# define PROF_ENABLED 0
+#endif
+
+#define PROF_EVENTS_PER_THREAD 16384 // ~geb: power of two
+#define PROF_MAX_DEPTH         64
+
+typedef struct {
+	const char *name;
+	u64         start;
+	u64         duration;
+	u32         depth;
+} Prof_Event;
+
+typedef struct Prof_Thread {
+	struct Prof_Thread *next;
+	const char         *name;
+	u32                 id;
+	u32                 depth;
+	const char         *stack_names[PROF_MAX_DEPTH];
+	u64                 stack_starts[PROF_MAX_DEPTH];
+	u64                 write;
+	Prof_Event          events[PROF_EVENTS_PER_THREAD];
+} Prof_Thread;
+
+internal void prof_begin(const char *name); // ~geb: name must outlive the export
+internal void prof_end(void);
+internal void prof_set_thread_name(const char *name);
+internal void _prof_scope_end(u8 *scope);
+
+// ~geb: Chrome trace event JSON, open it in chrome://tracing or Perfetto
+internal bool prof_export_chrome(String8 path, Allocator scratch);
+
+#define PROF__CAT_(a, b) a##b
+#define PROF__CAT(a, b)  PROF__CAT_(a, b)
+
+#if PROF_ENABLED
+# define Prof_Begin(name) prof_begin(name)
+# define Prof_End()       prof_end()
+# if COMPILER_CLANG || COMPILER_GCC
+#  define Prof_Scope(name) \
+	u8 PROF__CAT(prof__scope_, __LINE__) __attribute__((cleanup(_prof_scope_end), unused)) = (prof_begin(name), 0)
+# else
+#  define Prof_Scope(name) // ~geb: needs the cleanup attribute
+# endif
+#else
+# define Prof_Begin(name) ((void)0)
+# define Prof_End()       ((void)0)
+# define Prof_Scope(name)
+#endif
+
+///////////////////////////////////
+// ~geb: Jobs
+// One worker per core, the thread that calls job_system_init is
+// worker 0 and only runs jobs while it waits, so there are always
+// at least two. Workers push to and
+// pop from the bottom of their own Chase-Lev deque and steal from
+// the top of the others'. Other threads submit through a shared
+// queue. A full queue runs the job inline instead of failing.
+// Every job gets the scratch allocator of the worker running it,
+// reset once the job returns. Waiting on a counter runs other jobs
+// until it drops to zero, so jobs may submit and wait on jobs.
+
+#define JOB_DEQUE_SIZE    4096 // ~geb: power of two
+#define JOB_SCRATCH_SIZE  Gb(1)
+#define JOB_MAX_WORKERS   256
+
+#define Job_Proc(name) void name(void *param, Allocator scratch)
+typedef Job_Proc(Job_Proc);
+
+typedef struct {
+	u32 pending; // ~geb: futex, jobs submitted against it still running
+} Job_Counter;
+
+internal bool job_system_init(u32 worker_count); // ~geb: 0 for os_core_count
+internal void job_system_shutdown(void);
+internal u32  job_worker_count(void);
+internal u32  job_worker_index(void);            // ~geb: U32_MAX off the workers
+
+internal void job_submit(Job_Proc *proc, void *param, Job_Counter *counter);
+internal void job_wait(Job_Counter *counter);
+
+///////////////////////////////////
+// ~geb: Parallel algorithms
+// Split [0, count) into chunks of grain elements and run the kernel
+// on the job system, one chunk range per call. grain 0 picks
+// count / PARALLEL_AUTO_CHUNKS but no less than PARALLEL_MIN_GRAIN.
+// Ranges are split in halves on demand, so idle workers steal big
+// pieces first. Everything runs serially on the caller when there is
+// no job system or only one chunk.
+// parallel_reduce starts every partial as a copy of *identity and
+// combines them into *result, which holds the seed going in. Per
+// worker partials are the cheapest but their order depends on
+// scheduling; deterministic keeps one partial per chunk and combines
+// them in chunk order, with or without the job system, so the result
+// only depends on count and grain. The two modes only agree with each
+// other when combine is associative.
+
+#define PARALLEL_MIN_GRAIN   1024
+#define PARALLEL_AUTO_CHUNKS 256
+
+#define Parallel_For_Proc(name)     void name(void *items, usize begin, usize end, void *param)
+#define Parallel_Reduce_Proc(name)  void name(void *items, usize begin, usize end, void *param, void *partial)
+#define Parallel_Combine_Proc(name) void name(void *into, void *from, void *param)
+typedef Parallel_For_Proc(Parallel_For_Proc);
+typedef Parallel_Reduce_Proc(Parallel_Reduce_Proc);
+typedef Parallel_Combine_Proc(Parallel_Combine_Proc);
+
+internal void parallel_for(void *items, usize count, usize grain, Parallel_For_Proc *proc, void *param);
+internal bool parallel_reduce(void *items, usize count, usize grain,
+                              Parallel_Reduce_Proc *proc, Parallel_Combine_Proc *combine, void *param,
+                              void *identity, void *result, usize result_size, bool deterministic);
+internal void parallel_for_array(Dynamic_Array *array, usize grain, Parallel_For_Proc *proc, void *param);
+internal bool parallel_reduce_array(Dynamic_Array *array, usize grain,
+                                    Parallel_Reduce_Proc *proc, Parallel_Combine_Proc *combine, void *param,
+                                    void *identity, void *result, usize result_size, bool deterministic);
+
+// ~geb: out[i] = in[0] + ... + in[i], or up to in[i - 1] when
+//       exclusive. in and out may be the same, returns the total
+internal u64 parallel_prefix_sum_u64(u64 *out, u64 *in, usize count, bool exclusive);
+
+///////////////////////////////////
+// ~geb: Queues
+// Bounded rings of fixed size items copied in and out, the storage
+// comes from the allocator passed to make and capacity is rounded
+// up to a power of two. Spsc_Queue is for exactly one producer and
+// one consumer thread, its push and pop are plain loads and stores
+// and move whole batches. Mpmc_Queue takes any number of both
+// (Vyukov's sequence numbered cells).
+// The _wait variants block on a futex when the queue is full or
+// empty, up to timeout_ns (OS_WAIT_INFINITE for no limit). Only
+// they wake the other side, a thread that blocks in pop_wait must
+// be fed with push_wait and the other way around.
+
+typedef struct {
+	u8   *data;
+	usize item_size;
+	u64   mask;
+	Allocator alloc;
+
+	u8    pad0[CACHE_LINE_SIZE];
+	u64   head;          // ~geb: written by the producer
+	u64   tail_cache;
+	u32   space_waiting; // ~geb: producer asleep on popped
+	u32   pushed;        // ~geb: futex the consumer sleeps on
+
+	u8    pad1[CACHE_LINE_SIZE];
+	u64   tail;          // ~geb: written by the consumer
+	u64   head_cache;
+	u32   items_waiting;
+	u32   popped;
+
+	u8    pad2[CACHE_LINE_SIZE];
+} Spsc_Queue;
+
+typedef struct {
+	u8   *cells;
+	usize cell_size;
+	usize item_size;
+	u64   mask;
+	Allocator alloc;
+
+	u8    pad0[CACHE_LINE_SIZE];
+	u64   enqueue;
+	u8    pad1[CACHE_LINE_SIZE - sizeof(u64)];
+	u64   dequeue;
+	u8    pad2[CACHE_LINE_SIZE - sizeof(u64)];
+	u32   pushed;        // ~geb: futexes and sleeper counts for the _wait variants
+	u32   push_waiters;
+	u32   popped;
+	u32   pop_waiters;
+	u8    pad3[CACHE_LINE_SIZE];
+} Mpmc_Queue;
+
+internal bool  spsc_queue_make(Spsc_Queue *queue, Allocator alloc, usize capacity, usize item_size);
+internal void  spsc_queue_delete(Spsc_Queue *queue);
+internal usize spsc_queue_push(Spsc_Queue *queue, void *items, usize count);
+internal usize spsc_queue_pop(Spsc_Queue *queue, void *out, usize max_count);
+internal usize spsc_queue_push_wait(Spsc_Queue *queue, void *items, usize count, u64 timeout_ns);
+internal usize spsc_queue_pop_wait(Spsc_Queue *queue, void *out, usize max_count, u64 timeout_ns);
+
+internal bool  mpmc_queue_make(Mpmc_Queue *queue, Allocator alloc, usize capacity, usize item_size);
+internal void  mpmc_queue_delete(Mpmc_Queue *queue);
+internal bool  mpmc_queue_push(Mpmc_Queue *queue, void *item);
+internal bool  mpmc_queue_pop(Mpmc_Queue *queue, void *out);
+internal bool  mpmc_queue_push_wait(Mpmc_Queue *queue, void *item, u64 timeout_ns);
+internal bool  mpmc_queue_pop_wait(Mpmc_Queue *queue, void *out, u64 timeout_ns);
+
+///////////////////////////////////
+// ~geb: Ring buffer
+// A byte ring on os_ring_map, so the unread bytes and the free space
+// are always one contiguous span no matter where they wrap. Hand
+// them out as String8s, fill and drain them straight from files,
+// then commit or consume what was used. One writer and one reader
+// may sit on different threads.
+
+typedef struct {
+	u8 *data;
+	u64 size;
+	u64 read;   // ~geb: total bytes consumed
+	u64 write;  // ~geb: total bytes committed
+} Ring_Buffer;
+
+internal Ring_Buffer ring_buffer_make(usize min_size);
+internal void        ring_buffer_delete(Ring_Buffer *ring);
+internal String8     ring_buffer_readable(Ring_Buffer *ring);
+internal String8     ring_buffer_writable(Ring_Buffer *ring);
+internal void        ring_buffer_commit(Ring_Buffer *ring, usize size);
+internal void        ring_buffer_consume(Ring_Buffer *ring, usize size);
+internal usize       ring_buffer_write(Ring_Buffer *ring, String8 data);
+internal usize       ring_buffer_read_file(Ring_Buffer *ring, OS_Handle file, usize offset);
+internal usize       ring_buffer_write_file(Ring_Buffer *ring, OS_Handle file, usize offset);
+
+///////////////////////////////////
+// ~geb: Timer wheel
+// Hierarchical hashed wheel over os_time_now time, TIMER_WHEEL_LEVELS
+// levels of 64 slots, each level 64 times coarser than the one
+// below. A timer sits at the level of the highest 6 bit digit where
+// its tick differs from the current tick and moves down a level
+// when the wheel reaches its slot, so adding and cancelling are
+// O(1) and advancing only touches occupied slots, found through a
+// bitmask per level. Timers fire on the first advance at or past
+// their deadline, rounded up to the resolution, never early.
+// Callbacks may add and cancel timers, including ones in the same
+// batch. Nodes come from the allocator in blocks and are recycled.
+// Handles go stale once the timer fired or was cancelled. Timers
+// further out than one lap of the top level wait there and are
+// placed again when the wheel comes round.
+
+#define TIMER_WHEEL_LEVELS  6 // ~geb: 2^36 ticks a lap, over two years at 1us
+#define TIMER_WHEEL_SLOTS   64
+#define TIMER_WHEEL_BLOCK   1024
+
+struct Timer_Wheel;
+typedef struct Timer_Node Timer_Node;
+#define Timer_Wheel_Proc(name) void name(struct Timer_Wheel *wheel, void *param)
+typedef Timer_Wheel_Proc(Timer_Wheel_Proc);
+
+typedef struct Timer_Link {
+	struct Timer_Link *next;
+	struct Timer_Link *prev;
+} Timer_Link;
+
+struct Timer_Node {
+	Timer_Link        link;   // ~geb: first, nodes are their links
+	u64               tick;
+	u64               generation;
+	Timer_Wheel_Proc *proc;
+	void             *param;
+	u16               slot;   // ~geb: level * 64 + slot, TIMER_WHEEL_FIRING in a batch
+};
+
+typedef struct {
+	Timer_Node *node;
+	u64         generation;
+} Timer_Handle;
+
+typedef struct Timer_Wheel {
+	Allocator     alloc;
+	OS_Time_Stamp origin;
+	u64           resolution;
+	u64           tick;       // ~geb: next tick to process
+	u64           count;
+	u64           occupied[TIMER_WHEEL_LEVELS];
+	Timer_Link    slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+	Timer_Node   *free_nodes;
+	void         *blocks;     // ~geb: node blocks, linked through their first word
+} Timer_Wheel;
+
+internal void          timer_wheel_make(Timer_Wheel *wheel, Allocator alloc, u64 resolution_ns, OS_Time_Stamp now);
+internal void          timer_wheel_delete(Timer_Wheel *wheel);
+internal Timer_Handle  timer_wheel_add(Timer_Wheel *wheel, OS_Time_Stamp deadline, Timer_Wheel_Proc *proc, void *param);
+internal bool          timer_wheel_cancel(Timer_Wheel *wheel, Timer_Handle handle);
+internal u64           timer_wheel_advance(Timer_Wheel *wheel, OS_Time_Stamp now);
+// ~geb: when the next advance can have work, 0 when empty. May come
+//       early for far timers, which only move down a level then
+internal OS_Time_Stamp timer_wheel_next_deadline(Timer_Wheel *wheel);
+
+///////////////////////////////////
+// ~geb: Fibers
+// Stackful coroutines with a hand written context switch, on x64
+// and arm64 with gcc or clang. Every fiber gets its own mapping
+// with a guard page under the stack, pages are only backed once
+// touched, so a 64Kb stack costs what it uses. fiber_resume runs a
+// fiber until it yields or returns, fibers may resume other fibers.
+// A Fiber_Scheduler runs fibers round robin on the calling thread.
+// Inside it fiber_wait_io and fiber_sleep_ns park the fiber and let
+// the others run, outside one they simply block the thread. Parked
+// fibers sit on the scheduler's event loop and timer wheel, so a lap
+// only pays for the fibers that woke up. Fibers waiting on the same
+// handle share one watch with their interests merged, each wakes for
+// its own direction. Handles epoll cannot watch (regular files) are
+// polled once instead of parking. Timeouts and sleeps are rounded
+// up to FIBER_TIMER_RESOLUTION. Finished fibers keep their mapping
+// for the next spawn, up to FIBER_POOL_MAX per scheduler.
+
+#if (ARCH_X64 || ARCH_ARM64) && (COMPILER_GCC || COMPILER_CLANG)
+# define FIBER_SUPPORTED 1
+#else
+# define FIBER_SUPPORTED 0
+#endif
+
+// ~geb: the guard splits every stack into two kernel mappings and
+//       vm.max_map_count (65530 by default) then caps a process at
+//       about 32k fibers, build with FIBER_GUARD_PAGE=0 to go past it
+#ifndef FIBER_GUARD_PAGE
+# define FIBER_GUARD_PAGE 1
+#endif
+
+#define FIBER_DEFAULT_STACK    Kb(64)
+#define FIBER_POOL_MAX         64
+#define FIBER_IO_HANDLES       64      // ~geb: initial handle table capacity
+#define FIBER_TIMER_RESOLUTION 1000000 // ~geb: 1ms, epoll_wait times no finer
+
+#define Fiber_Proc(name) void name(void *param)
+typedef Fiber_Proc(Fiber_Proc);
+
+typedef struct Fiber {
+	void         *sp;
+	void         *caller_sp;
+	u8           *mapping;
+	usize         mapping_size;
+	Fiber_Proc   *proc;
+	void         *param;
+	bool          done;
+
+	// ~geb: scheduler state
+	struct Fiber_Scheduler *scheduler;
+	struct Fiber *next;
+	struct Fiber *prev;          // ~geb: parked list only
+	struct Fiber *wait_next;     // ~geb: waiters on the same handle
+	OS_Handle     wait_handle;
+	OS_IoFlags    wait_events;   // ~geb: 0 when not waiting on a handle
+	Timer_Handle  wait_timer;
+	OS_IoFlags    wait_ready;
+	bool          waiting;
+} Fiber;
+
+typedef struct {
+	OS_Watch   *watch;
+	Fiber      *waiters;
+	OS_IoFlags  events;  // ~geb: what the watch asks for now
+} Fiber_Io;
+
+typedef struct Fiber_Scheduler {
+	Fiber        *ready_first;
+	Fiber        *ready_last;
+	Fiber        *parked;
+	Fiber        *pool;
+	u32           pooled;
+	u32           live;
+	usize         stack_size;
+	OS_Event_Loop loop;
+	Timer_Wheel   timers;
+	Dynamic_Array io;      // ~geb: Fiber_Io, indexed by handle
+} Fiber_Scheduler;
+
+internal Fiber     *fiber_create(Fiber_Proc *proc, void *param, usize stack_size);
+internal void       fiber_delete(Fiber *fiber);
+internal bool       fiber_resume(Fiber *fiber); // ~geb: false once it has returned
+internal void       fiber_yield(void);
+internal Fiber     *fiber_current(void);
+
+internal bool       fiber_scheduler_make(Fiber_Scheduler *scheduler, Allocator alloc, usize stack_size);
+internal void       fiber_scheduler_delete(Fiber_Scheduler *scheduler);
+internal bool       fiber_spawn(Fiber_Scheduler *scheduler, Fiber_Proc *proc, void *param);
+internal void       fiber_scheduler_run(Fiber_Scheduler *scheduler);
+internal OS_IoFlags fiber_wait_io(OS_Handle handle, OS_IoFlags events, u64 timeout_ns);
+internal void       fiber_sleep_ns(u64 ns);
+
+///////////////////////////////////
+// ~geb: IPC channel
+// Messages between processes through shared memory: a header page
+// and a data ring mapped twice back to back like Ring_Buffer, so
+// every message is one contiguous span. One process makes the
+// channel and passes it to the others over a Unix socket with
+// ipc_channel_send_handle. Any number of processes may send and one
+// receives. Senders reserve space, fill it in place and commit, the
+// receiver gets String8 views straight into the ring that stay valid
+// until it releases them, nothing is copied on the way. Messages
+// arrive in reservation order, so a sender that never commits stalls
+// the ones behind it. Both sides spin briefly and then sleep on
+// futexes in the header page, only when the ring is full or empty.
+
+typedef struct {
+	u64 magic;
+	u64 size;
+	u8  pad0[CACHE_LINE_SIZE - 2 * sizeof(u64)];
+	u64 reserve;          // ~geb: senders claim space here
+	u8  pad1[CACHE_LINE_SIZE - sizeof(u64)];
+	u64 read;             // ~geb: written by the receiver on release
+	u8  pad2[CACHE_LINE_SIZE - sizeof(u64)];
+	u32 committed;        // ~geb: futexes and sleeper counts
+	u32 receive_waiting;
+	u32 released;
+	u32 send_waiting;
+} Ipc_Shared;
+
+// ~geb: precedes every message, stamp is its ring position with
+//       IPC_RECORD_READY set once committed
+typedef struct {
+	u64 stamp;
+	u64 size;
+} Ipc_Record;
+
+#define IPC_RECORD_READY (1ull << 63)
+
+typedef struct {
+	Ipc_Shared *shared;
+	u8         *data;
+	u64         size;
+	OS_Handle   handle;
+	u64         next;     // ~geb: receiver, end of the last message handed out
+} Ipc_Channel;
+
+internal Ipc_Channel ipc_channel_make(usize min_size);
+// ~geb: takes over handle, closed again when it isn't a channel
+internal Ipc_Channel ipc_channel_open(OS_Handle handle);
+internal void        ipc_channel_close(Ipc_Channel *channel);
+internal bool        ipc_channel_send_handle(Ipc_Channel *channel, OS_Handle socket);
+internal Ipc_Channel ipc_channel_receive_handle(OS_Handle socket);
+
+// ~geb: empty when size doesn't fit the ring or on timeout
+internal String8 ipc_channel_reserve(Ipc_Channel *channel, usize size, u64 timeout_ns);
+internal void    ipc_channel_commit(Ipc_Channel *channel, String8 message);
+internal bool    ipc_channel_send(Ipc_Channel *channel, String8 data, u64 timeout_ns);
+// ~geb: str is 0 on timeout, messages may be empty
+internal String8 ipc_channel_receive(Ipc_Channel *channel, u64 timeout_ns);
+// ~geb: hands back the space of every message received so far
+internal void    ipc_channel_release(Ipc_Channel *channel);
+
 #endif
@@ -76,6 +76,86 @@ os_release(void *ptr, usize size)
 	munmap(ptr, size);
 }
 
+internal usize
+os_page_size(void)
+{
+	long size = sysconf(_SC_PAGESIZE);
+	return size > 0 ? (usize)size : Kb(4);
+}
+
+internal void *
+os_ring_map(usize size)
+{
+	OS_Handle handle = os_shared_memory_make(size);
+	if (!handle)
+		return 0;
+
+	// ~geb: the mappings keep the pages alive
+	void *base = os_shared_ring_map(handle, 0, size);
+	os_file_close(handle);
+	return base;
+}
+
+internal void
+os_ring_unmap(void *base, usize size)
+{
+	os_shared_ring_unmap(base, 0, size);
+}
+
+internal OS_Handle
+os_shared_memory_make(usize size)
+{
+	int fd = memfd_create("shared", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (fd <= 0)
+		return 0;
+
+	if (ftruncate(fd, (off_t)size) != 0 ||
+	    fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0)
+	{
+		close(fd);
+		return 0;
+	}
+	return (OS_Handle)fd;
+}
+
+internal void *
+os_shared_ring_map(OS_Handle handle, usize header_size, usize ring_size)
+{
+	usize page = os_page_size();
+	if (ring_size == 0 || ring_size % page != 0 || header_size % page != 0 ||
+	    ring_size > (USIZE_MAX - header_size) / 2)
+		return 0;
+
+	struct stat st;
+	int seals = fcntl((int)handle, F_GET_SEALS);
+	if (seals < 0 || !(seals & F_SEAL_SHRINK) ||
+	    fstat((int)handle, &st) != 0 || (u64)st.st_size < header_size + ring_size)
+		return 0;
+
+	// ~geb: reserve everything first so nothing else lands between
+	usize total = header_size + 2 * ring_size;
+	u8 *base = mmap(0, total, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (base == MAP_FAILED)
+		return 0;
+
+	u8 *ring = base + header_size;
+	if ((header_size && mmap(base, header_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, (int)handle, 0) == MAP_FAILED) ||
+	    mmap(ring,             ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, (int)handle, (off_t)header_size) == MAP_FAILED ||
+	    mmap(ring + ring_size, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, (int)handle, (off_t)header_size) == MAP_FAILED)
+	{
+		munmap(base, total);
+		return 0;
+	}
+	return base;
+}
+
+internal void
+os_shared_ring_unmap(void *base, usize header_size, usize ring_size)
+{
+	if (base)
+		munmap(base, header_size + 2 * ring_size);
+}
+
 ///////////////////////
 // ~geb: time
 
@@ -96,16 +176,298 @@ os_time_frequency(void)
 	return 1000000000ULL;
 }
 
+internal void
+os_sleep_until_ns(OS_Time_Stamp deadline)
+{
+	struct timespec ts;
+	ts.tv_sec  = deadline / 1000000000ULL;
+	ts.tv_nsec = deadline % 1000000000ULL;
+
+	// ~geb: absolute, so restarting after a signal does not drift
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, 0) == EINTR) {
+	}
+}
+
 internal void
 os_sleep_ns(u64 ns)
+{
+	os_sleep_until_ns(os_time_now() + ns);
+}
+
+internal bool
+os_set_timer_slack_ns(u64 ns)
+{
+	return prctl(PR_SET_TIMERSLACK, (unsigned long)ns, 0, 0, 0) == 0;
+}
+
+internal u64
+os_timer_slack_ns(void)
+{
+	int slack = prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0);
+	return slack < 0 ? 0 : (u64)slack;
+}
+
+///////////////////////
+// ~geb: threads
+
+typedef struct {
+	OS_Thread_Proc *proc;
+	void           *param;
+} OS_Linx_Thread_Start;
+
+internal void *
+os_linx_thread_entry(void *param)
+{
+	OS_Linx_Thread_Start start = *(OS_Linx_Thread_Start *)param;
+	free(param);
+
+	start.proc(start.param);
+	return 0;
+}
+
+internal OS_Thread
+os_thread_create(OS_Thread_Proc *proc, void *param)
+{
+	OS_Linx_Thread_Start *start = malloc(sizeof(*start));
+	if (!start)
+		return 0;
+
+	start->proc  = proc;
+	start->param = param;
+
+	pthread_t thread;
+	if (pthread_create(&thread, 0, os_linx_thread_entry, start) != 0)
+	{
+		free(start);
+		return 0;
+	}
+
+	return (OS_Thread)thread;
+}
+
+internal void
+os_thread_join(OS_Thread thread)
+{
+	if (thread == 0)
+		return;
+
+	pthread_join((pthread_t)thread, 0);
+}
+
+internal u32
+os_thread_id(void)
+{
+	return (u32)syscall(SYS_gettid);
+}
+
+internal OS_Thread
+os_thread_self(void)
+{
+	return (OS_Thread)pthread_self();
+}
+
+internal void
+os_thread_yield(void)
+{
+	sched_yield();
+}
+
+internal bool
+os_thread_set_affinity(OS_Thread thread, u32 core)
+{
+	if (thread == 0 || core >= CPU_SETSIZE)
+		return false;
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(core, &set);
+	return pthread_setaffinity_np((pthread_t)thread, sizeof(set), &set) == 0;
+}
+
+internal u32
+os_core_count(void)
+{
+	cpu_set_t set;
+	if (sched_getaffinity(0, sizeof(set), &set) == 0)
+		return (u32)CPU_COUNT(&set);
+
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (u32)count : 1;
+}
+
+///////////////////////
+// ~geb: futex
+
+internal bool
+os_futex_wait(u32 *addr, u32 expected, u64 timeout_ns)
+{
+	struct timespec ts;
+	struct timespec *timeout = 0;
+	if (timeout_ns != OS_WAIT_INFINITE)
+	{
+		ts.tv_sec  = timeout_ns / 1000000000ULL;
+		ts.tv_nsec = timeout_ns % 1000000000ULL;
+		timeout    = &ts;
+	}
+
+	// ~geb: EAGAIN (value changed) and EINTR count as a wake
+	long r = syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, expected, timeout, 0, 0);
+	return !(r == -1 && errno == ETIMEDOUT);
+}
+
+internal void
+os_futex_wake(u32 *addr, u32 count)
+{
+	int n = count > INT32_MAX ? INT32_MAX : (int)count;
+	syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, n, 0, 0, 0);
+}
+
+internal bool
+os_futex_wait_shared(u32 *addr, u32 expected, u64 timeout_ns)
 {
 	struct timespec ts;
-	ts.tv_sec  = ns / 1000000000ULL;
-	ts.tv_nsec = ns % 1000000000ULL;
+	struct timespec *timeout = 0;
+	if (timeout_ns != OS_WAIT_INFINITE)
+	{
+		ts.tv_sec  = timeout_ns / 1000000000ULL;
+		ts.tv_nsec = timeout_ns % 1000000000ULL;
+		timeout    = &ts;
+	}
+
+	// ~geb: not private, the kernel keys the wait on the page
+	//       instead of this process' address
+	long r = syscall(SYS_futex, addr, FUTEX_WAIT, expected, timeout, 0, 0);
+	return !(r == -1 && errno == ETIMEDOUT);
+}
+
+internal void
+os_futex_wake_shared(u32 *addr, u32 count)
+{
+	int n = count > INT32_MAX ? INT32_MAX : (int)count;
+	syscall(SYS_futex, addr, FUTEX_WAKE, n, 0, 0, 0);
+}
+
+///////////////////////
+// ~geb: hardware counters
+
+internal OS_Perf_Group
+os_perf_open(u32 counter_mask)
+{
+	local_persist const struct { u32 type; u64 config; } events[OS_Perf_Count] = {
+		[OS_Perf_Cycles]          = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+		[OS_Perf_Instructions]    = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+		[OS_Perf_CacheReferences] = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES },
+		[OS_Perf_CacheMisses]     = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+		[OS_Perf_BranchMisses]    = { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+		[OS_Perf_PageFaults]      = { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+	};
+
+	OS_Perf_Group group = {0};
+	group.leader = -1;
+	for (u32 i = 0; i < OS_Perf_Count; ++i)
+		group.fds[i] = -1;
+
+	for (u32 i = 0; i < OS_Perf_Count; ++i)
+	{
+		if (!(counter_mask & Bit(i)))
+			continue;
+
+		struct perf_event_attr attr = {0};
+		attr.size           = sizeof(attr);
+		attr.type           = events[i].type;
+		attr.config         = events[i].config;
+		attr.disabled       = group.leader < 0;  // ~geb: members follow the leader
+		attr.exclude_kernel = 1;
+		attr.exclude_hv     = 1;
+		attr.read_format    = PERF_FORMAT_GROUP |
+		                      PERF_FORMAT_TOTAL_TIME_ENABLED |
+		                      PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, group.leader, PERF_FLAG_FD_CLOEXEC);
+		if (fd < 0)
+			continue;
+
+		if (group.leader < 0)
+			group.leader = fd;
+		group.fds[i]               = fd;
+		group.order[group.count++] = (u8)i;
+		group.mask                |= Bit(i);
+	}
+
+	return group;
+}
+
+internal void
+os_perf_close(OS_Perf_Group *group)
+{
+	for (u32 i = 0; i < OS_Perf_Count; ++i)
+	{
+		if (group->fds[i] >= 0)
+			close(group->fds[i]);
+		group->fds[i] = -1;
+	}
+
+	group->leader = -1;
+	group->mask   = 0;
+	group->count  = 0;
+}
+
+internal void
+os_perf_start(OS_Perf_Group *group)
+{
+	if (group->leader < 0)
+		return;
+
+	ioctl(group->leader, PERF_EVENT_IOC_RESET,  PERF_IOC_FLAG_GROUP);
+	ioctl(group->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+internal void
+os_perf_stop(OS_Perf_Group *group)
+{
+	if (group->leader < 0)
+		return;
+
+	ioctl(group->leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+}
+
+internal OS_Perf_Sample
+os_perf_read(OS_Perf_Group *group)
+{
+	OS_Perf_Sample sample = {0};
+	if (group->leader < 0)
+		return sample;
+
+	// ~geb: nr, time_enabled, time_running, then one value per slot
+	u64 data[3 + OS_Perf_Count];
+	ssize_t r = read(group->leader, data, sizeof(data));
+	if (r < (ssize_t)(3 * sizeof(u64)))
+		return sample;
+
+	u64 nr = Min(data[0], (u64)group->count);
+	if ((usize)r < (3 + nr) * sizeof(u64))
+		return sample;
+
+	sample.time_enabled = data[1];
+	sample.time_running = data[2];
+
+	// ~geb: the group never ran (e.g. too few PMU slots), the zeros are
+	//       not counts so no slot is marked valid
+	if (sample.time_running == 0)
+		return sample;
 
-	while (nanosleep(&ts, &ts) == -1 && errno == EINTR) {
-		// continue sleeping remaining duration
+	sample.mask = group->mask;
+
+	f64 scale = (f64)sample.time_enabled / (f64)sample.time_running;
+	for (u64 i = 0; i < nr; ++i)
+	{
+		u64 value = data[3 + i];
+		if (sample.time_running < sample.time_enabled)
+			value = (u64)((f64)value * scale);
+		sample.values[group->order[i]] = value;
 	}
+
+	return sample;
 }
 
 ///////////////////////
@@ -137,6 +499,9 @@ os_file_open(OS_AccesFlags flags, String8 path, Allocator temp_alloc)
 	if (flags & OS_AccessFlag_Append)
 		lnx_flags |= O_APPEND;
 
+	if (flags & OS_AccessFlag_Truncate)
+		lnx_flags |= O_TRUNC;
+
 	if (flags & (OS_AccessFlag_Write | OS_AccessFlag_Append))
 		lnx_flags |= O_CREAT;
 
@@ -174,17 +539,28 @@ os_file_read(OS_Handle file, usize begin, usize end, void *out_data)
 	usize remaining = end - begin;
 	usize total = 0;
 
+	// ~geb: pipes and sockets have no offset, they take plain reads
+	//       and return what has arrived instead of waiting for all
+	bool positional = true;
+
 	while (remaining > 0)
 	{
-		ssize_t r = pread(fd,
-					dst + total,
-					remaining,
-					begin + total);
+		ssize_t r = positional
+			? pread(fd, dst + total, remaining, begin + total)
+			: read(fd, dst + total, remaining);
+
+		if (r < 0 && errno == ESPIPE && positional)
+		{
+			positional = false;
+			continue;
+		}
 
 		if (r > 0)
 		{
 			total += (usize)r;
 			remaining -= (usize)r;
+			if (!positional)
+				break;
 		}
 		else if (r == 0)
 		{
@@ -211,12 +587,20 @@ os_file_write(OS_Handle file, usize begin, usize end, void *data)
 	usize remaining = end - begin;
 	usize total = 0;
 
+	// ~geb: pipes and terminals have no offset, they take plain writes
+	bool positional = true;
+
 	while (remaining > 0)
 	{
-		ssize_t w = pwrite(fd,
-					 src + total,
-					 remaining,
-					 begin + total);
+		ssize_t w = positional
+			? pwrite(fd, src + total, remaining, begin + total)
+			: write(fd, src + total, remaining);
+
+		if (w < 0 && errno == ESPIPE && positional)
+		{
+			positional = false;
+			continue;
+		}
 
 		if (w > 0)
 		{
@@ -248,3 +632,708 @@ os_properties_from_file(OS_Handle file)
 
 	return os_linx_file_props_from_stats(&st);
 }
+
+internal bool
+os_file_set_size(OS_Handle file, usize size)
+{
+	if (file == 0)
+		return false;
+
+	int r;
+	do r = ftruncate((int)file, (off_t)size);
+	while (r != 0 && errno == EINTR);
+	return r == 0;
+}
+
+internal bool
+os_file_same(OS_Handle a, OS_Handle b)
+{
+	struct stat sa, sb;
+	if (a == 0 || b == 0 || fstat((int)a, &sa) != 0 || fstat((int)b, &sb) != 0)
+		return false;
+	return sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+}
+
+///////////////////////
+// ~geb: copying
+
+// ~geb: each way below copies until it finished or failed, the next
+//       one carries on from wherever it stopped. done is set once
+//       size bytes moved or src ran out
+
+internal usize
+os_linx_copy_file_range(int dst, u64 dst_offset, int src, u64 src_offset, usize size, bool *done)
+{
+	usize total = 0;
+	while (total < size)
+	{
+		loff_t in  = (loff_t)(src_offset + total);
+		loff_t out = (loff_t)(dst_offset + total);
+		ssize_t r = copy_file_range(src, &in, dst, &out, size - total, 0);
+		if (r > 0)
+			total += (usize)r;
+		else if (r == 0)
+			break;
+		else if (errno != EINTR)
+			return total;
+	}
+	*done = true;
+	return total;
+}
+
+internal usize
+os_linx_sendfile(int dst, u64 dst_offset, bool dst_seekable, int src, u64 src_offset, usize size, bool *done)
+{
+	// ~geb: sendfile writes at the file position of dst
+	if (dst_seekable && lseek(dst, (off_t)dst_offset, SEEK_SET) < 0)
+		return 0;
+
+	usize total = 0;
+	while (total < size)
+	{
+		off_t in = (off_t)(src_offset + total);
+		ssize_t r = sendfile(dst, src, &in, size - total);
+		if (r > 0)
+			total += (usize)r;
+		else if (r == 0)
+			break;
+		else if (errno != EINTR)
+			return total;
+	}
+	*done = true;
+	return total;
+}
+
+internal usize
+os_linx_splice(int dst, u64 dst_offset, bool dst_seekable, int src, u64 src_offset, bool src_seekable, usize size, bool *done)
+{
+	struct stat st;
+	bool src_pipe = fstat(src, &st) == 0 && S_ISFIFO(st.st_mode);
+	bool dst_pipe = fstat(dst, &st) == 0 && S_ISFIFO(st.st_mode);
+
+	// ~geb: splice needs a pipe on one side, go through one of our
+	//       own when neither is
+	int pipe_fds[2] = { -1, -1 };
+	if (!src_pipe && !dst_pipe && pipe2(pipe_fds, O_CLOEXEC) != 0)
+		return 0;
+
+	usize total = 0;
+	bool  ok    = true;
+	while (total < size)
+	{
+		loff_t in  = (loff_t)(src_offset + total);
+		loff_t out = (loff_t)(dst_offset + total);
+		loff_t *in_offset  = src_seekable ? &in  : 0;
+		loff_t *out_offset = dst_seekable ? &out : 0;
+
+		ssize_t r;
+		if (pipe_fds[0] < 0)
+		{
+			r = splice(src, in_offset, dst, out_offset, size - total, SPLICE_F_MOVE);
+		}
+		else
+		{
+			r = splice(src, in_offset, pipe_fds[1], 0, size - total, SPLICE_F_MOVE);
+			for (ssize_t left = r; left > 0 && ok;)
+			{
+				ssize_t w = splice(pipe_fds[0], 0, dst, out_offset, (usize)left, SPLICE_F_MOVE);
+				if (w > 0)
+					left -= w;
+				else if (!(w < 0 && errno == EINTR))
+					ok = false;
+			}
+		}
+
+		if (r > 0 && ok)
+			total += (usize)r;
+		else if (r == 0)
+			break;
+		else if (!ok || errno != EINTR)
+		{
+			ok = false;
+			break;
+		}
+	}
+
+	if (pipe_fds[0] >= 0)
+	{
+		close(pipe_fds[0]);
+		close(pipe_fds[1]);
+	}
+
+	*done = ok;
+	return total;
+}
+
+internal usize
+os_copy_range(OS_Handle dst, usize dst_offset, OS_Handle src, usize src_offset, usize size)
+{
+	if (dst == 0 || src == 0 || size == 0)
+		return 0;
+
+	bool src_seekable = lseek((int)src, 0, SEEK_CUR) >= 0;
+	bool dst_seekable = lseek((int)dst, 0, SEEK_CUR) >= 0;
+
+	// ~geb: copy_file_range stays in the filesystem and may just share
+	//       extents, sendfile reads from the page cache of a file,
+	//       splice moves pages through a pipe
+	usize total = 0;
+	bool  done  = false;
+	if (src_seekable && dst_seekable)
+		total += os_linx_copy_file_range((int)dst, dst_offset, (int)src, src_offset, size, &done);
+	if (!done && src_seekable)
+		total += os_linx_sendfile((int)dst, dst_offset + total, dst_seekable, (int)src, src_offset + total, size - total, &done);
+	if (!done)
+		total += os_linx_splice((int)dst, dst_offset + total, dst_seekable, (int)src, src_offset + total, src_seekable, size - total, &done);
+
+	// ~geb: whatever is left goes through a buffer
+	u8 buffer[Kb(64)];
+	while (!done && total < size)
+	{
+		usize chunk = Min(size - total, sizeof(buffer));
+		usize read  = os_file_read(src, src_offset + total, src_offset + total + chunk, buffer);
+		if (!read)
+			break;
+
+		usize written = os_file_write(dst, dst_offset + total, dst_offset + total + read, buffer);
+		total += written;
+		if (written != read)
+			break;
+	}
+	return total;
+}
+
+///////////////////////
+// ~geb: polling
+
+internal u32
+os_poll(OS_Poll_Entry *entries, u32 count, u64 timeout_ns)
+{
+	struct pollfd  local[64];
+	struct pollfd *fds = local;
+	if (count > ArrayCount(local))
+	{
+		fds = malloc(count * sizeof(*fds));
+		if (!fds)
+			return 0;
+	}
+
+	for (u32 i = 0; i < count; ++i)
+	{
+		fds[i].fd      = (int)entries[i].handle;
+		fds[i].events  = (short)(((entries[i].events & OS_IoFlag_Read)  ? POLLIN  : 0) |
+		                         ((entries[i].events & OS_IoFlag_Write) ? POLLOUT : 0));
+		fds[i].revents = 0;
+	}
+
+	struct timespec ts;
+	struct timespec *timeout = 0;
+	if (timeout_ns != OS_WAIT_INFINITE)
+	{
+		ts.tv_sec  = timeout_ns / 1000000000ULL;
+		ts.tv_nsec = timeout_ns % 1000000000ULL;
+		timeout    = &ts;
+	}
+
+	int r = ppoll(fds, count, timeout, 0);
+	u32 ready = 0;
+	for (u32 i = 0; i < count; ++i)
+	{
+		short revents = r > 0 ? fds[i].revents : 0;
+		entries[i].ready = ((revents & POLLIN)              ? OS_IoFlag_Read   : 0) |
+		                   ((revents & POLLOUT)             ? OS_IoFlag_Write  : 0) |
+		                   ((revents & (POLLERR | POLLNVAL)) ? OS_IoFlag_Error  : 0) |
+		                   ((revents & POLLHUP)             ? OS_IoFlag_HangUp : 0);
+		ready += entries[i].ready != 0;
+	}
+
+	if (fds != local)
+		free(fds);
+	return ready;
+}
+
+internal bool
+os_handle_set_nonblocking(OS_Handle handle, bool nonblocking)
+{
+	int flags = fcntl((int)handle, F_GETFL);
+	if (flags < 0)
+		return false;
+
+	flags = nonblocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+	return fcntl((int)handle, F_SETFL, flags) == 0;
+}
+
+///////////////////////
+// ~geb: sockets
+
+internal bool
+os_socket_pair(OS_Handle out[2])
+{
+	int fds[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+		return false;
+
+	out[0] = (OS_Handle)fds[0];
+	out[1] = (OS_Handle)fds[1];
+	return true;
+}
+
+internal bool
+os_handle_send(OS_Handle socket, OS_Handle handle)
+{
+	// ~geb: SCM_RIGHTS needs at least one byte of real data to ride on
+	u8 byte = 0;
+	struct iovec iov = { .iov_base = &byte, .iov_len = 1 };
+
+	union {
+		struct cmsghdr header;
+		u8             buffer[CMSG_SPACE(sizeof(int))];
+	} control;
+	MemZeroStruct(&control);
+
+	struct msghdr msg = {0};
+	msg.msg_iov        = &iov;
+	msg.msg_iovlen     = 1;
+	msg.msg_control    = control.buffer;
+	msg.msg_controllen = sizeof(control.buffer);
+
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type  = SCM_RIGHTS;
+	cmsg->cmsg_len   = CMSG_LEN(sizeof(int));
+	int fd = (int)handle;
+	MemCopy(CMSG_DATA(cmsg), &fd, sizeof(fd));
+
+	ssize_t sent;
+	do sent = sendmsg((int)socket, &msg, MSG_NOSIGNAL);
+	while (sent < 0 && errno == EINTR);
+	return sent == 1;
+}
+
+internal OS_Handle
+os_handle_receive(OS_Handle socket)
+{
+	u8 byte;
+	struct iovec iov = { .iov_base = &byte, .iov_len = 1 };
+
+	union {
+		struct cmsghdr header;
+		u8             buffer[CMSG_SPACE(sizeof(int))];
+	} control;
+
+	struct msghdr msg = {0};
+	msg.msg_iov        = &iov;
+	msg.msg_iovlen     = 1;
+	msg.msg_control    = control.buffer;
+	msg.msg_controllen = sizeof(control.buffer);
+
+	ssize_t received;
+	do received = recvmsg((int)socket, &msg, MSG_CMSG_CLOEXEC);
+	while (received < 0 && errno == EINTR);
+	if (received != 1)
+		return 0;
+
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS ||
+	    cmsg->cmsg_len != CMSG_LEN(sizeof(int)))
+		return 0;
+
+	int fd;
+	MemCopy(&fd, CMSG_DATA(cmsg), sizeof(fd));
+	return fd > 0 ? (OS_Handle)fd : 0;
+}
+
+///////////////////////
+// ~geb: event loop
+
+internal u32
+os_linx_epoll_events(OS_IoFlags events)
+{
+	return ((events & OS_IoFlag_Read)  ? EPOLLIN | EPOLLRDHUP : 0) |
+	       ((events & OS_IoFlag_Write) ? EPOLLOUT : 0) |
+	       ((events & OS_IoFlag_Edge)  ? EPOLLET  : 0);
+}
+
+internal bool
+os_event_loop_make(OS_Event_Loop *loop, Allocator alloc)
+{
+	MemZeroStruct(loop);
+	loop->alloc           = alloc;
+	loop->timers          = dynamic_array(alloc, OS_Timer, OS_EVENT_LOOP_TIMERS);
+	loop->timer_slots     = dynamic_array(alloc, OS_Timer_Slot, OS_EVENT_LOOP_TIMERS);
+	loop->free_timer_slot = U32_MAX;
+	loop->next_timer      = 1;
+	loop->poller          = epoll_create1(EPOLL_CLOEXEC);
+	loop->timer_handle    = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+	loop->wake_handle     = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+	// ~geb: an arena cannot grow an array from nothing, so the timer
+	//       arrays need their first block here
+	bool ok = loop->timers.data && loop->timer_slots.data &&
+	          loop->poller >= 0 && loop->timer_handle >= 0 && loop->wake_handle >= 0;
+	if (ok)
+	{
+		// ~geb: the two internal handles are told apart by a null ptr
+		//       and a null-ptr-plus-one
+		struct epoll_event timer = { .events = EPOLLIN, .data.ptr = 0 };
+		struct epoll_event wake  = { .events = EPOLLIN, .data.u64 = 1 };
+		ok = epoll_ctl(loop->poller, EPOLL_CTL_ADD, loop->timer_handle, &timer) == 0 &&
+		     epoll_ctl(loop->poller, EPOLL_CTL_ADD, loop->wake_handle,  &wake)  == 0;
+	}
+
+	if (!ok)
+		os_event_loop_delete(loop);
+	return ok;
+}
+
+internal void
+_os_event_loop_free_watches(OS_Event_Loop *loop, OS_Watch *list)
+{
+	while (list)
+	{
+		OS_Watch *next = list->next;
+		mem_free(loop->alloc, list, NULL);
+		list = next;
+	}
+}
+
+internal void
+os_event_loop_delete(OS_Event_Loop *loop)
+{
+	if (loop->poller > 0)
+		close(loop->poller);
+	if (loop->timer_handle > 0)
+		close(loop->timer_handle);
+	if (loop->wake_handle > 0)
+		close(loop->wake_handle);
+
+	_os_event_loop_free_watches(loop, loop->free_watches);
+	_os_event_loop_free_watches(loop, loop->dead_watches);
+	dynamic_array_delete(&loop->timers);
+	dynamic_array_delete(&loop->timer_slots);
+	MemZeroStruct(loop);
+}
+
+internal OS_Watch *
+os_event_loop_watch(OS_Event_Loop *loop, OS_Handle handle, OS_IoFlags events, OS_Watch_Proc *proc, void *param)
+{
+	OS_Watch *watch = loop->free_watches;
+	if (watch)
+		loop->free_watches = watch->next;
+	else
+		watch = alloc(loop->alloc, OS_Watch, NULL);
+	if (!watch)
+		return 0;
+
+	MemZeroStruct(watch);
+	watch->handle = handle;
+	watch->proc   = proc;
+	watch->param  = param;
+
+	struct epoll_event event = { .events = os_linx_epoll_events(events), .data.ptr = watch };
+	if (epoll_ctl(loop->poller, EPOLL_CTL_ADD, (int)handle, &event) != 0)
+	{
+		watch->next = loop->free_watches;
+		loop->free_watches = watch;
+		return 0;
+	}
+	return watch;
+}
+
+internal bool
+os_event_loop_modify(OS_Event_Loop *loop, OS_Watch *watch, OS_IoFlags events)
+{
+	struct epoll_event event = { .events = os_linx_epoll_events(events), .data.ptr = watch };
+	return epoll_ctl(loop->poller, EPOLL_CTL_MOD, (int)watch->handle, &event) == 0;
+}
+
+internal void
+os_event_loop_unwatch(OS_Event_Loop *loop, OS_Watch *watch)
+{
+	if (!watch || watch->dead)
+		return;
+
+	epoll_ctl(loop->poller, EPOLL_CTL_DEL, (int)watch->handle, 0);
+
+	// ~geb: the current batch may still point at it, recycle after
+	watch->dead = true;
+	watch->next = loop->dead_watches;
+	loop->dead_watches = watch;
+}
+
+// ~geb: timer heap, every move writes the new index to the slot
+
+internal void
+_os_timer_set(OS_Event_Loop *loop, usize i)
+{
+	OS_Timer      *timers = cast(OS_Timer *)loop->timers.data;
+	OS_Timer_Slot *slots  = cast(OS_Timer_Slot *)loop->timer_slots.data;
+	slots[cast(u32)timers[i].id].index = cast(u32)i;
+}
+
+internal void
+_os_timer_swap(OS_Event_Loop *loop, usize a, usize b)
+{
+	OS_Timer *timers = cast(OS_Timer *)loop->timers.data;
+	OS_Timer  t = timers[a];
+	timers[a]   = timers[b];
+	timers[b]   = t;
+	_os_timer_set(loop, a);
+	_os_timer_set(loop, b);
+}
+
+internal void
+_os_timer_sift_up(OS_Event_Loop *loop, usize i)
+{
+	OS_Timer *timers = cast(OS_Timer *)loop->timers.data;
+	while (i > 0)
+	{
+		usize parent = (i - 1) / 2;
+		if (timers[parent].deadline <= timers[i].deadline)
+			break;
+		_os_timer_swap(loop, parent, i);
+		i = parent;
+	}
+}
+
+internal void
+_os_timer_sift_down(OS_Event_Loop *loop, usize i)
+{
+	OS_Timer *timers = cast(OS_Timer *)loop->timers.data;
+	usize     count  = loop->timers.len;
+	for (;;)
+	{
+		usize left     = 2 * i + 1;
+		usize smallest = i;
+		if (left < count && timers[left].deadline < timers[smallest].deadline)
+			smallest = left;
+		if (left + 1 < count && timers[left + 1].deadline < timers[smallest].deadline)
+			smallest = left + 1;
+		if (smallest == i)
+			break;
+		_os_timer_swap(loop, smallest, i);
+		i = smallest;
+	}
+}
+
+internal void
+_os_timer_remove(OS_Event_Loop *loop, usize i)
+{
+	OS_Timer      *timers = cast(OS_Timer *)loop->timers.data;
+	OS_Timer_Slot *slots  = cast(OS_Timer_Slot *)loop->timer_slots.data;
+
+	// ~geb: a new generation makes the old id stale
+	u32 slot = cast(u32)timers[i].id;
+	slots[slot].generation = Max(slots[slot].generation + 1, 1);
+	slots[slot].index      = loop->free_timer_slot;
+	loop->free_timer_slot  = slot;
+
+	loop->timers.len -= 1;
+	if (i == loop->timers.len)
+		return;
+
+	timers[i] = timers[loop->timers.len];
+	_os_timer_set(loop, i);
+	_os_timer_sift_down(loop, i);
+	_os_timer_sift_up(loop, i);
+}
+
+// ~geb: points the timerfd at the earliest deadline, only when it moved
+internal void
+_os_event_loop_arm(OS_Event_Loop *loop)
+{
+	OS_Time_Stamp deadline = loop->timers.len ? (cast(OS_Timer *)loop->timers.data)[0].deadline : 0;
+	if (deadline == loop->armed)
+		return;
+
+	struct itimerspec spec = {0};
+	spec.it_value.tv_sec  = deadline / 1000000000ULL;
+	spec.it_value.tv_nsec = deadline % 1000000000ULL;
+	timerfd_settime(loop->timer_handle, TFD_TIMER_ABSTIME, &spec, 0);
+	loop->armed = deadline;
+}
+
+internal u64
+os_event_loop_timer(OS_Event_Loop *loop, u64 delay_ns, u64 period_ns, OS_Timer_Proc *proc, void *param)
+{
+	if (!dynamic_array_reserve(&loop->timers, sizeof(OS_Timer), AlignOf(OS_Timer), loop->timers.len + 1))
+		return 0;
+
+	u32 slot = loop->free_timer_slot;
+	if (slot != U32_MAX)
+	{
+		loop->free_timer_slot = (cast(OS_Timer_Slot *)loop->timer_slots.data)[slot].index;
+	}
+	else
+	{
+		usize count = loop->timer_slots.len;
+		if (count >= U32_MAX)
+			return 0;
+		dyn_arr_append(&loop->timer_slots, OS_Timer_Slot, ((OS_Timer_Slot){ 0, 1 }));
+		if (loop->timer_slots.len == count)
+			return 0;
+		slot = cast(u32)count;
+	}
+
+	// ~geb: a zero deadline would disarm the timerfd
+	OS_Timer_Slot *entry = &(cast(OS_Timer_Slot *)loop->timer_slots.data)[slot];
+	OS_Timer timer = {
+		Max(os_time_now() + delay_ns, 1), period_ns,
+		(cast(u64)entry->generation << 32) | slot, loop->next_timer,
+		proc, param,
+	};
+
+	usize len = loop->timers.len;
+	(cast(OS_Timer *)loop->timers.data)[len] = timer;
+	loop->timers.len = len + 1;
+	entry->index     = cast(u32)len;
+
+	loop->next_timer += 1;
+	_os_timer_sift_up(loop, len);
+	_os_event_loop_arm(loop);
+	return timer.id;
+}
+
+internal bool
+os_event_loop_cancel(OS_Event_Loop *loop, u64 timer)
+{
+	u32 slot = cast(u32)timer;
+	if (slot >= loop->timer_slots.len)
+		return false;
+
+	OS_Timer_Slot entry  = (cast(OS_Timer_Slot *)loop->timer_slots.data)[slot];
+	OS_Timer     *timers = cast(OS_Timer *)loop->timers.data;
+	if (entry.generation != cast(u32)(timer >> 32) ||
+	    entry.index >= loop->timers.len || timers[entry.index].id != timer)
+		return false;
+
+	_os_timer_remove(loop, entry.index);
+	_os_event_loop_arm(loop);
+	return true;
+}
+
+internal u32
+_os_event_loop_fire_timers(OS_Event_Loop *loop)
+{
+	u64 expirations;
+	while (read((int)loop->timer_handle, &expirations, sizeof(expirations)) > 0)
+	{
+	}
+
+	// ~geb: timers added by callbacks wait for the next round, so a
+	//       zero delay timer cannot starve the handles
+	u64 last_sequence = loop->next_timer;
+	OS_Time_Stamp now = os_time_now();
+	u32 fired = 0;
+	while (loop->timers.len)
+	{
+		OS_Timer *timers = cast(OS_Timer *)loop->timers.data;
+		OS_Timer  timer  = timers[0];
+		if (timer.deadline > now || timer.sequence >= last_sequence)
+			break;
+
+		if (timer.period)
+		{
+			// ~geb: keep the phase, skip periods we slept through
+			u64 missed = (now - timer.deadline) / timer.period + 1;
+			timers[0].deadline += missed * timer.period;
+			_os_timer_sift_down(loop, 0);
+		}
+		else
+		{
+			_os_timer_remove(loop, 0);
+		}
+
+		timer.proc(loop, timer.id, timer.param);
+		fired += 1;
+	}
+
+	loop->armed = 0;
+	_os_event_loop_arm(loop);
+	return fired;
+}
+
+internal u32
+os_event_loop_run_once(OS_Event_Loop *loop, u64 timeout_ns)
+{
+	struct epoll_event events[OS_EVENT_LOOP_BATCH];
+
+	// ~geb: the timerfd does the precise timing, epoll only needs a
+	//       millisecond timeout for the caller's limit
+	int timeout_ms = -1;
+	if (timeout_ns != OS_WAIT_INFINITE)
+		timeout_ms = (int)Min((timeout_ns + 999999) / 1000000, (u64)INT32_MAX);
+
+	int count = epoll_wait(loop->poller, events, OS_EVENT_LOOP_BATCH, timeout_ms);
+	if (count < 0)
+		return 0;
+
+	u32  dispatched = 0;
+	bool timers_due = false;
+	for (int i = 0; i < count; ++i)
+	{
+		if (events[i].data.u64 == 0)
+		{
+			timers_due = true;
+			continue;
+		}
+		if (events[i].data.u64 == 1)
+		{
+			u64 value;
+			while (read((int)loop->wake_handle, &value, sizeof(value)) > 0)
+			{
+			}
+			continue;
+		}
+
+		OS_Watch *watch = cast(OS_Watch *)events[i].data.ptr;
+		if (watch->dead)
+			continue;
+
+		u32 e = events[i].events;
+		OS_IoFlags ready = ((e & EPOLLIN)                ? OS_IoFlag_Read   : 0) |
+		                   ((e & EPOLLOUT)               ? OS_IoFlag_Write  : 0) |
+		                   ((e & EPOLLERR)               ? OS_IoFlag_Error  : 0) |
+		                   ((e & (EPOLLHUP | EPOLLRDHUP)) ? OS_IoFlag_HangUp : 0);
+		watch->proc(loop, watch->handle, ready, watch->param);
+		dispatched += 1;
+	}
+
+	if (timers_due)
+		dispatched += _os_event_loop_fire_timers(loop);
+
+	if (loop->dead_watches)
+	{
+		OS_Watch *last = loop->dead_watches;
+		while (last->next)
+			last = last->next;
+		last->next         = loop->free_watches;
+		loop->free_watches = loop->dead_watches;
+		loop->dead_watches = 0;
+	}
+
+	return dispatched;
+}
+
+internal void
+os_event_loop_run(OS_Event_Loop *loop)
+{
+	AtomicStoreU32(&loop->running, 1);
+	while (AtomicLoadU32(&loop->running))
+		os_event_loop_run_once(loop, OS_WAIT_INFINITE);
+}
+
+internal void
+os_event_loop_stop(OS_Event_Loop *loop)
+{
+	AtomicStoreU32(&loop->running, 0);
+	os_event_loop_wake(loop);
+}
+
+internal void
+os_event_loop_wake(OS_Event_Loop *loop)
+{
+	u64 one = 1;
+	ssize_t r = write((int)loop->wake_handle, &one, sizeof(one));
+	(void)r;
+}
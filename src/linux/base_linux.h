@@ -7,6 +7,20 @@
 #include <sys/stat.h>
 #include <sys/mman.h>
 #include <errno.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <sched.h>
+#include <linux/futex.h>
+#include <sys/ioctl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <linux/perf_event.h>
 
 #include "../base.h"
 